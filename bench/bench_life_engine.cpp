@@ -0,0 +1,345 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "engine/fixed_engine.h"
+#include "engine/hashlife.h"
+#include "engine/life_engine.h"
+#include "engine/sparse_engine.h"
+#include "prog_opts/prog_opts.h"
+
+namespace {
+
+using grid_t = life::engine::grid_t;
+
+struct bench_result final
+{
+    std::string engine;
+    std::string pattern;
+    size_t size;
+    uint64_t generations;
+    double seconds;
+};
+
+std::vector<std::string> split(const std::string& s, const char delimiter)
+{
+    std::vector<std::string> out_str;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, delimiter)) {
+        if (! item.empty()) {
+            out_str.emplace_back(item);
+        }
+    }
+    return out_str;
+}
+
+/// Parses a comma separated list of positive board sizes.
+bool parse_sizes(const std::string& text, std::vector<size_t>& sizes)
+{
+    sizes.clear();
+    for (const std::string& item : split(text, ',')) {
+        // Nine digits at most, stoul can not overflow.
+        if ((item.size() > 9) || (item.find_first_not_of("0123456789") != std::string::npos)) {
+            return false;
+        }
+        sizes.push_back(std::stoul(item));
+        if (sizes.back() == 0) {
+            return false;
+        }
+    }
+    return ! sizes.empty();
+}
+
+bool make_pattern(const std::string& pattern, const size_t size, const double density, grid_t& grid)
+{
+    grid.assign(size, life::engine::row_t(size, false));
+    if (pattern == "empty") {
+        return true;
+    }
+    if (pattern == "dense") {
+        for (life::engine::row_t& row : grid) {
+            row.assign(size, true);
+        }
+        return true;
+    }
+    if (pattern == "glider") {
+        // The pattern of examples/glider.
+        const std::vector<std::string> glider = {"0010",
+                                                 "0001",
+                                                 "0111"};
+        for (size_t r = 0; r < std::min(glider.size(), size); ++r) {
+            for (size_t c = 0; c < std::min(glider[r].size(), size); ++c) {
+                grid[r][c] = (glider[r][c] == '1');
+            }
+        }
+        return true;
+    }
+    if (pattern == "soup") {
+        std::mt19937_64 gen(size);
+        std::bernoulli_distribution alive(density);
+        for (life::engine::row_t& row : grid) {
+            for (size_t c = 0; c < size; ++c) {
+                row[c] = alive(gen);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+struct bench_limits final
+{
+    double min_seconds;
+    uint64_t max_generations;
+};
+
+/*
+ * Runs batches of doubling size until the minimal time passes. HashLife
+ * gets faster with every batch once patterns are memoized, so the number
+ * of generations is capped as well.
+ */
+template<typename TEngine>
+bench_result measure(TEngine& gl, const grid_t& begin, const bench_limits& limits)
+{
+    using clock_t = std::chrono::steady_clock;
+
+    gl.start(begin);
+    gl.step_n(1);
+
+    bench_result res = {};
+    uint64_t batch = 1;
+    const clock_t::time_point begin_time = clock_t::now();
+    while ((res.seconds < limits.min_seconds) && (res.generations < limits.max_generations)) {
+        batch = std::min(batch, limits.max_generations - res.generations);
+        gl.step_n(batch);
+        res.generations += batch;
+        batch *= 2;
+        res.seconds = std::chrono::duration<double>(clock_t::now() - begin_time).count();
+    }
+    return res;
+}
+
+/// The fixed engine is built only for the board sizes listed here.
+template<size_t TSize, size_t... TOthers>
+bool measure_fixed(const grid_t& begin, const bench_limits& limits, bench_result& res)
+{
+    if (begin.size() == TSize) {
+        life::fixed_engine<TSize, TSize> gl;
+        res = measure(gl, begin, limits);
+        return true;
+    }
+    if constexpr (sizeof...(TOthers) != 0) {
+        return measure_fixed<TOthers...>(begin, limits, res);
+    }
+    return false;
+}
+
+bool run(const std::string& engine, const grid_t& begin, const size_t threads, const size_t block_depth,
+         const bench_limits& limits, bench_result& res)
+{
+    const size_t size = begin.size();
+    if (engine == "fixed") {
+        if (! measure_fixed<8, 16, 32, 64>(begin, limits, res)) {
+            return false;
+        }
+    } else if (engine == "sparse") {
+        life::sparse_engine gl(size, size);
+        res = measure(gl, begin, limits);
+    } else if (engine == "hashlife") {
+        life::hashlife gl(size, size);
+        res = measure(gl, begin, limits);
+    } else if (engine.rfind("packed", 0) == 0) {
+        life::engine gl(size, size);
+        gl.set_thread_count(threads);
+        if (engine == "packed-blocked") {
+            gl.set_temporal_blocking(block_depth);
+        } else if (engine != "packed") {
+            const std::string isa_name = engine.substr(std::string("packed-").size());
+            bool is_set = false;
+            if (isa_name == life::kernel::kind_name(life::kernel::kind_t::table)) {
+                gl.set_kernel(life::kernel::kind_t::table);
+                is_set = true;
+            }
+            for (const life::kernel::isa_t isa : {life::kernel::isa_t::scalar, life::kernel::isa_t::avx2,
+                                                  life::kernel::isa_t::avx512}) {
+                if (isa_name == life::kernel::isa_name(isa)) {
+                    is_set = gl.set_isa(isa);
+                }
+            }
+            if (! is_set) {
+                return false;
+            }
+        }
+        res = measure(gl, begin, limits);
+    } else {
+        return false;
+    }
+
+    res.engine = engine;
+    res.size = size;
+    return true;
+}
+
+void print_json(std::ostream& out, const std::vector<bench_result>& results, const size_t threads,
+                const size_t block_depth, const double density, const bench_limits& limits)
+{
+    out << std::setprecision(6);
+    out << "{" << std::endl
+        << "  \"benchmark\": \"life_engine\"," << std::endl
+        << "  \"best_isa\": \"" << life::kernel::isa_name(life::kernel::best_isa()) << "\"," << std::endl
+        << "  \"threads\": " << threads << "," << std::endl
+        << "  \"block_depth\": " << block_depth << "," << std::endl
+        << "  \"density\": " << density << "," << std::endl
+        << "  \"min_time_s\": " << limits.min_seconds << "," << std::endl
+        << "  \"max_generations\": " << limits.max_generations << "," << std::endl
+        << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const bench_result& res = results[i];
+        const double cells = (double)res.size * (double)res.size * (double)res.generations;
+        out << ((i == 0) ? "" : ",") << std::endl
+            << "    {\"engine\": \"" << res.engine << "\", \"pattern\": \"" << res.pattern << "\", "
+            << "\"rows\": " << res.size << ", \"cols\": " << res.size << ", "
+            << "\"generations\": " << res.generations << ", \"seconds\": " << res.seconds << ", "
+            << "\"ns_per_generation\": " << (res.seconds * 1e9 / (double)res.generations) << ", "
+            << "\"cell_updates_per_second\": " << (cells / res.seconds) << "}";
+    }
+    out << std::endl << "  ]" << std::endl << "}" << std::endl;
+}
+
+} // <anonymous> namespace
+
+int main(int argc, char* argv[])
+{
+    po::prog_opts po;
+    po.insert<std::string>("-s,--sizes", "64,256,1024,4096", "Comma separated board sizes. (default '64,256,1024,4096')");
+    po.insert("-l,--large", false,
+              "Add the 8192, 16384 and 32768 board sizes, larger than the caches; best with the packed engines, "
+              "which need 256 MiB for the largest board.");
+    po.insert<std::string>("-p,--patterns", "soup,glider,dense,empty",
+                           "Comma separated patterns: soup, glider, dense, empty. (default all)");
+    po.insert<std::string>("-e,--engines", "packed,sparse,hashlife",
+                           "Comma separated engines: packed, packed-scalar, packed-avx2, packed-avx512, packed-table, "
+                           "packed-blocked (temporal blocking), fixed (sizes 8, 16, 32 and 64), sparse, hashlife. "
+                           "(default 'packed,sparse,hashlife')");
+    po.insert<double>("-d,--density", 0.35, "Alive cells ratio of random soups. (default 0.35)");
+    po.insert<int>("-t,--threads", 1, "Stepping threads count of the packed engine, 0 - all CPUs. (default 1)");
+    po.insert<int>("-b,--block-depth", 8, "Generations per pass of the packed-blocked engine. (default 8)");
+    po.insert<double>("-m,--min-time", 0.5, "Minimal measurement time in seconds. (default 0.5)");
+    po.insert<int>("-g,--max-generations", 1000000, "Maximal generations per measurement. (default 1000000)");
+    po.insert<std::string>("-o,--output", "Output JSON file. (default stdout)");
+    po.insert("-h,--help", false, "Print this message.");
+
+    if (po.has_error()) {
+        std::cerr << po.error_msg() << std::endl;
+        std::cout << po.usage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (! po.parse(argc, argv)) {
+        std::cerr << po.error_msg() << std::endl;
+        std::cout << po.usage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (po.value<bool>("--help")) {
+        std::cout << po.usage() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    const double density = po.value<double>("--density");
+    if (! ((density >= 0.0) && (density <= 1.0))) {
+        std::cerr << "Invalid density '" << po.value<double>("--density") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const bench_limits limits = {po.value<double>("--min-time"), (uint64_t)po.value<int>("--max-generations")};
+    const int threads = po.value<int>("--threads");
+    if (threads < 0) {
+        std::cerr << "Invalid threads count '" << threads << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int block_depth = po.value<int>("--block-depth");
+    if ((block_depth < 2) || (block_depth > (int)life::engine::max_block_depth)) {
+        std::cerr << "Invalid block depth '" << block_depth << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (po.value<int>("--max-generations") < 1) {
+        std::cerr << "Invalid max generations '" << po.value<int>("--max-generations") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<size_t> sizes;
+    if (! parse_sizes(po.value<std::string>("--sizes"), sizes)) {
+        std::cerr << "Invalid sizes '" << po.value<std::string>("--sizes") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (po.value<bool>("--large")) {
+        sizes.insert(sizes.end(), {8192, 16384, 32768});
+    }
+
+    std::vector<bench_result> results;
+    for (const size_t size : sizes) {
+        for (const std::string& pattern : split(po.value<std::string>("--patterns"), ',')) {
+            grid_t begin;
+            if (! make_pattern(pattern, size, density, begin)) {
+                std::cerr << "Unsupported pattern '" << pattern << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            for (const std::string& engine : split(po.value<std::string>("--engines"), ',')) {
+                bench_result res;
+                if (! run(engine, begin, threads, (size_t)block_depth, limits, res)) {
+                    std::cerr << "Skip unsupported engine '" << engine << "'" << std::endl;
+                    continue;
+                }
+                res.pattern = pattern;
+                std::cerr << engine << " " << pattern << " " << size << "x" << size << ": "
+                          << (res.seconds * 1e9 / (double)res.generations) << " ns/generation" << std::endl;
+                results.emplace_back(res);
+            }
+        }
+    }
+
+    if (po.has_value("--output")) {
+        std::ofstream out(po.value<std::string>("--output"));
+        if (! out.is_open()) {
+            std::cerr << "Can not open output file '" << po.value<std::string>("--output") << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        print_json(out, results, threads, (size_t)block_depth, density, limits);
+    } else {
+        print_json(std::cout, results, threads, (size_t)block_depth, density, limits);
+    }
+
+    return EXIT_SUCCESS;
+}
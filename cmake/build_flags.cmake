@@ -94,9 +94,9 @@ endmacro()
 
 # Try set linker flag.
 macro(try_set_linker_flag PROP FLAG)
-    # Check it with the C compiler
+    # Check it with the C++ compiler, the project does not enable C
     set(CMAKE_REQUIRED_FLAGS ${FLAG})
-    check_C_compiler_flag(${FLAG} FLAG_${PROP})
+    check_cxx_compiler_flag(${FLAG} FLAG_${PROP})
     set(CMAKE_REQUIRED_FLAGS "")
     if(FLAG_${PROP})
         set_linker_flag(${FLAG})
@@ -131,6 +131,9 @@ macro(LibTarget TARGET_NAME)
                               PROPERTIES
                                   INCLUDE_DIRECTORIES ${PROJECT_SOURCE_DIR}/${${TARGET_NAME}_INCLUDE_DIR}
         )
+        foreach(lib IN LISTS ${TARGET_NAME}_LIBRARIES)
+            target_link_libraries(${TARGET_NAME} ${lib})
+        endforeach()
     else()
         message(ERROR "[ERROR] Unsupported library type")
     endif()
@@ -138,7 +141,7 @@ macro(LibTarget TARGET_NAME)
     install(TARGETS ${TARGET_NAME} LIBRARY DESTINATION libs)
 endmacro()
 
-macro(ExeTarget TARGET_NAME)
+macro(_exe_target TARGET_NAME DESTINATION)
     _parse_target_args(${TARGET_NAME} _EXE_TARGET_KW ${ARGN})
 
     add_executable(${TARGET_NAME} ${${TARGET_NAME}_HEADERS}
@@ -147,11 +150,24 @@ macro(ExeTarget TARGET_NAME)
     foreach(lib IN LISTS ${TARGET_NAME}_LIBRARIES)
         target_link_libraries(${TARGET_NAME} ${lib})
 
+        get_target_property(target_type ${lib} TYPE)
+        if(target_type STREQUAL "INTERFACE_LIBRARY")
+            continue()
+        endif()
+
         get_target_property(LIB_INCLUDE_DIR ${lib} INCLUDE_DIRECTORIES)
         target_include_directories(${TARGET_NAME} PRIVATE ${LIB_INCLUDE_DIR})
     endforeach()
 
-    install(TARGETS ${TARGET_NAME} RUNTIME DESTINATION bin)
+    install(TARGETS ${TARGET_NAME} RUNTIME DESTINATION ${DESTINATION})
+endmacro()
+
+macro(ExeTarget TARGET_NAME)
+    _exe_target(${TARGET_NAME} bin ${ARGN})
+endmacro()
+
+macro(BenchTarget TARGET_NAME)
+    _exe_target(${TARGET_NAME} bench ${ARGN})
 endmacro()
 
 macro(TestTarget TARGET_NAME)
@@ -0,0 +1,96 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "cluster/channel.h"
+
+namespace cluster {
+
+channel::channel(const int fd)
+    : m_fd(fd)
+{}
+
+channel::channel(channel&& other)
+    : m_fd(other.m_fd)
+{
+    other.m_fd = -1;
+}
+
+channel& channel::operator=(channel&& other)
+{
+    if (this != &other) {
+        close();
+        m_fd = other.m_fd;
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+channel::~channel()
+{
+    close();
+}
+
+void channel::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool channel::receive(void* p_data, const size_t size) const
+{
+    char* p = static_cast<char*>(p_data);
+    for (size_t done = 0; done < size; ) {
+        const ssize_t count = ::recv(m_fd, p + done, size - done, 0);
+        if (count > 0) {
+            done += count;
+        } else if ((count == 0) || (errno != EINTR)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool channel::send(const void* p_data, const size_t size) const
+{
+    // A peer that is gone is an error, not a SIGPIPE.
+    const char* p = static_cast<const char*>(p_data);
+    for (size_t done = 0; done < size; ) {
+        const ssize_t count = ::send(m_fd, p + done, size - done, MSG_NOSIGNAL);
+        if (count >= 0) {
+            done += count;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace cluster
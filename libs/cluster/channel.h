@@ -0,0 +1,76 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CLUSTER_CHANNEL_H
+#define CLUSTER_CHANNEL_H
+
+#include <cstddef>
+
+namespace cluster {
+
+/**
+ * \brief   Owner of a connected stream socket that sends and receives
+ *          whole messages.
+ *
+ * Unix sockets join the coordinator and the workers of one host; a TCP
+ * socket works the same way.
+ */
+class channel final
+{
+public:
+    explicit channel(const int fd = -1);
+
+    channel(const channel&) = delete;
+    channel& operator=(const channel&) = delete;
+
+    channel(channel&& other);
+    channel& operator=(channel&& other);
+
+    ~channel();
+
+    void close();
+
+    int fd() const { return m_fd; }
+
+    bool is_open() const { return m_fd >= 0; }
+
+    /// Reads exactly 'size' bytes, false on errors or the end of the stream.
+    bool receive(void* p_data, const size_t size) const;
+
+    /// Writes all bytes, false on errors or a closed peer.
+    bool send(const void* p_data, const size_t size) const;
+
+    template<typename TType>
+    bool receive(TType& value) const { return receive(&value, sizeof(value)); }
+
+    template<typename TType>
+    bool send(const TType& value) const { return send(&value, sizeof(value)); }
+
+private:
+    int m_fd;
+};
+
+} // namespace cluster
+
+#endif // CLUSTER_CHANNEL_H
@@ -0,0 +1,254 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cluster/coordinator.h"
+
+namespace cluster {
+namespace {
+
+using word_t = life::bit_grid::word_t;
+
+constexpr size_t word_bits = life::bit_grid::word_bits;
+
+/// ORs a row of 'words' words in at column 'col' of the board row.
+void paste_row(const word_t* p_src, const size_t words, word_t* p_row, const size_t col)
+{
+    word_t* p_dst = p_row + col / word_bits;
+    const size_t shift = col % word_bits;
+    for (size_t w = 0; w < words; ++w) {
+        p_dst[w] |= p_src[w] << shift;
+        if (shift != 0) {
+            p_dst[w + 1] |= p_src[w] >> (word_bits - shift);
+        }
+    }
+}
+
+} // <anonymous> namespace
+
+coordinator::coordinator(const size_t row_count, const size_t col_count, const size_t band_rows,
+                         const size_t band_cols)
+    : m_row_count(row_count)
+    , m_col_count(col_count)
+    , m_band_rows(band_rows)
+    , m_band_cols(band_cols)
+    , m_boundary(life::boundary::boundary_t::dead)
+    , m_generation(0)
+{}
+
+coordinator::~coordinator()
+{
+    stop();
+}
+
+bool coordinator::broadcast(const worker::command_t kind, const uint64_t value, std::vector<uint64_t>& values)
+{
+    if (m_channels.empty()) {
+        return fail(m_error.empty() ? "workers are not started" : m_error);
+    }
+
+    worker::command cmd;
+    cmd.kind = kind;
+    cmd.value = value;
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        if (! m_channels[i].send(cmd)) {
+            return fail("lost worker " + std::to_string(i));
+        }
+    }
+    values.resize(m_channels.size());
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        worker::reply r;
+        if (! m_channels[i].receive(r)) {
+            return fail("lost worker " + std::to_string(i));
+        }
+        if (r.is_ok == 0) {
+            return fail("worker " + std::to_string(i) + " failed");
+        }
+        values[i] = r.value;
+    }
+    return true;
+}
+
+bool coordinator::fail(const std::string& msg)
+{
+    if (m_error.empty()) {
+        m_error = msg;
+    }
+    stop();
+    return false;
+}
+
+bool coordinator::population(uint64_t& count)
+{
+    std::vector<uint64_t> populations;
+    if (! broadcast(worker::command_t::population, 0, populations)) {
+        return false;
+    }
+    count = 0;
+    for (const uint64_t p : populations) {
+        count += p;
+    }
+    return true;
+}
+
+bool coordinator::set_boundary(const life::boundary::boundary_t boundary)
+{
+    if ((boundary != life::boundary::boundary_t::dead) && (boundary != life::boundary::boundary_t::torus)) {
+        return false;
+    }
+    m_boundary = boundary;
+    return true;
+}
+
+bool coordinator::snapshot(life::bit_grid& grid)
+{
+    // Workers answer one by one, each reply is followed by its rows.
+    if (m_channels.empty()) {
+        return fail(m_error.empty() ? "workers are not started" : m_error);
+    }
+    grid.resize(m_row_count, m_col_count);
+    std::vector<word_t> row;
+    worker::command cmd;
+    cmd.kind = worker::command_t::snapshot;
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        const layout::area a = m_layout.subdomain(i);
+        const size_t words = (a.col_count + word_bits - 1) / word_bits;
+        worker::reply r;
+        if (! m_channels[i].send(cmd) || ! m_channels[i].receive(r) || (r.is_ok == 0)
+            || (r.value != a.row_count * words)) {
+            return fail("could not gather the snapshot of worker " + std::to_string(i));
+        }
+        row.resize(words);
+        for (size_t k = 0; k < a.row_count; ++k) {
+            if (! m_channels[i].receive(row.data(), words * sizeof(word_t))) {
+                return fail("could not gather the snapshot of worker " + std::to_string(i));
+            }
+            paste_row(row.data(), words, grid.row_ptr(a.row_begin + k), a.col_begin);
+        }
+    }
+    return true;
+}
+
+bool coordinator::start(const life::bit_grid& begin_state)
+{
+    stop();
+    m_error.clear();
+    m_generation = 0;
+    if ((m_band_rows == 0) || (m_band_cols == 0) || (m_band_rows > m_row_count) || (m_band_cols > m_col_count)) {
+        return fail("can not split a " + std::to_string(m_row_count) + "x" + std::to_string(m_col_count)
+                    + " board into " + std::to_string(m_band_rows) + "x" + std::to_string(m_band_cols)
+                    + " subdomains");
+    }
+
+    // The board as the workers see it, of the coordinator size.
+    life::bit_grid board(m_row_count, m_col_count);
+    const size_t row_count = std::min(begin_state.row_count(), m_row_count);
+    const size_t words = std::min(begin_state.words(), board.words());
+    for (size_t r = 0; r < row_count; ++r) {
+        std::copy_n(begin_state.row_ptr(r), words, board.row_ptr(r));
+        board.row_ptr(r)[board.words() - 1] &= board.last_word_mask();
+    }
+
+    m_layout = layout(m_row_count, m_col_count, m_band_rows, m_band_cols,
+                      m_boundary == life::boundary::boundary_t::torus);
+    if (! m_segment.create(shm_transport::segment_size(m_layout))) {
+        return fail(m_segment.error_msg());
+    }
+    shm_transport::reset(m_segment.data(), m_layout);
+
+    for (size_t i = 0; i < worker_count(); ++i) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            return fail("could not create a socket pair");
+        }
+        const pid_t pid = fork();
+        if (pid < 0) {
+            ::close(fds[0]);
+            ::close(fds[1]);
+            return fail("could not fork worker " + std::to_string(i));
+        }
+        if (pid == 0) {
+            // The worker keeps its own end of the socket only.
+            for (channel& ch : m_channels) {
+                ch.close();
+            }
+            ::close(fds[0]);
+            const channel ch(fds[1]);
+            shm_transport t(m_segment.data(), m_layout, i);
+            worker w(m_layout, i, t);
+            w.set_rule(m_rule);
+            w.start(board);
+            const bool is_ok = w.serve(ch);
+            if (! is_ok) {
+                shm_transport::abort(m_segment.data());
+            }
+            _exit(is_ok ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        ::close(fds[1]);
+        m_channels.emplace_back(fds[0]);
+        m_pids.push_back(pid);
+    }
+    return true;
+}
+
+bool coordinator::step_n(const uint64_t generations)
+{
+    std::vector<uint64_t> generation;
+    if (! broadcast(worker::command_t::step, generations, generation)) {
+        return false;
+    }
+    m_generation += generations;
+    return true;
+}
+
+void coordinator::stop()
+{
+    // Workers stuck in an exchange are aborted, the others stop on the
+    // command or on the closed socket.
+    if (m_segment.data() != nullptr) {
+        shm_transport::abort(m_segment.data());
+    }
+    worker::command cmd;
+    cmd.kind = worker::command_t::stop;
+    for (channel& ch : m_channels) {
+        ch.send(cmd);
+        ch.close();
+    }
+    for (const pid_t pid : m_pids) {
+        while ((waitpid(pid, nullptr, 0) < 0) && (errno == EINTR)) {
+        }
+    }
+    m_channels.clear();
+    m_pids.clear();
+    m_segment.close();
+}
+
+} // namespace cluster
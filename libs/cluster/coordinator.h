@@ -0,0 +1,128 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CLUSTER_COORDINATOR_H
+#define CLUSTER_COORDINATOR_H
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "cluster/channel.h"
+#include "cluster/layout.h"
+#include "cluster/shm_transport.h"
+#include "cluster/worker.h"
+#include "engine/bit_grid.h"
+#include "engine/boundary.h"
+#include "engine/rule.h"
+
+namespace cluster {
+
+/**
+ * \brief   Runs a board as band_rows x band_cols subdomains in worker
+ *          processes of this host.
+ *
+ * start() forks one worker per subdomain. Workers exchange their halos
+ * through shared memory every generation and take commands over Unix
+ * sockets; the coordinator only hands out steps and gathers populations and
+ * snapshots, so it never touches the board between them. If a worker fails
+ * or dies, the others are aborted and every later call fails.
+ */
+class coordinator final
+{
+public:
+    coordinator(const size_t row_count = 25, const size_t col_count = 25, const size_t band_rows = 1,
+                const size_t band_cols = 1);
+
+    coordinator(const coordinator&) = delete;
+    coordinator& operator=(const coordinator&) = delete;
+
+    ~coordinator();
+
+    size_t band_cols() const { return m_band_cols; }
+
+    size_t band_rows() const { return m_band_rows; }
+
+    life::boundary::boundary_t boundary() const { return m_boundary; }
+
+    size_t col_count() const { return m_col_count; }
+
+    const std::string& error_msg() const { return m_error; }
+
+    uint64_t generation() const { return m_generation; }
+
+    bool next_step() { return step_n(1); }
+
+    /// Live cells of all subdomains.
+    bool population(uint64_t& count);
+
+    size_t row_count() const { return m_row_count; }
+
+    const life::rule& rule() const { return m_rule; }
+
+    /// Dead or torus edges, the others are not supported.
+    bool set_boundary(const life::boundary::boundary_t boundary);
+
+    void set_rule(const life::rule& r) { m_rule = r; }
+
+    /// Gathers the whole board from the workers.
+    bool snapshot(life::bit_grid& grid);
+
+    /// Forks the workers, each takes its subdomain of the board.
+    bool start(const life::bit_grid& begin_state);
+
+    bool step_n(const uint64_t generations);
+
+    /// Stops the workers and waits for them.
+    void stop();
+
+    size_t worker_count() const { return m_band_rows * m_band_cols; }
+
+private:
+    bool fail(const std::string& msg);
+
+    /// Sends the command to every worker and collects the replies.
+    bool broadcast(const worker::command_t kind, const uint64_t value, std::vector<uint64_t>& values);
+
+private:
+    size_t m_row_count;
+    size_t m_col_count;
+    size_t m_band_rows;
+    size_t m_band_cols;
+    life::rule m_rule;
+    life::boundary::boundary_t m_boundary;
+
+    layout m_layout;
+    shared_memory m_segment;
+    std::vector<pid_t> m_pids;
+    std::vector<channel> m_channels;
+
+    uint64_t m_generation;
+    std::string m_error;
+};
+
+} // namespace cluster
+
+#endif // CLUSTER_COORDINATOR_H
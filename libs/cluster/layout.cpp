@@ -0,0 +1,65 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "cluster/layout.h"
+
+namespace cluster {
+
+layout::layout(const size_t row_count, const size_t col_count, const size_t band_rows, const size_t band_cols,
+               const bool is_torus)
+    : m_row_count(row_count)
+    , m_col_count(col_count)
+    , m_band_rows(band_rows)
+    , m_band_cols(band_cols)
+    , m_is_torus(is_torus)
+{}
+
+size_t layout::neighbour(const size_t worker, const int drow, const int dcol) const
+{
+    const ptrdiff_t band_row = (ptrdiff_t)(worker / m_band_cols) + drow;
+    const ptrdiff_t band_col = (ptrdiff_t)(worker % m_band_cols) + dcol;
+    const ptrdiff_t band_rows = (ptrdiff_t)m_band_rows;
+    const ptrdiff_t band_cols = (ptrdiff_t)m_band_cols;
+    if (m_is_torus) {
+        return ((band_row + band_rows) % band_rows) * m_band_cols + (band_col + band_cols) % band_cols;
+    }
+    if ((band_row < 0) || (band_row >= band_rows) || (band_col < 0) || (band_col >= band_cols)) {
+        return none;
+    }
+    return band_row * m_band_cols + band_col;
+}
+
+layout::area layout::subdomain(const size_t worker) const
+{
+    const size_t band_row = worker / m_band_cols;
+    const size_t band_col = worker % m_band_cols;
+    area a;
+    a.row_begin = m_row_count * band_row / m_band_rows;
+    a.row_count = m_row_count * (band_row + 1) / m_band_rows - a.row_begin;
+    a.col_begin = m_col_count * band_col / m_band_cols;
+    a.col_count = m_col_count * (band_col + 1) / m_band_cols - a.col_begin;
+    return a;
+}
+
+} // namespace cluster
@@ -0,0 +1,91 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CLUSTER_LAYOUT_H
+#define CLUSTER_LAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cluster {
+
+/**
+ * \brief   Split of a board into band_rows x band_cols rectangular
+ *          subdomains, one per worker, numbered row by row.
+ *
+ * Bands differ in size by one row or column at most. Subdomains in the
+ * same row band have the same rows, those in the same column band the same
+ * columns, so a neighbour's edge always lines up with the halo it fills.
+ * On a torus the bands wrap around, otherwise there is no neighbour past
+ * the edges of the board.
+ */
+class layout final
+{
+public:
+    struct area final
+    {
+        size_t row_begin = 0;
+        size_t row_count = 0;
+        size_t col_begin = 0;
+        size_t col_count = 0;
+    };
+
+    static constexpr size_t none = SIZE_MAX;
+
+    layout(const size_t row_count = 0, const size_t col_count = 0, const size_t band_rows = 1,
+           const size_t band_cols = 1, const bool is_torus = false);
+
+    size_t band_cols() const { return m_band_cols; }
+
+    size_t band_rows() const { return m_band_rows; }
+
+    size_t col_count() const { return m_col_count; }
+
+    bool is_torus() const { return m_is_torus; }
+
+    /// Widest and highest subdomains, they size the shared buffers.
+    size_t max_cols() const { return (m_col_count + m_band_cols - 1) / m_band_cols; }
+    size_t max_rows() const { return (m_row_count + m_band_rows - 1) / m_band_rows; }
+
+    /// Worker 'drow' and 'dcol' subdomains away, both -1, 0 or 1, or 'none'
+    /// past a dead edge.
+    size_t neighbour(const size_t worker, const int drow, const int dcol) const;
+
+    size_t row_count() const { return m_row_count; }
+
+    area subdomain(const size_t worker) const;
+
+    size_t worker_count() const { return m_band_rows * m_band_cols; }
+
+private:
+    size_t m_row_count;
+    size_t m_col_count;
+    size_t m_band_rows;
+    size_t m_band_cols;
+    bool m_is_torus;
+};
+
+} // namespace cluster
+
+#endif // CLUSTER_LAYOUT_H
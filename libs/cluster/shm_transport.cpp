@@ -0,0 +1,211 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "cluster/shm_transport.h"
+
+namespace cluster {
+namespace {
+
+constexpr size_t word_bits = 64;
+
+/// Spins before a waiting worker starts yielding the CPU.
+constexpr size_t spin_count = 1 << 12;
+
+size_t words_for(const size_t bits)
+{
+    return (bits + word_bits - 1) / word_bits;
+}
+
+} // <anonymous> namespace
+
+//////////////////////////////////////////////////////////////////////
+// class shared_memory
+
+shared_memory::~shared_memory()
+{
+    close();
+}
+
+void shared_memory::close()
+{
+    if (m_p_data != nullptr) {
+        munmap(m_p_data, m_size);
+        m_p_data = nullptr;
+        m_size = 0;
+    }
+}
+
+bool shared_memory::create(const size_t size)
+{
+    close();
+    static std::atomic<uint32_t> counter(0);
+    const std::string name = "/game_of_life." + std::to_string(getpid()) + "." + std::to_string(counter++);
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        m_error = "could not create shared memory '" + name + "': " + std::strerror(errno);
+        return false;
+    }
+    shm_unlink(name.c_str());
+
+    void* p_data = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        p_data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int error = errno;
+    ::close(fd);
+    if (p_data == MAP_FAILED) {
+        m_error = "could not map " + std::to_string(size) + " bytes of shared memory: " + std::strerror(error);
+        return false;
+    }
+    m_p_data = p_data;
+    m_size = size;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// class shm_transport
+
+shm_transport::shm_transport(void* p_segment, const layout& l, const size_t worker)
+    : m_p_segment(p_segment)
+    , m_layout(l)
+    , m_worker(worker)
+    , m_rows(l.subdomain(worker).row_count)
+    , m_words(words_for(l.subdomain(worker).col_count))
+    , m_col_words(words_for(m_rows))
+{}
+
+void shm_transport::abort(void* p_segment)
+{
+    static_cast<control*>(p_segment)->aborted.store(1, std::memory_order_release);
+}
+
+shm_transport::word_t* shm_transport::buffer(const size_t worker, const uint64_t generation) const
+{
+    word_t* p_words = reinterpret_cast<word_t*>(slot_ptr(m_p_segment, m_layout, worker) + 1);
+    return p_words + (generation % 2) * buffer_words(m_layout);
+}
+
+size_t shm_transport::buffer_words(const layout& l)
+{
+    // Two rows, two columns and the corners, rounded up to cache lines.
+    const size_t words = 2 * words_for(l.max_cols()) + 2 * words_for(l.max_rows()) + 1;
+    return (words + 7) / 8 * 8;
+}
+
+bool shm_transport::exchange(const uint64_t generation, const border& edges, border& halo)
+{
+    word_t* p_out = buffer(m_worker, generation);
+    p_out = std::copy_n(edges.north.data(), m_words, p_out);
+    p_out = std::copy_n(edges.south.data(), m_words, p_out);
+    p_out = std::copy_n(edges.west.data(), m_col_words, p_out);
+    p_out = std::copy_n(edges.east.data(), m_col_words, p_out);
+    *p_out = edges.corners;
+    slot_ptr(m_p_segment, m_layout, m_worker)->published.store(generation + 1, std::memory_order_release);
+
+    halo.north.assign(m_words, 0);
+    halo.south.assign(m_words, 0);
+    halo.west.assign(m_col_words, 0);
+    halo.east.assign(m_col_words, 0);
+    halo.corners = 0;
+    for (int drow = -1; drow <= 1; ++drow) {
+        for (int dcol = -1; dcol <= 1; ++dcol) {
+            const size_t n = m_layout.neighbour(m_worker, drow, dcol);
+            if (((drow == 0) && (dcol == 0)) || (n == layout::none)) {
+                continue;
+            }
+            if (! wait(n, generation)) {
+                return false;
+            }
+
+            const layout::area a = m_layout.subdomain(n);
+            const size_t words = words_for(a.col_count);
+            const size_t col_words = words_for(a.row_count);
+            const word_t* p_in = buffer(n, generation);
+            if (dcol == 0) {
+                // A neighbour above gives its south edge, one below its north edge.
+                std::copy_n(p_in + ((drow < 0) ? words : 0), words,
+                            (drow < 0) ? halo.north.data() : halo.south.data());
+            } else if (drow == 0) {
+                // Likewise its east edge to the west and its west edge to the east.
+                std::copy_n(p_in + 2 * words + ((dcol < 0) ? col_words : 0), col_words,
+                            (dcol < 0) ? halo.west.data() : halo.east.data());
+            } else {
+                // A diagonal neighbour gives its opposite corner.
+                const unsigned to = ((drow < 0) ? border::north_west : border::south_west) + ((dcol < 0) ? 0 : 1);
+                const unsigned from = border::south_east - to;
+                halo.corners |= ((p_in[2 * words + 2 * col_words] >> from) & 1) << to;
+            }
+        }
+    }
+    return true;
+}
+
+void shm_transport::reset(void* p_segment, const layout& l)
+{
+    new (p_segment) control();
+    static_cast<control*>(p_segment)->aborted.store(0);
+    for (size_t worker = 0; worker < l.worker_count(); ++worker) {
+        slot* p_slot = new (slot_ptr(p_segment, l, worker)) slot();
+        p_slot->published.store(0);
+    }
+}
+
+size_t shm_transport::segment_size(const layout& l)
+{
+    return sizeof(control) + l.worker_count() * (sizeof(slot) + 2 * buffer_words(l) * sizeof(word_t));
+}
+
+shm_transport::slot* shm_transport::slot_ptr(void* p_segment, const layout& l, const size_t worker)
+{
+    char* p_slots = static_cast<char*>(p_segment) + sizeof(control);
+    return reinterpret_cast<slot*>(p_slots + worker * (sizeof(slot) + 2 * buffer_words(l) * sizeof(word_t)));
+}
+
+bool shm_transport::wait(const size_t worker, const uint64_t generation) const
+{
+    const slot* p_slot = slot_ptr(m_p_segment, m_layout, worker);
+    const control* p_control = static_cast<const control*>(m_p_segment);
+    for (size_t spins = 0; p_slot->published.load(std::memory_order_acquire) <= generation; ++spins) {
+        if (p_control->aborted.load(std::memory_order_acquire) != 0) {
+            return false;
+        }
+        if (spins >= spin_count) {
+            std::this_thread::yield();
+        }
+    }
+    return true;
+}
+
+} // namespace cluster
@@ -0,0 +1,131 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CLUSTER_SHM_TRANSPORT_H
+#define CLUSTER_SHM_TRANSPORT_H
+
+#include <atomic>
+#include <string>
+
+#include "cluster/layout.h"
+#include "cluster/transport.h"
+
+namespace cluster {
+
+/**
+ * \brief   POSIX shared memory segment. The name is unlinked as soon as the
+ *          segment is mapped, processes forked afterwards share the mapping
+ *          and nothing is left behind if they die.
+ */
+class shared_memory final
+{
+public:
+    shared_memory() = default;
+
+    shared_memory(const shared_memory&) = delete;
+    shared_memory& operator=(const shared_memory&) = delete;
+
+    ~shared_memory();
+
+    void close();
+
+    /// Maps a new zero filled segment of 'size' bytes.
+    bool create(const size_t size);
+
+    void* data() const { return m_p_data; }
+
+    const std::string& error_msg() const { return m_error; }
+
+    size_t size() const { return m_size; }
+
+private:
+    void* m_p_data = nullptr;
+    size_t m_size = 0;
+    std::string m_error;
+};
+
+/**
+ * \brief   Transport between the workers of one host over a shared memory
+ *          segment.
+ *
+ * Every worker has a slot with a published generation counter and two
+ * buffers for its edges, used by even and odd generations. A worker copies
+ * its edges in, publishes the generation and spins until its neighbours
+ * published theirs. A worker can only overwrite a buffer two generations
+ * later, after its neighbours published the generation that needed it, so
+ * the buffers are never read while being written.
+ */
+class shm_transport final : public transport
+{
+public:
+    /// Makes every waiting worker give up, e.g. when one of them died.
+    static void abort(void* p_segment);
+
+    /// Readies the segment for a new run, before any worker starts.
+    static void reset(void* p_segment, const layout& l);
+
+    /// Bytes of the segment for the layout.
+    static size_t segment_size(const layout& l);
+
+    shm_transport(void* p_segment, const layout& l, const size_t worker);
+
+    bool exchange(const uint64_t generation, const border& edges, border& halo) override;
+
+private:
+    using word_t = border::word_t;
+
+    struct control final
+    {
+        alignas(64) std::atomic<uint32_t> aborted;
+    };
+
+    struct slot final
+    {
+        alignas(64) std::atomic<uint64_t> published;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must be lock free");
+
+    static size_t buffer_words(const layout& l);
+
+    static slot* slot_ptr(void* p_segment, const layout& l, const size_t worker);
+
+    /// Edges of the worker for generations of the parity.
+    word_t* buffer(const size_t worker, const uint64_t generation) const;
+
+    /// Waits until the worker published the generation.
+    bool wait(const size_t worker, const uint64_t generation) const;
+
+private:
+    void* m_p_segment;
+    layout m_layout;
+    size_t m_worker;
+    size_t m_rows;
+    size_t m_words;
+    size_t m_col_words;
+};
+
+} // namespace cluster
+
+#endif // CLUSTER_SHM_TRANSPORT_H
@@ -0,0 +1,86 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CLUSTER_TRANSPORT_H
+#define CLUSTER_TRANSPORT_H
+
+#include <cstdint>
+#include <vector>
+
+namespace cluster {
+
+/**
+ * \brief   Cells along the border of a subdomain.
+ *
+ * As the edges of a worker they are its first and last rows and columns
+ * and its corner cells; as its halo they are the cells just outside, taken
+ * from the edges of its neighbours. Rows are packed like the rows of a
+ * life::bit_grid, columns hold row r in bit r % 64 of word r / 64.
+ */
+struct border final
+{
+    using word_t = uint64_t;
+
+    enum corner_t : unsigned
+    {
+        north_west,
+        north_east,
+        south_west,
+        south_east
+    };
+
+    bool corner(const corner_t c) const { return (corners >> c) & 1; }
+
+    void set_corner(const corner_t c, const bool alive) { corners |= word_t(alive) << c; }
+
+    std::vector<word_t> north;
+    std::vector<word_t> south;
+    std::vector<word_t> west;
+    std::vector<word_t> east;
+    word_t corners = 0;
+};
+
+/**
+ * \brief   Moves the borders of the workers between them once per
+ *          generation.
+ *
+ * A transport is the only way workers talk to each other, so moving them
+ * to other hosts takes a transport over the network and nothing else.
+ */
+class transport
+{
+public:
+    virtual ~transport() = default;
+
+    /// Publishes the edges of the board of 'generation' and gathers the
+    /// halo of that board from the edges the neighbours published for the
+    /// same generation, waiting for them if needed. The halo cells past a
+    /// dead edge are zero.
+    /// \return   false if the exchange was aborted.
+    virtual bool exchange(const uint64_t generation, const border& edges, border& halo) = 0;
+};
+
+} // namespace cluster
+
+#endif // CLUSTER_TRANSPORT_H
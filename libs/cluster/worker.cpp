@@ -0,0 +1,199 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "cluster/worker.h"
+#include "engine/boundary.h"
+
+namespace cluster {
+namespace {
+
+using word_t = life::bit_grid::word_t;
+
+constexpr size_t word_bits = life::bit_grid::word_bits;
+
+bool column_bit(const std::vector<word_t>& column, const size_t row)
+{
+    return (column[row / word_bits] >> (row % word_bits)) & 1;
+}
+
+} // <anonymous> namespace
+
+worker::worker(const layout& l, const size_t index, transport& t)
+    : m_layout(l)
+    , m_index(index)
+    , m_transport(t)
+    , m_step(life::kernel::step_fn(life::kernel::best_isa(), false, false))
+    , m_generation(0)
+{
+    const layout::area a = l.subdomain(index);
+    m_grid.resize(a.row_count, a.col_count);
+    m_next.resize(a.row_count, a.col_count);
+}
+
+void worker::fill_halo()
+{
+    const size_t row_count = m_grid.row_count();
+    const size_t col_count = m_grid.col_count();
+    const size_t words = m_grid.words();
+    std::copy_n(m_halo.north.data(), words, m_grid.row_ptr(-1));
+    std::copy_n(m_halo.south.data(), words, m_grid.row_ptr(row_count));
+
+    // The west halo is the top bit of the word before a row, the east one
+    // the bit past the last column.
+    const size_t east_word = col_count / word_bits;
+    const size_t east_bit = col_count % word_bits;
+    for (ptrdiff_t r = -1; r <= (ptrdiff_t)row_count; ++r) {
+        bool west = false;
+        bool east = false;
+        if (r < 0) {
+            west = m_halo.corner(border::north_west);
+            east = m_halo.corner(border::north_east);
+        } else if (r == (ptrdiff_t)row_count) {
+            west = m_halo.corner(border::south_west);
+            east = m_halo.corner(border::south_east);
+        } else {
+            west = column_bit(m_halo.west, r);
+            east = column_bit(m_halo.east, r);
+        }
+        word_t* p_row = m_grid.row_ptr(r);
+        p_row[-1] = word_t(west) << (word_bits - 1);
+        p_row[east_word] |= word_t(east) << east_bit;
+    }
+}
+
+bool worker::next_step()
+{
+    store_edges();
+    if (! m_transport.exchange(m_generation, m_edges, m_halo)) {
+        return false;
+    }
+    fill_halo();
+    m_step(m_grid, m_next, 0, m_grid.row_count(), 0, m_grid.words(), m_rule);
+    life::boundary::clear(m_grid);
+    m_grid.swap(m_next);
+    ++m_generation;
+    return true;
+}
+
+bool worker::serve(const channel& ch)
+{
+    command cmd;
+    while (ch.receive(cmd)) {
+        reply r;
+        switch (cmd.kind) {
+        case command_t::step:
+            r.is_ok = step_n(cmd.value);
+            r.value = m_generation;
+            break;
+        case command_t::population:
+            r.is_ok = true;
+            r.value = population();
+            break;
+        case command_t::snapshot:
+            r.is_ok = true;
+            r.value = m_grid.row_count() * m_grid.words();
+            break;
+        case command_t::stop:
+            r.is_ok = true;
+            return ch.send(r);
+        }
+
+        if (! ch.send(r)) {
+            return false;
+        }
+        if ((cmd.kind == command_t::snapshot) && (r.is_ok != 0)) {
+            for (size_t row = 0; row < m_grid.row_count(); ++row) {
+                if (! ch.send(m_grid.row_ptr(row), m_grid.words() * sizeof(word_t))) {
+                    return false;
+                }
+            }
+        }
+        if (r.is_ok == 0) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void worker::set_rule(const life::rule& r)
+{
+    m_rule = r;
+    m_step = life::kernel::step_fn(life::kernel::best_isa(), false, ! m_rule.is_conway());
+}
+
+void worker::start(const life::bit_grid& board, const uint64_t generation)
+{
+    // Word w of a row of the subdomain is the 64 cell window of the board
+    // row from column col_begin + 64 * w.
+    const layout::area a = m_layout.subdomain(m_index);
+    const size_t shift = a.col_begin % word_bits;
+    m_grid.clear();
+    for (size_t r = 0; r < a.row_count; ++r) {
+        const word_t* p_src = board.row_ptr(a.row_begin + r) + a.col_begin / word_bits;
+        word_t* p_dst = m_grid.row_ptr(r);
+        for (size_t w = 0; w < m_grid.words(); ++w) {
+            p_dst[w] = p_src[w] >> shift;
+            if (shift != 0) {
+                p_dst[w] |= p_src[w + 1] << (word_bits - shift);
+            }
+        }
+        p_dst[m_grid.words() - 1] &= m_grid.last_word_mask();
+    }
+    m_generation = generation;
+}
+
+bool worker::step_n(const uint64_t generations)
+{
+    for (uint64_t i = 0; i < generations; ++i) {
+        if (! next_step()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void worker::store_edges()
+{
+    const size_t row_count = m_grid.row_count();
+    const size_t col_count = m_grid.col_count();
+    const size_t words = m_grid.words();
+    m_edges.north.assign(m_grid.row_ptr(0), m_grid.row_ptr(0) + words);
+    m_edges.south.assign(m_grid.row_ptr(row_count - 1), m_grid.row_ptr(row_count - 1) + words);
+    m_edges.west.assign((row_count + word_bits - 1) / word_bits, 0);
+    m_edges.east.assign(m_edges.west.size(), 0);
+    for (size_t r = 0; r < row_count; ++r) {
+        m_edges.west[r / word_bits] |= word_t(m_grid.get(r, 0)) << (r % word_bits);
+        m_edges.east[r / word_bits] |= word_t(m_grid.get(r, col_count - 1)) << (r % word_bits);
+    }
+    m_edges.corners = 0;
+    m_edges.set_corner(border::north_west, m_grid.get(0, 0));
+    m_edges.set_corner(border::north_east, m_grid.get(0, col_count - 1));
+    m_edges.set_corner(border::south_west, m_grid.get(row_count - 1, 0));
+    m_edges.set_corner(border::south_east, m_grid.get(row_count - 1, col_count - 1));
+}
+
+} // namespace cluster
@@ -0,0 +1,121 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef CLUSTER_WORKER_H
+#define CLUSTER_WORKER_H
+
+#include <cstdint>
+
+#include "cluster/channel.h"
+#include "cluster/layout.h"
+#include "cluster/transport.h"
+#include "engine/bit_grid.h"
+#include "engine/kernel.h"
+#include "engine/rule.h"
+
+namespace cluster {
+
+/**
+ * \brief   Steps one subdomain of a board.
+ *
+ * Before every step the worker trades its edges for its halo through the
+ * transport, fills the halo of its packed board with them and runs the
+ * kernel over the whole subdomain, so the result is the same as a step of
+ * the whole board.
+ */
+class worker final
+{
+public:
+    /// Commands of the coordinator on the channel of a worker.
+    enum class command_t : uint32_t
+    {
+        step,           ///< Steps 'value' generations.
+        population,
+        snapshot,       ///< The reply is followed by the data words of every row.
+        stop
+    };
+
+    struct command final
+    {
+        command_t kind = command_t::stop;
+        uint32_t reserved = 0;
+        uint64_t value = 0;
+    };
+
+    /// Reply to every command, 'value' is the population or the generation.
+    struct reply final
+    {
+        uint64_t is_ok = 0;
+        uint64_t value = 0;
+    };
+
+    worker(const layout& l, const size_t index, transport& t);
+
+    uint64_t generation() const { return m_generation; }
+
+    size_t index() const { return m_index; }
+
+    bool next_step();
+
+    size_t population() const { return m_grid.population(); }
+
+    const life::rule& rule() const { return m_rule; }
+
+    /// Answers the commands on the channel.
+    /// \return   true after a stop command, false if the connection or an
+    ///           exchange failed.
+    bool serve(const channel& ch);
+
+    void set_rule(const life::rule& r);
+
+    /// Takes the subdomain of the whole board.
+    void start(const life::bit_grid& board, const uint64_t generation = 0);
+
+    bool step_n(const uint64_t generations);
+
+    const life::bit_grid& storage() const { return m_grid; }
+
+private:
+    void fill_halo();
+
+    void store_edges();
+
+private:
+    layout m_layout;
+    size_t m_index;
+    transport& m_transport;
+
+    life::rule m_rule;
+    life::kernel::step_fn_t m_step;
+
+    uint64_t m_generation;
+    border m_edges;
+    border m_halo;
+    life::bit_grid m_grid;
+    life::bit_grid m_next;
+};
+
+} // namespace cluster
+
+#endif // CLUSTER_WORKER_H
@@ -0,0 +1,115 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "display/frame_ring.h"
+
+namespace display {
+namespace {
+
+/// Waits for 'is_ready' to hold: spins a little for short waits, then
+/// sleeps, as either side may be slow for whole frames.
+template<typename TPredicate>
+void wait_for(const TPredicate& is_ready)
+{
+    for (size_t attempt = 0; ! is_ready(); ++attempt) {
+        if (attempt < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+} // <anonymous> namespace
+
+frame_ring::frame_ring(const size_t capacity, const backpressure_t backpressure)
+    : m_head(0)
+    , m_tail(0)
+    , m_is_closed(false)
+    , m_backpressure(backpressure)
+    , m_dropped(0)
+    , m_frames(std::max<size_t>(capacity, 1))
+{}
+
+void frame_ring::close()
+{
+    m_is_closed.store(true, std::memory_order_release);
+}
+
+const frame_ring::frame* frame_ring::front()
+{
+    const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    wait_for([&] () {
+        return m_is_closed.load(std::memory_order_acquire) || (m_head.load(std::memory_order_acquire) != tail);
+    });
+    // Frames published before close() are visible once it is, so the ring
+    // is drained only if the head did not move.
+    if (m_head.load(std::memory_order_acquire) == tail) {
+        return nullptr;
+    }
+    return &m_frames[tail % m_frames.size()];
+}
+
+void frame_ring::pop()
+{
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool frame_ring::push(const life::bit_grid& grid, const uint64_t generation, const bool is_last)
+{
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    const auto has_room = [&] () { return (head - m_tail.load(std::memory_order_acquire)) < m_frames.size(); };
+    if (! has_room()) {
+        if ((m_backpressure == backpressure_t::drop) && ! is_last) {
+            ++m_dropped;
+            return false;
+        }
+        wait_for(has_room);
+    }
+
+    frame& f = m_frames[head % m_frames.size()];
+    f.grid = grid;
+    f.generation = generation;
+    f.is_last = is_last;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool backpressure_from_string(const std::string& name, frame_ring::backpressure_t& backpressure)
+{
+    if (name == "block") {
+        backpressure = frame_ring::backpressure_t::block;
+    } else if (name == "drop") {
+        backpressure = frame_ring::backpressure_t::drop;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace display
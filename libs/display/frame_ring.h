@@ -0,0 +1,99 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DISPLAY_FRAME_RING_H
+#define DISPLAY_FRAME_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "engine/bit_grid.h"
+
+namespace display {
+
+/**
+ * \brief   Bounded single producer, single consumer ring of board frames.
+ *
+ * The engine thread copies generations into the free slots and publishes
+ * them, a writer thread takes them in order and gives the slots back. The
+ * slots are reused, so a steady run copies boards without allocating, and
+ * the two sides share only the head and tail counters, each written by one
+ * side. When the ring is full the producer either waits for a free slot or
+ * drops the frame, as the backpressure says; the last frame always waits.
+ */
+class frame_ring final
+{
+public:
+    enum class backpressure_t
+    {
+        block,
+        drop
+    };
+
+    struct frame final
+    {
+        life::bit_grid grid;
+        uint64_t generation = 0;
+        bool is_last = false;
+    };
+
+    frame_ring(const size_t capacity, const backpressure_t backpressure);
+
+    /// Ends the stream, the consumer still gets the frames published so far.
+    void close();
+
+    /// Frames the producer dropped.
+    uint64_t dropped() const { return m_dropped; }
+
+    /// The oldest published frame, waits for one. nullptr once the ring is
+    /// closed and drained.
+    const frame* front();
+
+    /// Gives the slot of the front frame back to the producer.
+    void pop();
+
+    /// Publishes a copy of 'grid'.
+    /// \return   false if the frame was dropped.
+    bool push(const life::bit_grid& grid, const uint64_t generation, const bool is_last);
+
+private:
+    // The counters only grow, slot i is i % capacity. Each one is on its own
+    // cache line, so the sides do not invalidate each other's line.
+    alignas(64) std::atomic<uint64_t> m_head;
+    alignas(64) std::atomic<uint64_t> m_tail;
+    alignas(64) std::atomic<bool> m_is_closed;
+
+    const backpressure_t m_backpressure;
+    uint64_t m_dropped;
+    std::vector<frame> m_frames;
+};
+
+/// Parses 'block' or 'drop'.
+bool backpressure_from_string(const std::string& name, frame_ring::backpressure_t& backpressure);
+
+} // namespace display
+
+#endif // DISPLAY_FRAME_RING_H
@@ -0,0 +1,181 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "display/renderer.h"
+
+namespace display {
+namespace {
+
+constexpr char alive_char = '*';
+constexpr char dead_char = '-';
+
+} // <anonymous> namespace
+
+renderer::renderer(const int fd, const mode_t mode)
+    : m_fd(fd)
+    , m_mode(mode)
+    , m_max_rows(SIZE_MAX)
+    , m_max_cols(SIZE_MAX)
+    , m_is_valid(false)
+{
+    struct winsize ws;
+    if ((m_mode == mode_t::ansi) && (ioctl(m_fd, TIOCGWINSZ, &ws) == 0) && (ws.ws_row > 1) && (ws.ws_col > 0)) {
+        // The last line is left for the cursor.
+        m_max_rows = ws.ws_row - 1;
+        m_max_cols = ws.ws_col;
+    }
+}
+
+void renderer::append_diff(const life::bit_grid& frame)
+{
+    const size_t row_count = std::min(frame.row_count(), m_max_rows);
+    const size_t col_count = std::min(frame.col_count(), m_max_cols);
+    const size_t words = (col_count + life::bit_grid::word_bits - 1) / life::bit_grid::word_bits;
+
+    for (size_t r = 0; r < row_count; ++r) {
+        const life::bit_grid::word_t* p_row = frame.row_ptr(r);
+        const life::bit_grid::word_t* p_last = m_last.row_ptr(r);
+        size_t cursor = SIZE_MAX;
+        for (size_t w = 0; w < words; ++w) {
+            life::bit_grid::word_t diff = p_row[w] ^ p_last[w];
+            while (diff != 0) {
+                const size_t col = w * life::bit_grid::word_bits + __builtin_ctzll(diff);
+                diff &= diff - 1;
+                if (col >= col_count) {
+                    break;
+                }
+                // Neighbouring changed cells share one cursor move.
+                if (col != cursor) {
+                    append_move(r, col);
+                }
+                m_buffer += ((p_row[w] >> (col % life::bit_grid::word_bits)) & 1) ? alive_char : dead_char;
+                cursor = col + 1;
+            }
+        }
+    }
+    append_move(row_count, 0);
+}
+
+void renderer::append_full(const life::bit_grid& frame)
+{
+    if (m_mode == mode_t::plain) {
+        m_buffer += '\n';
+        for (size_t r = 0; r < frame.row_count(); ++r) {
+            append_row(frame.row_ptr(r), frame.col_count());
+        }
+        m_buffer += '\n';
+        return;
+    }
+
+    m_buffer += "\x1b[H\x1b[2J";
+    const size_t row_count = std::min(frame.row_count(), m_max_rows);
+    const size_t col_count = std::min(frame.col_count(), m_max_cols);
+    for (size_t r = 0; r < row_count; ++r) {
+        append_row(frame.row_ptr(r), col_count);
+    }
+}
+
+void renderer::append_move(const size_t row, const size_t col)
+{
+    m_buffer += "\x1b[";
+    m_buffer += std::to_string(row + 1);
+    m_buffer += ';';
+    m_buffer += std::to_string(col + 1);
+    m_buffer += 'H';
+}
+
+void renderer::append_row(const life::bit_grid::word_t* p_row, const size_t col_count)
+{
+    const size_t begin = m_buffer.size();
+    m_buffer.resize(begin + col_count + 1);
+    char* p_out = &m_buffer[begin];
+    for (size_t c = 0; c < col_count; ++c) {
+        const life::bit_grid::word_t w = p_row[c / life::bit_grid::word_bits];
+        p_out[c] = ((w >> (c % life::bit_grid::word_bits)) & 1) ? alive_char : dead_char;
+    }
+    p_out[col_count] = '\n';
+}
+
+renderer::mode_t renderer::auto_mode(const int fd)
+{
+    const char* p_term = std::getenv("TERM");
+    if (isatty(fd) && (p_term != nullptr) && (std::strcmp(p_term, "") != 0) && (std::strcmp(p_term, "dumb") != 0)) {
+        return mode_t::ansi;
+    }
+    return mode_t::plain;
+}
+
+bool renderer::draw(const life::bit_grid& frame)
+{
+    m_buffer.clear();
+    const bool is_same_size = (frame.row_count() == m_last.row_count()) && (frame.col_count() == m_last.col_count());
+    if ((m_mode == mode_t::ansi) && m_is_valid && is_same_size) {
+        append_diff(frame);
+    } else {
+        append_full(frame);
+    }
+
+    if (m_mode == mode_t::ansi) {
+        m_last = frame;
+        m_is_valid = true;
+    }
+    return flush();
+}
+
+void renderer::set_max_size(const size_t row_count, const size_t col_count)
+{
+    m_max_rows = row_count;
+    m_max_cols = col_count;
+    m_is_valid = false;
+}
+
+bool renderer::flush()
+{
+    const char* p_data = m_buffer.data();
+    size_t size = m_buffer.size();
+    while (size > 0) {
+        const ssize_t written = write(m_fd, p_data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p_data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+} // namespace display
@@ -0,0 +1,93 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef DISPLAY_RENDERER_H
+#define DISPLAY_RENDERER_H
+
+#include <string>
+
+#include "engine/bit_grid.h"
+
+namespace display {
+
+/**
+ * \brief   Draws boards to a terminal.
+ *
+ * A frame is built in one reusable buffer and goes out in a single write().
+ * In the plain mode every frame is the whole board. In the ANSI mode the
+ * first frame clears the screen and the next ones only move the cursor to
+ * the cells that changed since the previous frame; the board is clipped to
+ * the terminal size, so cursor positions stay valid.
+ */
+class renderer final
+{
+public:
+    enum class mode_t
+    {
+        plain,
+        ansi
+    };
+
+    renderer(const int fd, const mode_t mode);
+
+    /// ANSI if 'fd' is a terminal that understands escape sequences.
+    static mode_t auto_mode(const int fd);
+
+    bool draw(const life::bit_grid& frame);
+
+    /// Makes the next frame a full redraw.
+    void invalidate() { m_is_valid = false; }
+
+    mode_t mode() const { return m_mode; }
+
+    /// Clips ANSI frames to 'row_count' x 'col_count' cells instead of the
+    /// terminal size.
+    void set_max_size(const size_t row_count, const size_t col_count);
+
+private:
+    void append_diff(const life::bit_grid& frame);
+
+    void append_full(const life::bit_grid& frame);
+
+    void append_move(const size_t row, const size_t col);
+
+    void append_row(const life::bit_grid::word_t* p_row, const size_t col_count);
+
+    bool flush();
+
+private:
+    const int m_fd;
+    const mode_t m_mode;
+    size_t m_max_rows;
+    size_t m_max_cols;
+
+    bool m_is_valid;
+    life::bit_grid m_last;
+    std::string m_buffer;
+};
+
+} // namespace display
+
+#endif // DISPLAY_RENDERER_H
@@ -0,0 +1,77 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_ALIGNED_ALLOCATOR_H
+#define LIFE_ALIGNED_ALLOCATOR_H
+
+#include <cstdlib>
+#include <new>
+
+namespace life {
+
+/**
+ * \brief   Allocator returning memory aligned to 'TAlign' bytes.
+ */
+template<typename TType, size_t TAlign>
+class aligned_allocator
+{
+    static_assert((TAlign & (TAlign - 1)) == 0, "alignment must be a power of two");
+    static_assert(TAlign >= alignof(TType), "alignment is less than type alignment");
+
+public:
+    using value_type = TType;
+
+    template<typename TOther>
+    struct rebind
+    {
+        using other = aligned_allocator<TOther, TAlign>;
+    };
+
+    aligned_allocator() noexcept {}
+
+    template<typename TOther>
+    aligned_allocator(const aligned_allocator<TOther, TAlign>&) noexcept {}
+
+    TType* allocate(const size_t count)
+    {
+        const size_t size = ((count * sizeof(TType) + TAlign - 1) / TAlign) * TAlign;
+        void* p = std::aligned_alloc(TAlign, (size == 0) ? TAlign : size);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<TType*>(p);
+    }
+
+    void deallocate(TType* p, const size_t) noexcept { std::free(p); }
+
+    template<typename TOther>
+    bool operator==(const aligned_allocator<TOther, TAlign>&) const noexcept { return true; }
+
+    template<typename TOther>
+    bool operator!=(const aligned_allocator<TOther, TAlign>&) const noexcept { return false; }
+};
+
+} // namespace life
+
+#endif // LIFE_ALIGNED_ALLOCATOR_H
@@ -0,0 +1,111 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "engine/bit_grid.h"
+
+namespace life {
+
+bit_grid::bit_grid(const size_t row_count, const size_t col_count)
+{
+    resize(row_count, col_count);
+}
+
+void bit_grid::clear()
+{
+    std::fill(m_buffer.begin(), m_buffer.end(), 0);
+}
+
+size_t bit_grid::population() const
+{
+    size_t count = 0;
+    for (size_t r = 0; r < m_row_count; ++r) {
+        const word_t* p_row = row_ptr(r);
+        for (size_t w = 0; w < m_words; ++w) {
+            count += __builtin_popcountll(p_row[w]);
+        }
+    }
+    return count;
+}
+
+void bit_grid::resize(const size_t row_count, const size_t col_count)
+{
+    m_row_count = row_count;
+    m_col_count = col_count;
+    m_words = (col_count + word_bits - 1) / word_bits;
+    // Left halo takes a whole cache line to keep the data aligned, the right
+    // halo is at least one word of padding up to the next cache line.
+    m_stride = line_words + ((m_words + 1 + line_words - 1) / line_words) * line_words;
+    m_last_mask = ((col_count % word_bits) == 0) ? ~word_t(0) : ((word_t(1) << (col_count % word_bits)) - 1);
+
+    m_buffer.assign((m_row_count + 2) * m_stride, 0);
+}
+
+void bit_grid::set_run(const size_t row, const size_t col, const size_t count)
+{
+    if ((col >= m_col_count) || (count == 0)) {
+        return;
+    }
+
+    const size_t end = col + std::min(count, m_col_count - col);
+    word_t* p_row = row_ptr(row);
+    const size_t first = col / word_bits;
+    const size_t last = (end - 1) / word_bits;
+    const word_t head = ~word_t(0) << (col % word_bits);
+    const word_t tail = ~word_t(0) >> (word_bits - 1 - (end - 1) % word_bits);
+    if (first == last) {
+        p_row[first] |= head & tail;
+        return;
+    }
+    p_row[first] |= head;
+    std::fill(p_row + first + 1, p_row + last, ~word_t(0));
+    p_row[last] |= tail;
+}
+
+void bit_grid::swap(bit_grid& other)
+{
+    std::swap(m_row_count, other.m_row_count);
+    std::swap(m_col_count, other.m_col_count);
+    std::swap(m_words, other.m_words);
+    std::swap(m_stride, other.m_stride);
+    std::swap(m_last_mask, other.m_last_mask);
+    m_buffer.swap(other.m_buffer);
+}
+
+bool bit_grid::operator==(const bit_grid& other) const
+{
+    if ((m_row_count != other.m_row_count) || (m_col_count != other.m_col_count)) {
+        return false;
+    }
+    for (size_t r = 0; r < m_row_count; ++r) {
+        if (std::memcmp(row_ptr(r), other.row_ptr(r), m_words * sizeof(word_t)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace life
@@ -0,0 +1,116 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_BIT_GRID_H
+#define LIFE_BIT_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/aligned_allocator.h"
+
+namespace life {
+
+/**
+ * \brief   Packed board storage: one bit per cell in a single contiguous,
+ *          cache line aligned buffer of 64-bit words.
+ *
+ * Cell (r, c) is bit (c % 64) of word (c / 64) of row r. Every row starts
+ * on a cache line and is framed by zero halo words on both sides, the whole
+ * board is framed by a zero halo row above and below. Neighbours of border
+ * cells can therefore be read without any bounds checks. Bits past
+ * col_count() in the last word of a row are always zero.
+ */
+class bit_grid final
+{
+public:
+    using word_t = uint64_t;
+
+    static constexpr size_t word_bits = 64;
+    static constexpr size_t line_words = 64 / sizeof(word_t);
+
+    bit_grid(const size_t row_count = 0, const size_t col_count = 0);
+
+    void clear();
+
+    size_t col_count() const { return m_col_count; }
+
+    bool get(const size_t row, const size_t col) const
+    {
+        return (row_ptr(row)[col / word_bits] >> (col % word_bits)) & 1;
+    }
+
+    /// Mask of the valid bits in the last data word of a row.
+    word_t last_word_mask() const { return m_last_mask; }
+
+    size_t population() const;
+
+    void resize(const size_t row_count, const size_t col_count);
+
+    /// First data word of the row. Row -1 and row_count() are halo rows.
+    word_t* row_ptr(const ptrdiff_t row) { return m_buffer.data() + offset(row); }
+    const word_t* row_ptr(const ptrdiff_t row) const { return m_buffer.data() + offset(row); }
+
+    size_t row_count() const { return m_row_count; }
+
+    void set(const size_t row, const size_t col, const bool alive)
+    {
+        word_t& w = row_ptr(row)[col / word_bits];
+        const word_t bit = word_t(1) << (col % word_bits);
+        w = alive ? (w | bit) : (w & ~bit);
+    }
+
+    /// Sets 'count' cells of the row alive from 'col' on, clipped to the row.
+    void set_run(const size_t row, const size_t col, const size_t count);
+
+    /// Distance in words between two adjacent rows.
+    size_t stride() const { return m_stride; }
+
+    void swap(bit_grid& other);
+
+    /// Data words per row.
+    size_t words() const { return m_words; }
+
+    bool operator==(const bit_grid& other) const;
+    bool operator!=(const bit_grid& other) const { return ! (*this == other); }
+
+private:
+    size_t offset(const ptrdiff_t row) const { return (row + 1) * m_stride + line_words; }
+
+private:
+    using buffer_t = std::vector<word_t, aligned_allocator<word_t, line_words * sizeof(word_t)>>;
+
+    size_t m_row_count;
+    size_t m_col_count;
+    size_t m_words;
+    size_t m_stride;
+    word_t m_last_mask;
+
+    buffer_t m_buffer;
+};
+
+} // namespace life
+
+#endif // LIFE_BIT_GRID_H
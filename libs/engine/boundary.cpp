@@ -0,0 +1,206 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+
+#include "engine/boundary.h"
+
+namespace life {
+namespace boundary {
+namespace {
+
+using word_t = bit_grid::word_t;
+
+constexpr size_t word_bits = bit_grid::word_bits;
+
+/*
+ * Boundary policies. 'wrap_rows' joins the top and bottom edges, otherwise
+ * they are mirrored; 'flip_rows' reverses the rows joined across them.
+ * 'wrap_cols' joins the left and right edges, otherwise they are mirrored.
+ */
+struct torus_policy final
+{
+    static constexpr bool wrap_rows = true;
+    static constexpr bool flip_rows = false;
+    static constexpr bool wrap_cols = true;
+};
+
+struct mirror_policy final
+{
+    static constexpr bool wrap_rows = false;
+    static constexpr bool flip_rows = false;
+    static constexpr bool wrap_cols = false;
+};
+
+struct klein_policy final
+{
+    static constexpr bool wrap_rows = true;
+    static constexpr bool flip_rows = true;
+    static constexpr bool wrap_cols = true;
+};
+
+inline word_t reverse_bits(word_t w)
+{
+    w = ((w >> 1) & 0x5555555555555555ull) | ((w & 0x5555555555555555ull) << 1);
+    w = ((w >> 2) & 0x3333333333333333ull) | ((w & 0x3333333333333333ull) << 2);
+    w = ((w >> 4) & 0x0f0f0f0f0f0f0f0full) | ((w & 0x0f0f0f0f0f0f0f0full) << 4);
+    return __builtin_bswap64(w);
+}
+
+inline bool cell(const word_t* p_row, const size_t col)
+{
+    return (p_row[col / word_bits] >> (col % word_bits)) & 1;
+}
+
+/// Copies the row 'src' into the halo row 'dst' reversed. The left halo
+/// word of 'src' must be zero, it stands for the cells before column 0.
+void copy_reversed(const bit_grid& grid, const word_t* p_src, word_t* p_dst)
+{
+    // Bit c of the copy is bit (col_count - 1 - c) of the source, so word i
+    // is the reversed 64 bit window of the source ending at that column.
+    const ptrdiff_t col_count = (ptrdiff_t)grid.col_count();
+    for (size_t w = 0; w < grid.words(); ++w) {
+        const ptrdiff_t begin = col_count - (ptrdiff_t)((w + 1) * word_bits);
+        const ptrdiff_t index = (begin >= 0) ? begin / (ptrdiff_t)word_bits : -1;
+        const size_t shift = (size_t)(begin - index * (ptrdiff_t)word_bits);
+        word_t window = p_src[index] >> shift;
+        if (shift != 0) {
+            window |= p_src[index + 1] << (word_bits - shift);
+        }
+        p_dst[w] = reverse_bits(window);
+    }
+    p_dst[grid.words() - 1] &= grid.last_word_mask();
+}
+
+template<typename TPolicy>
+void fill(bit_grid& grid)
+{
+    const size_t row_count = grid.row_count();
+    const size_t col_count = grid.col_count();
+    if ((row_count == 0) || (col_count == 0)) {
+        return;
+    }
+
+    word_t* p_above = grid.row_ptr(-1);
+    word_t* p_below = grid.row_ptr(row_count);
+    const word_t* p_first = grid.row_ptr(0);
+    const word_t* p_last = grid.row_ptr(row_count - 1);
+    if constexpr (TPolicy::flip_rows) {
+        copy_reversed(grid, p_last, p_above);
+        copy_reversed(grid, p_first, p_below);
+    } else if constexpr (TPolicy::wrap_rows) {
+        std::copy_n(p_last, grid.words(), p_above);
+        std::copy_n(p_first, grid.words(), p_below);
+    } else {
+        std::copy_n(p_first, grid.words(), p_above);
+        std::copy_n(p_last, grid.words(), p_below);
+    }
+
+    // Columns go after the rows, so the corners of the halo rows come out
+    // right as well.
+    const size_t east_word = col_count / word_bits;
+    const size_t east_bit = col_count % word_bits;
+    for (ptrdiff_t r = -1; r <= (ptrdiff_t)row_count; ++r) {
+        word_t* p_row = grid.row_ptr(r);
+        const bool first = cell(p_row, 0);
+        const bool last = cell(p_row, col_count - 1);
+        const bool west = TPolicy::wrap_cols ? last : first;
+        const bool east = TPolicy::wrap_cols ? first : last;
+        p_row[-1] = word_t(west) << (word_bits - 1);
+        p_row[east_word] |= word_t(east) << east_bit;
+    }
+}
+
+} // <anonymous> namespace
+
+void clear(bit_grid& grid)
+{
+    const size_t row_count = grid.row_count();
+    if ((row_count == 0) || (grid.col_count() == 0)) {
+        return;
+    }
+
+    std::fill_n(grid.row_ptr(-1) - 1, grid.words() + 2, word_t(0));
+    std::fill_n(grid.row_ptr(row_count) - 1, grid.words() + 2, word_t(0));
+    const bool is_aligned = ((grid.col_count() % word_bits) == 0);
+    for (size_t r = 0; r < row_count; ++r) {
+        word_t* p_row = grid.row_ptr(r);
+        p_row[-1] = 0;
+        if (is_aligned) {
+            p_row[grid.words()] = 0;
+        } else {
+            p_row[grid.words() - 1] &= grid.last_word_mask();
+        }
+    }
+}
+
+fill_fn_t fill_fn(const boundary_t boundary)
+{
+    switch (boundary) {
+    case boundary_t::dead:
+        return nullptr;
+    case boundary_t::torus:
+        return fill<torus_policy>;
+    case boundary_t::mirror:
+        return fill<mirror_policy>;
+    case boundary_t::klein:
+        return fill<klein_policy>;
+    }
+    return nullptr;
+}
+
+bool from_string(const std::string& name, boundary_t& boundary)
+{
+    if (name == "dead") {
+        boundary = boundary_t::dead;
+    } else if (name == "torus") {
+        boundary = boundary_t::torus;
+    } else if (name == "mirror") {
+        boundary = boundary_t::mirror;
+    } else if (name == "klein") {
+        boundary = boundary_t::klein;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* name(const boundary_t boundary)
+{
+    switch (boundary) {
+    case boundary_t::dead:
+        return "dead";
+    case boundary_t::torus:
+        return "torus";
+    case boundary_t::mirror:
+        return "mirror";
+    case boundary_t::klein:
+        return "klein";
+    }
+    return "unknown";
+}
+
+} // namespace boundary
+} // namespace life
@@ -0,0 +1,70 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef LIFE_BOUNDARY_H
+#define LIFE_BOUNDARY_H
+
+#include <string>
+
+#include "engine/bit_grid.h"
+
+namespace life {
+namespace boundary {
+
+/**
+ * \brief   What lies beyond the edges of a bounded board.
+ */
+enum class boundary_t
+{
+    dead,       ///< Cells beyond the edges are dead.
+    torus,      ///< Opposite edges are joined.
+    mirror,     ///< Every edge reflects the cells along it.
+    klein       ///< Left and right edges are joined, top and bottom are joined flipped.
+};
+
+/**
+ * \brief   Fills the halo of 'grid' with the cells beyond its edges: the
+ *          halo rows, the west neighbour of column 0 and the east neighbour
+ *          of the last column. The kernel then steps the edges the same way
+ *          as the interior, with no edge branches.
+ */
+using fill_fn_t = void (*)(bit_grid& grid);
+
+/// Halo filler of the boundary, nullptr for the dead one, whose halo is
+/// always zero.
+fill_fn_t fill_fn(const boundary_t boundary);
+
+/// Zeroes the halo again, so bits past the last column are zero.
+void clear(bit_grid& grid);
+
+/// Parses "dead", "torus", "mirror" or "klein".
+bool from_string(const std::string& name, boundary_t& boundary);
+
+const char* name(const boundary_t boundary);
+
+} // namespace boundary
+} // namespace life
+
+#endif // LIFE_BOUNDARY_H
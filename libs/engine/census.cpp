@@ -0,0 +1,227 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "engine/census.h"
+#include "engine/life_engine.h"
+
+namespace life {
+namespace {
+
+/// Soups per task of the thread pool, enough to hide the engine setup.
+constexpr uint64_t chunk_soups = 64;
+
+uint64_t mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+/// SplitMix64, one independent stream per seed and soup.
+class soup_random final
+{
+public:
+    soup_random(const uint64_t seed, const uint64_t soup)
+        : m_state(mix(seed) ^ mix(soup + 0x9e3779b97f4a7c15ull))
+    {}
+
+    uint64_t operator()()
+    {
+        m_state += 0x9e3779b97f4a7c15ull;
+        return mix(m_state);
+    }
+
+private:
+    uint64_t m_state;
+};
+
+} // <anonymous> namespace
+
+size_t census_report::bucket(const uint64_t value)
+{
+    return (value == 0) ? 0 : 64 - __builtin_clzll(value);
+}
+
+void census_report::merge(const census_report& other)
+{
+    if ((other.settled_count() != 0)
+        && ((settled_count() == 0) || (other.max_lifespan > max_lifespan)
+            || ((other.max_lifespan == max_lifespan) && (other.max_lifespan_soup < max_lifespan_soup)))) {
+        max_lifespan = other.max_lifespan;
+        max_lifespan_soup = other.max_lifespan_soup;
+    }
+
+    soup_count += other.soup_count;
+    extinct_count += other.extinct_count;
+    still_life_count += other.still_life_count;
+    oscillator_count += other.oscillator_count;
+    unsettled_count += other.unsettled_count;
+    generations += other.generations;
+
+    lifespan_sum += other.lifespan_sum;
+    population_sum += other.population_sum;
+    max_population = std::max(max_population, other.max_population);
+    for (size_t b = 0; b < lifespans.size(); ++b) {
+        lifespans[b] += other.lifespans[b];
+        populations[b] += other.populations[b];
+    }
+    for (const auto& p : other.periods) {
+        periods[p.first] += p.second;
+    }
+}
+
+census::census(const size_t row_count, const size_t col_count, const size_t soup_rows, const size_t soup_cols)
+    : m_row_count(row_count)
+    , m_col_count(col_count)
+    , m_soup_rows(std::min(soup_rows, row_count))
+    , m_soup_cols(std::min(soup_cols, col_count))
+    , m_density(0.5)
+    , m_seed(1)
+    , m_max_generations(10000)
+    , m_max_period(1024)
+    , m_boundary(boundary::boundary_t::dead)
+    , m_next_soup(0)
+{}
+
+void census::run(const uint64_t soup_count)
+{
+    const uint64_t first_soup = m_next_soup;
+    const size_t chunk_count = (soup_count + chunk_soups - 1) / chunk_soups;
+    std::vector<census_report> reports(chunk_count);
+    const auto run_task = [&] (const size_t chunk) {
+        const uint64_t first = first_soup + chunk * chunk_soups;
+        run_chunk(first, std::min(chunk_soups, first_soup + soup_count - first), reports[chunk]);
+    };
+    if (m_p_pool) {
+        m_p_pool->run(chunk_count, run_task);
+    } else {
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            run_task(chunk);
+        }
+    }
+
+    for (const census_report& r : reports) {
+        m_report.merge(r);
+    }
+    m_next_soup += soup_count;
+}
+
+void census::run_chunk(const uint64_t first_soup, const uint64_t soup_count, census_report& report) const
+{
+    engine gl(m_row_count, m_col_count);
+    gl.set_boundary(m_boundary);
+    gl.set_rule(m_rule);
+    gl.set_cycle_detection(m_max_period);
+
+    bit_grid grid;
+    for (uint64_t i = first_soup; i < first_soup + soup_count; ++i) {
+        soup(i, grid);
+        gl.start(grid);
+        while (! gl.cycles().detected() && (gl.generation() < m_max_generations)) {
+            gl.next_step();
+        }
+
+        ++report.soup_count;
+        report.generations += gl.generation();
+        const cycle_detector& cycles = gl.cycles();
+        switch (cycles.state()) {
+        case cycle_detector::state_t::running:
+            ++report.unsettled_count;
+            continue;
+        case cycle_detector::state_t::extinct:
+            ++report.extinct_count;
+            break;
+        case cycle_detector::state_t::still_life:
+            ++report.still_life_count;
+            ++report.periods[1];
+            break;
+        case cycle_detector::state_t::oscillator:
+            ++report.oscillator_count;
+            ++report.periods[cycles.period()];
+            break;
+        }
+
+        // The board is one period past the start of the cycle, in the same
+        // phase.
+        const uint64_t lifespan = cycles.cycle_start();
+        const uint64_t population = gl.population();
+        report.lifespan_sum += lifespan;
+        if ((lifespan > report.max_lifespan) || (report.settled_count() == 1)) {
+            report.max_lifespan = lifespan;
+            report.max_lifespan_soup = i;
+        }
+        ++report.lifespans[census_report::bucket(lifespan)];
+        report.population_sum += population;
+        report.max_population = std::max(report.max_population, population);
+        ++report.populations[census_report::bucket(population)];
+    }
+}
+
+void census::set_density(const double density)
+{
+    m_density = std::clamp(density, 0.0, 1.0);
+}
+
+void census::set_max_period(const size_t period)
+{
+    m_max_period = std::max<size_t>(period, 1);
+}
+
+void census::set_seed(const uint64_t seed)
+{
+    m_seed = seed;
+    m_next_soup = 0;
+    m_report = census_report();
+}
+
+void census::set_thread_count(const size_t count)
+{
+    m_p_pool.reset();
+    if (count != 1) {
+        m_p_pool = std::make_unique<thread_pool>(count);
+    }
+}
+
+void census::soup(const uint64_t index, bit_grid& grid) const
+{
+    grid.resize(m_row_count, m_col_count);
+    soup_random random(m_seed, index);
+    // The density as a share of the generator range; 1 is every cell.
+    const bool is_full = (m_density >= 1.0);
+    const uint64_t threshold = is_full ? UINT64_MAX : (uint64_t)(m_density * 18446744073709551616.0);
+    const size_t row_begin = (m_row_count - m_soup_rows) / 2;
+    const size_t col_begin = (m_col_count - m_soup_cols) / 2;
+    for (size_t r = 0; r < m_soup_rows; ++r) {
+        for (size_t c = 0; c < m_soup_cols; ++c) {
+            if (is_full || (random() < threshold)) {
+                grid.set(row_begin + r, col_begin + c, true);
+            }
+        }
+    }
+}
+
+} // namespace life
@@ -0,0 +1,171 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_CENSUS_H
+#define LIFE_CENSUS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include "engine/bit_grid.h"
+#include "engine/boundary.h"
+#include "engine/rule.h"
+#include "engine/thread_pool.h"
+
+namespace life {
+
+/**
+ * \brief   Statistics of the soups of a census.
+ *
+ * A soup settles when it dies out or its board repeats. Its lifespan is the
+ * first generation of the final cycle and its final population is the one
+ * of that generation. Histograms have power of two buckets: bucket 0 counts
+ * zeros and bucket b the values in [2^(b-1), 2^b).
+ */
+struct census_report final
+{
+    using histogram_t = std::array<uint64_t, 65>;
+
+    uint64_t soup_count = 0;
+    uint64_t extinct_count = 0;
+    uint64_t still_life_count = 0;
+    uint64_t oscillator_count = 0;
+    uint64_t unsettled_count = 0;       ///< Not settled within the generation limit.
+    uint64_t generations = 0;           ///< Stepped by all soups.
+
+    uint64_t lifespan_sum = 0;
+    uint64_t max_lifespan = 0;
+    uint64_t max_lifespan_soup = 0;     ///< Index of the longest lived soup.
+    histogram_t lifespans = {};
+
+    uint64_t population_sum = 0;
+    uint64_t max_population = 0;
+    histogram_t populations = {};
+
+    /// Soups that settled into a still life or an oscillator by period.
+    std::map<uint64_t, uint64_t> periods;
+
+    static size_t bucket(const uint64_t value);
+
+    /// Adds the soups of 'other'. Merging the same reports in the same order
+    /// gives the same result.
+    void merge(const census_report& other);
+
+    uint64_t settled_count() const { return soup_count - unsettled_count; }
+};
+
+/**
+ * \brief   Runs random soups until they settle and gathers their statistics.
+ *
+ * Soup i fills a soup_rows x soup_cols area in the middle of the board with
+ * cells alive at the given density, drawn from a generator seeded by the
+ * master seed and i only. A census is reproducible whatever the thread count
+ * and any soup can be rebuilt with soup(). Soups run in chunks on a thread
+ * pool, each chunk on its own packed engine with cycle detection, and the
+ * chunk reports are merged in soup order.
+ */
+class census final
+{
+public:
+    census(const size_t row_count, const size_t col_count, const size_t soup_rows, const size_t soup_cols);
+
+    boundary::boundary_t boundary() const { return m_boundary; }
+
+    size_t col_count() const { return m_col_count; }
+
+    double density() const { return m_density; }
+
+    uint64_t max_generations() const { return m_max_generations; }
+
+    size_t max_period() const { return m_max_period; }
+
+    /// Index of the next soup run() takes.
+    uint64_t next_soup() const { return m_next_soup; }
+
+    const census_report& report() const { return m_report; }
+
+    size_t row_count() const { return m_row_count; }
+
+    const life::rule& rule() const { return m_rule; }
+
+    /// Runs the next 'soup_count' soups and adds them to the report.
+    void run(const uint64_t soup_count);
+
+    uint64_t seed() const { return m_seed; }
+
+    void set_boundary(const boundary::boundary_t boundary) { m_boundary = boundary; }
+
+    /// Share of live cells in a soup, from 0 to 1.
+    void set_density(const double density);
+
+    /// Soups still running after 'generations' are counted as unsettled.
+    void set_max_generations(const uint64_t generations) { m_max_generations = generations; }
+
+    /// Longest detected period, at least 1.
+    void set_max_period(const size_t period);
+
+    void set_rule(const life::rule& r) { m_rule = r; }
+
+    /// Changing the seed starts the soups over.
+    void set_seed(const uint64_t seed);
+
+    /// Runs soups on 'count' threads, 0 means all CPUs.
+    void set_thread_count(const size_t count);
+
+    /// Board of soup 'index'.
+    void soup(const uint64_t index, bit_grid& grid) const;
+
+    size_t soup_cols() const { return m_soup_cols; }
+
+    size_t soup_rows() const { return m_soup_rows; }
+
+    size_t thread_count() const { return m_p_pool ? m_p_pool->thread_count() : 1; }
+
+private:
+    void run_chunk(const uint64_t first_soup, const uint64_t soup_count, census_report& report) const;
+
+private:
+    size_t m_row_count;
+    size_t m_col_count;
+    size_t m_soup_rows;
+    size_t m_soup_cols;
+
+    double m_density;
+    uint64_t m_seed;
+    uint64_t m_max_generations;
+    size_t m_max_period;
+    life::rule m_rule;
+    boundary::boundary_t m_boundary;
+    std::unique_ptr<thread_pool> m_p_pool;
+
+    uint64_t m_next_soup;
+    census_report m_report;
+};
+
+} // namespace life
+
+#endif // LIFE_CENSUS_H
@@ -0,0 +1,117 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "engine/cycle_detector.h"
+
+namespace life {
+
+cycle_detector::cycle_detector(const size_t history)
+    : m_history(0)
+    , m_state(state_t::running)
+    , m_cycle_start(0)
+    , m_period(0)
+{
+    set_history(history);
+}
+
+bool cycle_detector::push(const uint64_t generation, const uint64_t hash, const bool is_empty)
+{
+    if (detected() || ! enabled()) {
+        return detected();
+    }
+
+    if (is_empty) {
+        m_state = state_t::extinct;
+        m_cycle_start = generation;
+        m_period = 1;
+        return true;
+    }
+
+    slot* p_set = &m_slots[(hash & (m_slots.size() / ways - 1)) * ways];
+    slot* p_victim = nullptr;
+    bool is_victim_free = false;
+    for (size_t i = 0; i < ways; ++i) {
+        slot& s = p_set[i];
+        // Entries older than the history are free.
+        const bool is_free = ! s.is_used || ((generation - s.generation) > m_history);
+        if (! is_free && (s.hash == hash)) {
+            m_period = generation - s.generation;
+            m_cycle_start = s.generation;
+            m_state = (m_period == 1) ? state_t::still_life : state_t::oscillator;
+            return true;
+        }
+        // Prefer a free slot, otherwise replace the oldest state.
+        if (is_free && ! is_victim_free) {
+            p_victim = &s;
+            is_victim_free = true;
+        } else if (! is_victim_free && ((p_victim == nullptr) || (s.generation < p_victim->generation))) {
+            p_victim = &s;
+        }
+    }
+
+    p_victim->hash = hash;
+    p_victim->generation = generation;
+    p_victim->is_used = true;
+    return false;
+}
+
+void cycle_detector::reset()
+{
+    for (slot& s : m_slots) {
+        s = slot();
+    }
+    m_state = state_t::running;
+    m_cycle_start = 0;
+    m_period = 0;
+}
+
+void cycle_detector::set_history(const size_t history)
+{
+    m_history = history;
+
+    // Twice as many slots as states kept, so a set rarely overflows.
+    size_t set_count = 1;
+    while ((set_count * ways) < (history * 2)) {
+        set_count <<= 1;
+    }
+    m_slots.assign((history == 0) ? 0 : set_count * ways, slot());
+    reset();
+}
+
+const char* cycle_detector::state_name(const state_t state)
+{
+    switch (state) {
+    case state_t::running:
+        return "running";
+    case state_t::extinct:
+        return "extinct";
+    case state_t::still_life:
+        return "still life";
+    case state_t::oscillator:
+        return "oscillator";
+    }
+    return "unknown";
+}
+
+} // namespace life
@@ -0,0 +1,101 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_CYCLE_DETECTOR_H
+#define LIFE_CYCLE_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace life {
+
+/**
+ * \brief   Detects extinction, still lifes and oscillators from the hashes
+ *          of consecutive board states.
+ *
+ * Hashes of the last 'history' generations are kept in a small set
+ * associative table, so oscillators with a period up to 'history' are found
+ * one period after they start. Equal 64-bit hashes are taken as equal
+ * boards.
+ */
+class cycle_detector final
+{
+public:
+    enum class state_t
+    {
+        running,
+        extinct,
+        still_life,
+        oscillator
+    };
+
+    explicit cycle_detector(const size_t history = 0);
+
+    /// Generation of the first state of the cycle.
+    uint64_t cycle_start() const { return m_cycle_start; }
+
+    bool detected() const { return m_state != state_t::running; }
+
+    bool enabled() const { return m_history != 0; }
+
+    size_t history() const { return m_history; }
+
+    uint64_t period() const { return m_period; }
+
+    /// Adds the state of 'generation'. Generations must increase.
+    /// \return True if a cycle is detected.
+    bool push(const uint64_t generation, const uint64_t hash, const bool is_empty);
+
+    void reset();
+
+    /// Sets the longest detectable period, 0 disables the detector.
+    void set_history(const size_t history);
+
+    state_t state() const { return m_state; }
+
+    static const char* state_name(const state_t state);
+
+private:
+    struct slot final
+    {
+        uint64_t hash = 0;
+        uint64_t generation = 0;
+        bool is_used = false;
+    };
+
+    static constexpr size_t ways = 4;
+
+private:
+    size_t m_history;
+    std::vector<slot> m_slots;
+
+    state_t m_state;
+    uint64_t m_cycle_start;
+    uint64_t m_period;
+};
+
+} // namespace life
+
+#endif // LIFE_CYCLE_DETECTOR_H
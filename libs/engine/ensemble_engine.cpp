@@ -0,0 +1,312 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "engine/ensemble_engine.h"
+
+#include <algorithm>
+
+namespace life {
+namespace {
+
+using word_t = ensemble_engine::word_t;
+
+/// Bit planes of the live neighbours count of the cells of 64 boards.
+struct neighbour_counts final
+{
+    word_t c0;
+    word_t c1;
+    word_t c2;
+    word_t c3;
+};
+
+/// The rows above and below add three neighbours, the row of the cell two;
+/// the partial sums are added up as in the packed kernels.
+inline neighbour_counts count(const word_t* p_up, const word_t* p_mid, const word_t* p_down)
+{
+    const word_t a_x = p_up[-1] ^ p_up[0];
+    const word_t a_ones = a_x ^ p_up[1];
+    const word_t a_twos = (p_up[-1] & p_up[0]) | (p_up[1] & a_x);
+    const word_t b_ones = p_mid[-1] ^ p_mid[1];
+    const word_t b_twos = p_mid[-1] & p_mid[1];
+    const word_t c_x = p_down[-1] ^ p_down[0];
+    const word_t c_ones = c_x ^ p_down[1];
+    const word_t c_twos = (p_down[-1] & p_down[0]) | (p_down[1] & c_x);
+
+    const word_t ab_x = a_ones ^ b_ones;
+    const word_t ones = ab_x ^ c_ones;
+    const word_t ones_carry = (a_ones & b_ones) | (c_ones & ab_x);
+
+    // The twos add up to at most four: 'x' and 'y' are the carries of the
+    // two pairs, 'z' the one of their sums, set only if neither pair carried.
+    const word_t p = a_twos ^ b_twos;
+    const word_t q = c_twos ^ ones_carry;
+    const word_t x = a_twos & b_twos;
+    const word_t y = c_twos & ones_carry;
+    const word_t z = p & q;
+
+    return {ones, p ^ q, x ^ y ^ z, x & y};
+}
+
+/// 'x' ? 'one' : 'zero', bitwise.
+inline word_t select(const word_t x, const word_t one, const word_t zero)
+{
+    return zero ^ (x & (one ^ zero));
+}
+
+class conway_logic final
+{
+public:
+    explicit conway_logic(const rule&) {}
+
+    word_t next(const neighbour_counts& n, const word_t alive) const { return n.c1 & ~n.c2 & ~n.c3 & (n.c0 | alive); }
+};
+
+/// Any rule, compiled to tables of all-zero or all-one words by count and
+/// looked up with a tree of bitwise selects on the count planes.
+class generic_logic final
+{
+public:
+    explicit generic_logic(const rule& r)
+    {
+        for (size_t n = 0; n <= 8; ++n) {
+            m_birth[n] = ((r.birth() >> n) & 1) ? ~word_t(0) : 0;
+            m_survival[n] = ((r.survival() >> n) & 1) ? ~word_t(0) : 0;
+        }
+    }
+
+    word_t next(const neighbour_counts& n, const word_t alive) const
+    {
+        return select(alive, lookup(m_survival, n), lookup(m_birth, n));
+    }
+
+private:
+    static word_t lookup(const word_t* p_table, const neighbour_counts& n)
+    {
+        const word_t t01 = select(n.c0, p_table[1], p_table[0]);
+        const word_t t23 = select(n.c0, p_table[3], p_table[2]);
+        const word_t t45 = select(n.c0, p_table[5], p_table[4]);
+        const word_t t67 = select(n.c0, p_table[7], p_table[6]);
+        const word_t t03 = select(n.c1, t23, t01);
+        const word_t t47 = select(n.c1, t67, t45);
+        // A count of 8 is the only one with c3 set, its low planes are zero.
+        return select(n.c3, p_table[8], select(n.c2, t47, t03));
+    }
+
+private:
+    word_t m_birth[9];
+    word_t m_survival[9];
+};
+
+/// Steps the cells of a group laid out with halo rows and columns.
+/// \return   Any live cell of every board.
+template<typename TLogic>
+word_t step_cells(const TLogic& logic, const word_t* p_cells, const size_t row_count, const size_t col_count,
+                  const size_t stride, word_t* p_next)
+{
+    word_t any = 0;
+    for (size_t r = 0; r < row_count; ++r) {
+        const word_t* p_mid = p_cells + (r + 1) * stride + 1;
+        word_t* p_out = p_next + (r + 1) * stride + 1;
+        for (size_t c = 0; c < col_count; ++c) {
+            const word_t w = logic.next(count(p_mid + c - stride, p_mid + c, p_mid + c + stride), p_mid[c]);
+            p_out[c] = w;
+            any |= w;
+        }
+    }
+    return any;
+}
+
+} // <anonymous> namespace
+
+ensemble_engine::ensemble_engine(const size_t board_count, const size_t row_count, const size_t col_count)
+    : m_board_count(board_count)
+    , m_row_count(row_count)
+    , m_col_count(col_count)
+    , m_group_count((board_count + group_boards - 1) / group_boards)
+    , m_stride(col_count + 2)
+    , m_group_size((row_count + 2) * (col_count + 2))
+    , m_generation(0)
+    , m_cells(m_group_count * m_group_size, 0)
+    , m_next(m_group_count * m_group_size, 0)
+    , m_alive_boards(m_group_count, 0)
+    , m_extinctions(board_count, 0)
+{}
+
+size_t ensemble_engine::extinct_count() const
+{
+    size_t alive_count = 0;
+    for (const word_t alive : m_alive_boards) {
+        alive_count += __builtin_popcountll(alive);
+    }
+    return m_board_count - alive_count;
+}
+
+ensemble_engine::grid_t ensemble_engine::grid(const size_t board) const
+{
+    grid_t out_grid(m_row_count, row_t(m_col_count, false));
+    for (size_t r = 0; r < m_row_count; ++r) {
+        for (size_t c = 0; c < m_col_count; ++c) {
+            out_grid[r][c] = alive(board, r, c);
+        }
+    }
+    return out_grid;
+}
+
+void ensemble_engine::mark_alive(const size_t group, const word_t any, const uint64_t generation)
+{
+    word_t died = m_alive_boards[group] & ~any;
+    while (died != 0) {
+        m_extinctions[group * group_boards + __builtin_ctzll(died)] = generation;
+        died &= died - 1;
+    }
+    m_alive_boards[group] = any;
+}
+
+bool ensemble_engine::next_step()
+{
+    for (size_t group = 0; group < m_group_count; ++group) {
+        if (m_alive_boards[group] != 0) {
+            step_group(group);
+        }
+    }
+    m_cells.swap(m_next);
+    ++m_generation;
+    return true;
+}
+
+std::vector<uint64_t> ensemble_engine::populations() const
+{
+    std::vector<uint64_t> out_counts(m_board_count, 0);
+    for (size_t group = 0; group < m_group_count; ++group) {
+        if (m_alive_boards[group] == 0) {
+            continue;
+        }
+
+        // Bit-sliced counters: plane i holds bit i of the count of every
+        // board, so a cell costs a few logic operations for 64 boards.
+        word_t planes[64] = {};
+        size_t plane_count = 0;
+        for (size_t r = 0; r < m_row_count; ++r) {
+            for (size_t c = 0; c < m_col_count; ++c) {
+                word_t carry = cell(group, r, c);
+                for (size_t i = 0; carry != 0; ++i) {
+                    const word_t next_carry = planes[i] & carry;
+                    planes[i] ^= carry;
+                    carry = next_carry;
+                    plane_count = std::max(plane_count, i + 1);
+                }
+            }
+        }
+
+        const size_t board_end = std::min(m_board_count, (group + 1) * group_boards);
+        for (size_t board = group * group_boards; board < board_end; ++board) {
+            for (size_t i = 0; i < plane_count; ++i) {
+                out_counts[board] += ((planes[i] >> (board % group_boards)) & 1) << i;
+            }
+        }
+    }
+    return out_counts;
+}
+
+word_t ensemble_engine::scan_group(const size_t group) const
+{
+    word_t any = 0;
+    for (size_t r = 0; r < m_row_count; ++r) {
+        for (size_t c = 0; c < m_col_count; ++c) {
+            any |= cell(group, r, c);
+        }
+    }
+    return any;
+}
+
+void ensemble_engine::set(const size_t board, const size_t row, const size_t col, const bool alive)
+{
+    const size_t group = board / group_boards;
+    const word_t bit = word_t(1) << (board % group_boards);
+    word_t& w = cell(group, row, col);
+    w = alive ? (w | bit) : (w & ~bit);
+    mark_alive(group, alive ? (m_alive_boards[group] | bit) : scan_group(group), m_generation);
+}
+
+bool ensemble_engine::set_board(const size_t board, const grid_t& begin_state)
+{
+    if (board >= m_board_count) {
+        return false;
+    }
+
+    const size_t group = board / group_boards;
+    const word_t bit = word_t(1) << (board % group_boards);
+    for (size_t r = 0; r < m_row_count; ++r) {
+        for (size_t c = 0; c < m_col_count; ++c) {
+            const bool is_alive = (r < begin_state.size()) && (c < begin_state[r].size()) && begin_state[r][c];
+            word_t& w = cell(group, r, c);
+            w = is_alive ? (w | bit) : (w & ~bit);
+        }
+    }
+    mark_alive(group, scan_group(group), m_generation);
+    return true;
+}
+
+bool ensemble_engine::start(const std::vector<grid_t>& begin_states)
+{
+    stop();
+    for (size_t board = 0; board < std::min(begin_states.size(), m_board_count); ++board) {
+        set_board(board, begin_states[board]);
+    }
+    return true;
+}
+
+void ensemble_engine::step_group(const size_t group)
+{
+    const word_t* p_cells = m_cells.data() + group * m_group_size;
+    word_t* p_next = m_next.data() + group * m_group_size;
+    const word_t any = m_rule.is_conway()
+        ? step_cells(conway_logic(m_rule), p_cells, m_row_count, m_col_count, m_stride, p_next)
+        : step_cells(generic_logic(m_rule), p_cells, m_row_count, m_col_count, m_stride, p_next);
+    if (any == 0) {
+        // Dead groups are not stepped any more, so both buffers must hold
+        // the empty boards.
+        std::fill_n(m_cells.data() + group * m_group_size, m_group_size, 0);
+    }
+    mark_alive(group, any, m_generation + 1);
+}
+
+bool ensemble_engine::step_n(const uint64_t generations)
+{
+    for (uint64_t i = 0; i < generations; ++i) {
+        next_step();
+    }
+    return true;
+}
+
+void ensemble_engine::stop()
+{
+    std::fill(m_cells.begin(), m_cells.end(), 0);
+    std::fill(m_next.begin(), m_next.end(), 0);
+    std::fill(m_alive_boards.begin(), m_alive_boards.end(), 0);
+    std::fill(m_extinctions.begin(), m_extinctions.end(), 0);
+    m_generation = 0;
+}
+
+} // namespace life
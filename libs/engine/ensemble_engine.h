@@ -0,0 +1,170 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_ENSEMBLE_ENGINE_H
+#define LIFE_ENSEMBLE_ENGINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/rule.h"
+
+namespace life {
+
+/**
+ * \brief   Engine stepping many independent boards of the same size at once.
+ *
+ * The boards are bit-sliced: boards are grouped by 64 and every cell of a
+ * group is one word whose bit k is the cell of board k of the group. The
+ * neighbours of a cell are plain words, so one pass of the bitwise kernel
+ * over a group advances 64 boards, and the compiler vectorizes the pass
+ * along the rows on top. Groups whose boards all died out are skipped.
+ *
+ * The cells beyond the edges of every board are dead. After every step the
+ * engine records which boards died out and in which generation;
+ * populations() counts the cells of all boards in one pass.
+ */
+class ensemble_engine final
+{
+public:
+    using row_t = std::vector<bool>;
+    using grid_t = std::vector<row_t>;
+
+    using word_t = uint64_t;
+
+    static constexpr size_t group_boards = 64;
+
+    ensemble_engine(const size_t board_count = group_boards, const size_t row_count = 25,
+                    const size_t col_count = 25);
+
+    bool next_step();
+
+    /// Starts board 'board' from 'begin_state' clipped to the board size,
+    /// the other boards keep their cells.
+    bool set_board(const size_t board, const grid_t& begin_state);
+
+    /// Starts every board from the state of the same index, boards without
+    /// one are empty.
+    bool start(const std::vector<grid_t>& begin_states);
+
+    bool step_n(const uint64_t generations);
+
+    template<typename TType>
+    bool set_board(const size_t board, const std::vector<std::vector<TType>>& begin, const TType& alive_val)
+    {
+        grid_t begin_state(std::min(begin.size(), m_row_count));
+        for (size_t r = 0; r < begin_state.size(); ++r) {
+            const std::vector<TType>& row = begin[r];
+            begin_state[r].resize(std::min(row.size(), m_col_count));
+            for (size_t c = 0; c < begin_state[r].size(); ++c) {
+                begin_state[r][c] = (row[c] == alive_val);
+            }
+        }
+
+        return set_board(board, begin_state);
+    }
+
+    bool alive(const size_t board, const size_t row, const size_t col) const
+    {
+        return (cell(board / group_boards, row, col) >> (board % group_boards)) & 1;
+    }
+
+    size_t board_count() const { return m_board_count; }
+
+    size_t col_count() const { return m_col_count; }
+
+    /// Boards that died out.
+    size_t extinct_count() const;
+
+    /// First generation without live cells of a board that died out.
+    uint64_t extinction_generation(const size_t board) const { return m_extinctions[board]; }
+
+    uint64_t generation() const { return m_generation; }
+
+    /// Unpacked copy of a board.
+    grid_t grid(const size_t board) const;
+
+    bool is_extinct(const size_t board) const
+    {
+        return ((m_alive_boards[board / group_boards] >> (board % group_boards)) & 1) == 0;
+    }
+
+    /// Live cells of every board.
+    std::vector<uint64_t> populations() const;
+
+    size_t row_count() const { return m_row_count; }
+
+    const life::rule& rule() const { return m_rule; }
+
+    void set(const size_t board, const size_t row, const size_t col, const bool alive);
+
+    void set_rule(const life::rule& r) { m_rule = r; }
+
+    /// Clears every board.
+    void stop();
+
+private:
+    /// Cell (row, col) of a group, rows and columns -1 are halo cells.
+    word_t& cell(const size_t group, const ptrdiff_t row, const ptrdiff_t col)
+    {
+        return m_cells[group * m_group_size + (row + 1) * m_stride + col + 1];
+    }
+    word_t cell(const size_t group, const ptrdiff_t row, const ptrdiff_t col) const
+    {
+        return m_cells[group * m_group_size + (row + 1) * m_stride + col + 1];
+    }
+
+    /// Takes the boards of a group with any live cell, 'any', and records
+    /// the boards that died out as extinct since 'generation'.
+    void mark_alive(const size_t group, const word_t any, const uint64_t generation);
+
+    /// Any live cell of every board of a group.
+    word_t scan_group(const size_t group) const;
+
+    void step_group(const size_t group);
+
+private:
+    size_t m_board_count;
+    size_t m_row_count;
+    size_t m_col_count;
+    size_t m_group_count;
+
+    // Words per row and per group, halos included.
+    size_t m_stride;
+    size_t m_group_size;
+
+    life::rule m_rule;
+    uint64_t m_generation;
+
+    std::vector<word_t> m_cells;
+    std::vector<word_t> m_next;
+    std::vector<word_t> m_alive_boards;
+    std::vector<uint64_t> m_extinctions;
+};
+
+} // namespace life
+
+#endif // LIFE_ENSEMBLE_ENGINE_H
@@ -0,0 +1,291 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_FIXED_ENGINE_H
+#define LIFE_FIXED_ENGINE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "engine/bit_grid.h"
+#include "engine/rule.h"
+
+namespace life {
+
+/**
+ * \brief   Engine for boards whose size is known at compile time.
+ *
+ * The board lives in a std::array of packed words laid out as in bit_grid,
+ * without halos: every bound is a constant, so the compiler unrolls the
+ * stepping loops and cells beyond the edges are simply read as dead. The
+ * engine allocates nothing, and everything but the grid_t and bit_grid
+ * conversions is constexpr, so boards can be set up and stepped at compile
+ * time. The public API follows life::engine.
+ */
+template<size_t TRows, size_t TCols>
+class fixed_engine final
+{
+    static_assert((TRows > 0) && (TCols > 0), "board must not be empty");
+
+public:
+    using row_t = std::vector<bool>;
+    using grid_t = std::vector<row_t>;
+
+    using word_t = bit_grid::word_t;
+
+    static constexpr size_t word_bits = bit_grid::word_bits;
+    static constexpr size_t words = (TCols + word_bits - 1) / word_bits;
+
+    using board_t = std::array<word_t, TRows * words>;
+
+    constexpr fixed_engine()
+        : m_board()
+        , m_rule()
+        , m_generation(0)
+    {}
+
+    constexpr bool next_step()
+    {
+        m_board = next(m_board, m_rule);
+        ++m_generation;
+        return true;
+    }
+
+    bool restart(const grid_t& begin_state)
+    {
+        stop();
+        return start(begin_state);
+    }
+
+    bool start(const grid_t& begin_state)
+    {
+        m_board = board_t();
+        for (size_t r = 0; r < std::min(begin_state.size(), TRows); ++r) {
+            const row_t& row = begin_state[r];
+            for (size_t c = 0; c < std::min(row.size(), TCols); ++c) {
+                set(r, c, row[c]);
+            }
+        }
+        m_generation = 0;
+        return true;
+    }
+
+    /// Starts from a packed board, clipped to the engine size.
+    bool start(const bit_grid& begin_state)
+    {
+        m_board = board_t();
+        const size_t word_count = std::min(begin_state.words(), words);
+        for (size_t r = 0; r < std::min(begin_state.row_count(), TRows); ++r) {
+            std::copy_n(begin_state.row_ptr(r), word_count, &m_board[r * words]);
+            if (word_count == words) {
+                m_board[r * words + words - 1] &= last_word_mask;
+            }
+        }
+        m_generation = 0;
+        return true;
+    }
+
+    constexpr bool step_n(const uint64_t generations)
+    {
+        for (uint64_t i = 0; i < generations; ++i) {
+            next_step();
+        }
+        return true;
+    }
+
+    template<typename TType>
+    bool start(const std::vector<std::vector<TType>>& begin, const TType& alive_val)
+    {
+        grid_t begin_state(std::min(begin.size(), TRows));
+        for (size_t r = 0; r < begin_state.size(); ++r) {
+            const std::vector<TType>& row = begin[r];
+            begin_state[r].resize(std::min(row.size(), TCols));
+            for (size_t c = 0; c < begin_state[r].size(); ++c) {
+                begin_state[r][c] = (row[c] == alive_val);
+            }
+        }
+
+        return start(begin_state);
+    }
+
+    constexpr bool alive(const size_t row, const size_t col) const
+    {
+        return (m_board[row * words + col / word_bits] >> (col % word_bits)) & 1;
+    }
+
+    /// The packed board, 'words' words per row.
+    constexpr const board_t& board() const { return m_board; }
+
+    static constexpr size_t col_count() { return TCols; }
+
+    constexpr uint64_t generation() const { return m_generation; }
+
+    /// Unpacked copy of the board.
+    grid_t grid() const
+    {
+        grid_t out_grid(TRows, row_t(TCols, false));
+        for (size_t r = 0; r < TRows; ++r) {
+            for (size_t c = 0; c < TCols; ++c) {
+                out_grid[r][c] = alive(r, c);
+            }
+        }
+        return out_grid;
+    }
+
+    constexpr size_t population() const
+    {
+        size_t count = 0;
+        for (const word_t w : m_board) {
+            count += __builtin_popcountll(w);
+        }
+        return count;
+    }
+
+    static constexpr size_t row_count() { return TRows; }
+
+    constexpr const life::rule& rule() const { return m_rule; }
+
+    constexpr void set(const size_t row, const size_t col, const bool alive)
+    {
+        word_t& w = m_board[row * words + col / word_bits];
+        const word_t bit = word_t(1) << (col % word_bits);
+        w = alive ? (w | bit) : (w & ~bit);
+    }
+
+    constexpr void set_generation(const uint64_t generation) { m_generation = generation; }
+
+    constexpr void set_rule(const life::rule& r) { m_rule = r; }
+
+    constexpr void stop()
+    {
+        m_board = board_t();
+        m_generation = 0;
+    }
+
+    /// The board after 'board' under rule 'r'.
+    static constexpr board_t next(const board_t& board, const life::rule& r)
+    {
+        board_t out_board = {};
+        for (size_t row = 0; row < TRows; ++row) {
+            for (size_t word = 0; word < words; ++word) {
+                const word_t alive = board[row * words + word];
+                const counts n = count(board, row, word);
+                word_t next_w = 0;
+                if (r.is_conway()) {
+                    next_w = n.c1 & ~n.c2 & ~n.c3 & (n.c0 | alive);
+                } else {
+                    for (size_t k = 0; k <= 8; ++k) {
+                        if (((r.birth() >> k) & 1) != 0) {
+                            next_w |= n.equal(k) & ~alive;
+                        }
+                        if (((r.survival() >> k) & 1) != 0) {
+                            next_w |= n.equal(k) & alive;
+                        }
+                    }
+                }
+                out_board[row * words + word] = (word + 1 == words) ? (next_w & last_word_mask) : next_w;
+            }
+        }
+        return out_board;
+    }
+
+private:
+    /// Bit planes of the live neighbours count of every cell of a word.
+    struct counts final
+    {
+        word_t c0;
+        word_t c1;
+        word_t c2;
+        word_t c3;
+
+        constexpr word_t equal(const size_t k) const
+        {
+            return ((k & 1) ? c0 : ~c0) & ((k & 2) ? c1 : ~c1) & ((k & 4) ? c2 : ~c2) & ((k & 8) ? c3 : ~c3);
+        }
+    };
+
+    static constexpr word_t last_word_mask =
+        ((TCols % word_bits) == 0) ? ~word_t(0) : (word_t(1) << (TCols % word_bits)) - 1;
+
+private:
+    /// Word 'word' of row 'row', zero beyond the edges.
+    static constexpr word_t at(const board_t& board, const size_t row, const size_t word)
+    {
+        return ((row < TRows) && (word < words)) ? board[row * words + word] : 0;
+    }
+
+    /// Adds up the neighbours as the packed kernels do: the three cells of
+    /// the rows above and below and the two side cells of the row itself,
+    /// then the three partial sums. Row and word -1 wrap to huge indices
+    /// and read as zero.
+    static constexpr counts count(const board_t& board, const size_t row, const size_t word)
+    {
+        constexpr size_t top = word_bits - 1;
+
+        const word_t a[3] = {(at(board, row - 1, word) << 1) | (at(board, row - 1, word - 1) >> top),
+                             at(board, row - 1, word),
+                             (at(board, row - 1, word) >> 1) | (at(board, row - 1, word + 1) << top)};
+        const word_t b[3] = {(at(board, row, word) << 1) | (at(board, row, word - 1) >> top),
+                             at(board, row, word),
+                             (at(board, row, word) >> 1) | (at(board, row, word + 1) << top)};
+        const word_t c[3] = {(at(board, row + 1, word) << 1) | (at(board, row + 1, word - 1) >> top),
+                             at(board, row + 1, word),
+                             (at(board, row + 1, word) >> 1) | (at(board, row + 1, word + 1) << top)};
+
+        const word_t a_x = a[0] ^ a[1];
+        const word_t a_ones = a_x ^ a[2];
+        const word_t a_twos = (a[0] & a[1]) | (a[2] & a_x);
+        const word_t b_ones = b[0] ^ b[2];
+        const word_t b_twos = b[0] & b[2];
+        const word_t c_x = c[0] ^ c[1];
+        const word_t c_ones = c_x ^ c[2];
+        const word_t c_twos = (c[0] & c[1]) | (c[2] & c_x);
+
+        const word_t ab_x = a_ones ^ b_ones;
+        const word_t ones = ab_x ^ c_ones;
+        const word_t ones_carry = (a_ones & b_ones) | (c_ones & ab_x);
+
+        // The twos add up to at most four: 'x' and 'y' are the carries of
+        // the two pairs, 'z' the one of their sums, set only if neither
+        // pair carried.
+        const word_t p = a_twos ^ b_twos;
+        const word_t q = c_twos ^ ones_carry;
+        const word_t x = a_twos & b_twos;
+        const word_t y = c_twos & ones_carry;
+        const word_t z = p & q;
+
+        return {ones, p ^ q, x ^ y ^ z, x & y};
+    }
+
+private:
+    board_t m_board;
+    life::rule m_rule;
+    uint64_t m_generation;
+};
+
+} // namespace life
+
+#endif // LIFE_FIXED_ENGINE_H
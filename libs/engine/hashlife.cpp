@@ -0,0 +1,528 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "engine/hashlife.h"
+
+namespace life {
+namespace {
+
+constexpr size_t min_bucket_count = size_t(1) << 16;
+
+template<typename TIndex>
+uint64_t node_hash(const TIndex nw, const TIndex ne, const TIndex sw, const TIndex se)
+{
+    uint64_t h = nw;
+    h = h * 0x9E3779B97F4A7C15ull + ne;
+    h = h * 0x9E3779B97F4A7C15ull + sw;
+    h = h * 0x9E3779B97F4A7C15ull + se;
+    return h ^ (h >> 29);
+}
+
+size_t state_rows(const hashlife::grid_t& state) { return state.size(); }
+
+size_t state_rows(const bit_grid& state) { return state.row_count(); }
+
+bool state_cell(const hashlife::grid_t& state, const size_t row, const size_t col)
+{
+    return (col < state[row].size()) && state[row][col];
+}
+
+bool state_cell(const bit_grid& state, const size_t row, const size_t col)
+{
+    return (col < state.col_count()) && state.get(row, col);
+}
+
+} // <anonymous> namespace
+
+hashlife::hashlife(const size_t row_count, const size_t col_count)
+    : m_row_count(row_count)
+    , m_col_count(col_count)
+    , m_memory_limit(default_memory_limit)
+    , m_gc_limit(default_memory_limit)
+{
+    stop();
+}
+
+bool hashlife::advance(uint64_t generations)
+{
+    for (uint8_t step = 0; generations != 0; ++step, generations >>= 1) {
+        if ((generations & 1) != 0) {
+            jump(step);
+        }
+    }
+    return true;
+}
+
+bool hashlife::alive(const int64_t row, const int64_t col) const
+{
+    index_t idx = m_root;
+    int64_t half = int64_t(1) << (m_nodes[idx].level - 1);
+    int64_t top = -half;
+    int64_t left = -half;
+    if ((row < top) || (row >= half) || (col < left) || (col >= half)) {
+        return false;
+    }
+
+    while (m_nodes[idx].level > 0) {
+        const node& n = m_nodes[idx];
+        if (n.population == 0) {
+            return false;
+        }
+        half = int64_t(1) << (n.level - 1);
+        const bool is_south = (row >= top + half);
+        const bool is_east = (col >= left + half);
+        top += is_south ? half : 0;
+        left += is_east ? half : 0;
+        idx = is_south ? (is_east ? n.se : n.sw) : (is_east ? n.ne : n.nw);
+    }
+    return (idx == alive_leaf);
+}
+
+hashlife::index_t hashlife::base_result(const index_t idx)
+{
+    // Unpack the 4x4 node and apply the rule to its 2x2 center.
+    bool cells[4][4];
+    const node& n = m_nodes[idx];
+    const index_t quads[4] = {n.nw, n.ne, n.sw, n.se};
+    for (size_t q = 0; q < 4; ++q) {
+        const node& child = m_nodes[quads[q]];
+        const size_t r = (q / 2) * 2;
+        const size_t c = (q % 2) * 2;
+        cells[r][c] = (child.nw == alive_leaf);
+        cells[r][c + 1] = (child.ne == alive_leaf);
+        cells[r + 1][c] = (child.sw == alive_leaf);
+        cells[r + 1][c + 1] = (child.se == alive_leaf);
+    }
+
+    index_t next[4];
+    for (size_t i = 0; i < 4; ++i) {
+        const size_t r = 1 + i / 2;
+        const size_t c = 1 + i % 2;
+        size_t n_count = 0;
+        for (size_t nr = r - 1; nr <= r + 1; ++nr) {
+            for (size_t nc = c - 1; nc <= c + 1; ++nc) {
+                n_count += cells[nr][nc] ? 1 : 0;
+            }
+        }
+        n_count -= cells[r][c] ? 1 : 0;
+        next[i] = m_rule.next(cells[r][c], n_count) ? alive_leaf : dead_leaf;
+    }
+    return find_or_create(next[0], next[1], next[2], next[3]);
+}
+
+template<typename TState>
+hashlife::index_t hashlife::build(const TState& state, const uint8_t level, const int64_t top, const int64_t left)
+{
+    const int64_t size = int64_t(1) << level;
+    if ((top >= (int64_t)state_rows(state)) || (left >= (int64_t)m_col_count) || (top + size <= 0)
+        || (left + size <= 0)) {
+        return empty(level);
+    }
+    if (level == 0) {
+        return state_cell(state, top, left) ? alive_leaf : dead_leaf;
+    }
+
+    const int64_t half = size / 2;
+    const size_t mark = m_protected.size();
+    const index_t nw = build(state, level - 1, top, left);
+    m_protected.push_back(nw);
+    const index_t ne = build(state, level - 1, top, left + half);
+    m_protected.push_back(ne);
+    const index_t sw = build(state, level - 1, top + half, left);
+    m_protected.push_back(sw);
+    const index_t se = build(state, level - 1, top + half, left + half);
+    m_protected.resize(mark);
+
+    return find_or_create(nw, ne, sw, se);
+}
+
+hashlife::index_t hashlife::center(const index_t idx)
+{
+    const node& n = m_nodes[idx];
+    return find_or_create(m_nodes[n.nw].se, m_nodes[n.ne].sw, m_nodes[n.sw].ne, m_nodes[n.se].nw);
+}
+
+hashlife::index_t hashlife::empty(const uint8_t level)
+{
+    while (m_empty.size() <= level) {
+        const index_t e = m_empty.back();
+        const index_t next = find_or_create(e, e, e, e);
+        m_empty.push_back(next);
+    }
+    return m_empty[level];
+}
+
+hashlife::index_t hashlife::expand(const index_t idx)
+{
+    const size_t mark = m_protected.size();
+    m_protected.push_back(idx);
+
+    const index_t e = empty(m_nodes[idx].level - 1);
+    const node n = m_nodes[idx];
+    index_t quads[4];
+    quads[0] = find_or_create(e, e, e, n.nw);
+    m_protected.push_back(quads[0]);
+    quads[1] = find_or_create(e, e, n.ne, e);
+    m_protected.push_back(quads[1]);
+    quads[2] = find_or_create(e, n.sw, e, e);
+    m_protected.push_back(quads[2]);
+    quads[3] = find_or_create(n.se, e, e, e);
+
+    const index_t r = find_or_create(quads[0], quads[1], quads[2], quads[3]);
+    m_protected.resize(mark);
+    return r;
+}
+
+void hashlife::fill_window(const index_t idx, const int64_t top, const int64_t left) const
+{
+    const node& n = m_nodes[idx];
+    const int64_t size = int64_t(1) << n.level;
+    if ((n.population == 0) || (top >= (int64_t)m_row_count) || (left >= (int64_t)m_col_count) ||
+        (top + size <= 0) || (left + size <= 0)) {
+        return;
+    }
+    if (n.level == 0) {
+        m_grid_view[top][left] = true;
+        return;
+    }
+
+    const int64_t half = size / 2;
+    fill_window(n.nw, top, left);
+    fill_window(n.ne, top, left + half);
+    fill_window(n.sw, top + half, left);
+    fill_window(n.se, top + half, left + half);
+}
+
+hashlife::index_t hashlife::find_or_create(const index_t nw, const index_t ne, const index_t sw, const index_t se)
+{
+    const uint64_t h = node_hash(nw, ne, sw, se);
+
+    for (index_t i = m_buckets[h & (m_buckets.size() - 1)]; i != nil; i = m_nodes[i].next) {
+        const node& n = m_nodes[i];
+        if ((n.nw == nw) && (n.ne == ne) && (n.sw == sw) && (n.se == se)) {
+            return i;
+        }
+    }
+
+    if ((m_free_list == nil) && (memory_usage() + sizeof(node) > m_gc_limit)) {
+        const size_t mark = m_protected.size();
+        m_protected.insert(m_protected.end(), {nw, ne, sw, se});
+        gc();
+        m_protected.resize(mark);
+        // Everything left is in use: let the cache outgrow the limit by a
+        // quarter instead of collecting again on every new node.
+        if (m_free_count < m_nodes.size() / 4) {
+            m_gc_limit = std::max(m_memory_limit, memory_usage() + memory_usage() / 4);
+        }
+    }
+    if (node_count() >= m_buckets.size()) {
+        rehash(m_buckets.size() * 2);
+    }
+
+    index_t idx = m_free_list;
+    if (idx != nil) {
+        m_free_list = m_nodes[idx].next;
+        --m_free_count;
+    } else {
+        idx = (index_t)m_nodes.size();
+        m_nodes.emplace_back();
+    }
+
+    const node& c_nw = m_nodes[nw];
+    const node& c_ne = m_nodes[ne];
+    const node& c_sw = m_nodes[sw];
+    const node& c_se = m_nodes[se];
+
+    node& n = m_nodes[idx];
+    n.nw = nw;
+    n.ne = ne;
+    n.sw = sw;
+    n.se = se;
+    n.result = nil;
+    n.population = c_nw.population + c_ne.population + c_sw.population + c_se.population;
+    n.level = c_nw.level + 1;
+    n.result_step = 0;
+    n.is_marked = false;
+
+    const size_t bucket = h & (m_buckets.size() - 1);
+    n.next = m_buckets[bucket];
+    m_buckets[bucket] = idx;
+    return idx;
+}
+
+void hashlife::gc()
+{
+    for (node& n : m_nodes) {
+        n.is_marked = false;
+    }
+    mark(dead_leaf);
+    mark(alive_leaf);
+    mark(m_root);
+    for (const index_t idx : m_empty) {
+        mark(idx);
+    }
+    for (const index_t idx : m_protected) {
+        mark(idx);
+    }
+
+    std::fill(m_buckets.begin(), m_buckets.end(), nil);
+    m_free_list = nil;
+    m_free_count = 0;
+    for (index_t i = alive_leaf + 1; i < (index_t)m_nodes.size(); ++i) {
+        node& n = m_nodes[i];
+        if (! n.is_marked) {
+            n.level = free_level;
+            n.result = nil;
+            n.next = m_free_list;
+            m_free_list = i;
+            ++m_free_count;
+            continue;
+        }
+
+        if ((n.result != nil) && (! m_nodes[n.result].is_marked)) {
+            n.result = nil;
+        }
+
+        const size_t bucket = node_hash(n.nw, n.ne, n.sw, n.se) & (m_buckets.size() - 1);
+        n.next = m_buckets[bucket];
+        m_buckets[bucket] = i;
+    }
+}
+
+const hashlife::grid_t& hashlife::grid() const
+{
+    m_grid_view.resize(m_row_count);
+    for (row_t& row : m_grid_view) {
+        row.assign(m_col_count, false);
+    }
+
+    const int64_t half = int64_t(1) << (m_nodes[m_root].level - 1);
+    fill_window(m_root, -half, -half);
+    return m_grid_view;
+}
+
+bool hashlife::is_centered(const index_t idx) const
+{
+    // The pattern must stay inside the inner quarter, so that 2^(level - 3)
+    // generations can not carry it out of the center half.
+    const node& n = m_nodes[idx];
+    const node& nw = m_nodes[n.nw];
+    const node& ne = m_nodes[n.ne];
+    const node& sw = m_nodes[n.sw];
+    const node& se = m_nodes[n.se];
+    const uint64_t inner = m_nodes[m_nodes[nw.se].se].population + m_nodes[m_nodes[ne.sw].sw].population +
+                           m_nodes[m_nodes[sw.ne].ne].population + m_nodes[m_nodes[se.nw].nw].population;
+    return (inner == n.population);
+}
+
+void hashlife::jump(const uint8_t step)
+{
+    while ((m_nodes[m_root].level < step + 3) || (! is_centered(m_root))) {
+        m_root = expand(m_root);
+    }
+    m_root = result(m_root, step);
+    m_generation += uint64_t(1) << step;
+}
+
+template<typename TState>
+bool hashlife::load(const TState& begin_state)
+{
+    stop();
+
+    const size_t size = std::max<size_t>(std::max(m_row_count, m_col_count), 1);
+    uint8_t level = 3;
+    while ((size_t(1) << (level - 1)) < size) {
+        ++level;
+    }
+    const int64_t half = int64_t(1) << (level - 1);
+    m_root = build(begin_state, level, -half, -half);
+    return true;
+}
+
+void hashlife::mark(const index_t idx)
+{
+    node& n = m_nodes[idx];
+    if (n.is_marked) {
+        return;
+    }
+    n.is_marked = true;
+    if (n.level > 0) {
+        mark(n.nw);
+        mark(n.ne);
+        mark(n.sw);
+        mark(n.se);
+    }
+}
+
+size_t hashlife::memory_usage() const
+{
+    return m_nodes.size() * sizeof(node) + m_buckets.size() * sizeof(index_t);
+}
+
+uint64_t hashlife::population() const
+{
+    return m_nodes[m_root].population;
+}
+
+void hashlife::rehash(const size_t bucket_count)
+{
+    m_buckets.assign(bucket_count, nil);
+    for (index_t i = alive_leaf + 1; i < (index_t)m_nodes.size(); ++i) {
+        node& n = m_nodes[i];
+        if (n.level == free_level) {
+            continue;
+        }
+        const size_t bucket = node_hash(n.nw, n.ne, n.sw, n.se) & (bucket_count - 1);
+        n.next = m_buckets[bucket];
+        m_buckets[bucket] = i;
+    }
+}
+
+bool hashlife::restart(const grid_t& begin_state)
+{
+    stop();
+    return start(begin_state);
+}
+
+hashlife::index_t hashlife::result(const index_t idx, const uint8_t step)
+{
+    {
+        const node& n = m_nodes[idx];
+        if ((n.result != nil) && (n.result_step == step)) {
+            return n.result;
+        }
+        if (n.population == 0) {
+            return empty(n.level - 1);
+        }
+    }
+
+    const uint8_t level = m_nodes[idx].level;
+    index_t r;
+    if (level == 2) {
+        r = base_result(idx);
+    } else {
+        const size_t mark = m_protected.size();
+        m_protected.push_back(idx);
+
+        const node n = m_nodes[idx];
+        const node nw = m_nodes[n.nw];
+        const node ne = m_nodes[n.ne];
+        const node sw = m_nodes[n.sw];
+        const node se = m_nodes[n.se];
+
+        // Nine overlapping subnodes of half size...
+        index_t sub[9];
+        sub[0] = n.nw;
+        sub[1] = find_or_create(nw.ne, ne.nw, nw.se, ne.sw);
+        m_protected.push_back(sub[1]);
+        sub[2] = n.ne;
+        sub[3] = find_or_create(nw.sw, nw.se, sw.nw, sw.ne);
+        m_protected.push_back(sub[3]);
+        sub[4] = find_or_create(nw.se, ne.sw, sw.ne, se.nw);
+        m_protected.push_back(sub[4]);
+        sub[5] = find_or_create(ne.sw, ne.se, se.nw, se.ne);
+        m_protected.push_back(sub[5]);
+        sub[6] = n.sw;
+        sub[7] = find_or_create(sw.ne, se.nw, sw.se, se.sw);
+        m_protected.push_back(sub[7]);
+        sub[8] = n.se;
+
+        // ...are advanced by the first half of the step (or just cropped for
+        // steps shorter than the node allows), the four overlapping quarters
+        // of the result are advanced by the rest.
+        const bool is_full = (step == level - 2);
+        for (index_t& s : sub) {
+            s = is_full ? result(s, step - 1) : center(s);
+            m_protected.push_back(s);
+        }
+
+        index_t quads[4];
+        quads[0] = find_or_create(sub[0], sub[1], sub[3], sub[4]);
+        m_protected.push_back(quads[0]);
+        quads[1] = find_or_create(sub[1], sub[2], sub[4], sub[5]);
+        m_protected.push_back(quads[1]);
+        quads[2] = find_or_create(sub[3], sub[4], sub[6], sub[7]);
+        m_protected.push_back(quads[2]);
+        quads[3] = find_or_create(sub[4], sub[5], sub[7], sub[8]);
+        m_protected.push_back(quads[3]);
+
+        for (index_t& q : quads) {
+            q = result(q, is_full ? step - 1 : step);
+            m_protected.push_back(q);
+        }
+
+        r = find_or_create(quads[0], quads[1], quads[2], quads[3]);
+        m_protected.resize(mark);
+    }
+
+    node& n = m_nodes[idx];
+    n.result = r;
+    n.result_step = step;
+    return r;
+}
+
+void hashlife::set_rule(const life::rule& r)
+{
+    m_rule = r;
+    for (node& n : m_nodes) {
+        n.result = nil;
+    }
+}
+
+bool hashlife::start(const grid_t& begin_state)
+{
+    return load(begin_state);
+}
+
+bool hashlife::start(const bit_grid& begin_state)
+{
+    return load(begin_state);
+}
+
+void hashlife::stop()
+{
+    m_nodes.clear();
+    m_nodes.resize(2);
+    for (const index_t leaf : {dead_leaf, alive_leaf}) {
+        node& n = m_nodes[leaf];
+        n.nw = n.ne = n.sw = n.se = nil;
+        n.next = nil;
+        n.result = nil;
+        n.population = (leaf == alive_leaf) ? 1 : 0;
+        n.level = 0;
+        n.result_step = 0;
+        n.is_marked = false;
+    }
+
+    m_buckets.assign(min_bucket_count, nil);
+    m_empty.assign(1, dead_leaf);
+    m_protected.clear();
+    m_free_list = nil;
+    m_free_count = 0;
+    m_generation = 0;
+    m_gc_limit = m_memory_limit;
+    m_root = empty(3);
+}
+
+} // namespace life
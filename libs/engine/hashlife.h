@@ -0,0 +1,193 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_HASHLIFE_H
+#define LIFE_HASHLIFE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "engine/bit_grid.h"
+#include "engine/rule.h"
+
+namespace life {
+
+/**
+ * \brief   HashLife engine for Conway's Game of Life.
+ *
+ * The universe is a hash-consed quadtree: equal subtrees are stored once
+ * and the future of every node is memoized, so regular patterns can be
+ * advanced by huge powers of two in one call. The universe is unbounded;
+ * grid() shows the row_count() x col_count() window at the origin.
+ *
+ * The node cache is capped by set_memory_limit(). When the cap is hit,
+ * nodes unreachable from the current state are garbage collected.
+ */
+class hashlife final
+{
+public:
+    using row_t = std::vector<bool>;
+    using grid_t = std::vector<row_t>;
+
+    static constexpr size_t default_memory_limit = size_t(512) << 20;
+
+    hashlife(const size_t row_count = 25, const size_t col_count = 25);
+
+    /// Advances the universe by 'generations', one power of two per jump.
+    bool advance(uint64_t generations);
+
+    bool next_step() { return advance(1); }
+
+    bool step_n(const uint64_t generations) { return advance(generations); }
+
+    bool restart(const grid_t& begin_state);
+
+    bool start(const grid_t& begin_state);
+
+    /// Starts from a packed board, clipped to the window size.
+    bool start(const bit_grid& begin_state);
+
+    template<typename TType>
+    bool start(const std::vector<std::vector<TType>>& begin, const TType& alive_val)
+    {
+        grid_t begin_state(std::min(begin.size(), m_row_count));
+        for (size_t r = 0; r < begin_state.size(); ++r) {
+            const std::vector<TType>& row = begin[r];
+            begin_state[r].resize(std::min(row.size(), m_col_count));
+            for (size_t c = 0; c < begin_state[r].size(); ++c) {
+                begin_state[r][c] = (row[c] == alive_val);
+            }
+        }
+
+        return start(begin_state);
+    }
+
+    bool alive(const int64_t row, const int64_t col) const;
+
+    size_t col_count() const { return m_col_count; }
+
+    /// Forces a garbage collection of the node cache.
+    void gc();
+
+    uint64_t generation() const { return m_generation; }
+
+    /// The row_count() x col_count() window of the universe at the origin.
+    const grid_t& grid() const;
+
+    size_t memory_limit() const { return m_memory_limit; }
+
+    size_t memory_usage() const;
+
+    size_t node_count() const { return m_nodes.size() - m_free_count; }
+
+    uint64_t population() const;
+
+    size_t row_count() const { return m_row_count; }
+
+    const life::rule& rule() const { return m_rule; }
+
+    /// Caps the node cache size in bytes. The cap is soft: the nodes of the
+    /// current state and of the jump in progress are never collected.
+    void set_memory_limit(const size_t bytes) { m_memory_limit = m_gc_limit = bytes; }
+
+    /// Sets the rule and forgets the futures memoized with the old one.
+    void set_rule(const life::rule& r);
+
+    void stop();
+
+private:
+    using index_t = uint32_t;
+
+    struct node final
+    {
+        index_t nw;
+        index_t ne;
+        index_t sw;
+        index_t se;
+        index_t next;           ///< Hash chain or free list link.
+        index_t result;         ///< Memoized future of the center.
+        uint64_t population;
+        uint8_t level;          ///< Node is (2^level x 2^level) cells.
+        uint8_t result_step;    ///< 'result' is 2^result_step generations ahead.
+        bool is_marked;
+    };
+
+    static constexpr index_t nil = UINT32_MAX;
+    static constexpr index_t dead_leaf = 0;
+    static constexpr index_t alive_leaf = 1;
+    static constexpr uint8_t free_level = UINT8_MAX;
+
+private:
+    index_t base_result(const index_t idx);
+
+    template<typename TState>
+    index_t build(const TState& state, const uint8_t level, const int64_t top, const int64_t left);
+
+    index_t center(const index_t idx);
+
+    index_t empty(const uint8_t level);
+
+    index_t expand(const index_t idx);
+
+    void fill_window(const index_t idx, const int64_t top, const int64_t left) const;
+
+    index_t find_or_create(const index_t nw, const index_t ne, const index_t sw, const index_t se);
+
+    bool is_centered(const index_t idx) const;
+
+    void jump(const uint8_t step);
+
+    template<typename TState>
+    bool load(const TState& begin_state);
+
+    void mark(const index_t idx);
+
+    void rehash(const size_t bucket_count);
+
+    index_t result(const index_t idx, const uint8_t step);
+
+private:
+    size_t m_row_count;
+    size_t m_col_count;
+    size_t m_memory_limit;
+    size_t m_gc_limit;
+    life::rule m_rule;
+
+    std::vector<node> m_nodes;
+    std::vector<index_t> m_buckets;
+    std::vector<index_t> m_empty;
+    std::vector<index_t> m_protected;
+    index_t m_free_list;
+    size_t m_free_count;
+
+    index_t m_root;
+    uint64_t m_generation;
+
+    mutable grid_t m_grid_view;
+};
+
+} // namespace life
+
+#endif // LIFE_HASHLIFE_H
@@ -0,0 +1,142 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "engine/kernel.h"
+
+namespace life {
+namespace kernel {
+namespace {
+
+bool cpu_supports(const isa_t isa)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (isa) {
+    case isa_t::scalar:
+        return true;
+    case isa_t::avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    case isa_t::avx512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt");
+    }
+    return false;
+#else
+    return (isa == isa_t::scalar);
+#endif
+}
+
+} // <anonymous> namespace
+
+isa_t best_isa()
+{
+    static const isa_t isa = [] () -> isa_t {
+        for (const isa_t i : {isa_t::avx512, isa_t::avx2}) {
+            if (step_fn(i) != nullptr) {
+                return i;
+            }
+        }
+        return isa_t::scalar;
+    }();
+    return isa;
+}
+
+const char* isa_name(const isa_t isa)
+{
+    switch (isa) {
+    case isa_t::scalar:
+        return "scalar";
+    case isa_t::avx2:
+        return "avx2";
+    case isa_t::avx512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+bool kind_from_string(const std::string& name, kind_t& kind)
+{
+    if (name == "adder") {
+        kind = kind_t::adder;
+    } else if (name == "table") {
+        kind = kind_t::table;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* kind_name(const kind_t kind)
+{
+    switch (kind) {
+    case kind_t::adder:
+        return "adder";
+    case kind_t::table:
+        return "table";
+    }
+    return "unknown";
+}
+
+step_fn_t step_fn(const isa_t isa, const bool count, const bool is_generic)
+{
+    if (! cpu_supports(isa)) {
+        return nullptr;
+    }
+
+    switch (isa) {
+    case isa_t::scalar:
+        if (is_generic) {
+            return count ? details::step_scalar<true, true> : details::step_scalar<false, true>;
+        }
+        return count ? details::step_scalar<true, false> : details::step_scalar<false, false>;
+    case isa_t::avx2:
+#if defined(LIFE_KERNEL_AVX2)
+        if (is_generic) {
+            return count ? details::step_avx2<true, true> : details::step_avx2<false, true>;
+        }
+        return count ? details::step_avx2<true, false> : details::step_avx2<false, false>;
+#else
+        return nullptr;
+#endif
+    case isa_t::avx512:
+#if defined(LIFE_KERNEL_AVX512)
+        if (is_generic) {
+            return count ? details::step_avx512<true, true> : details::step_avx512<false, true>;
+        }
+        return count ? details::step_avx512<true, false> : details::step_avx512<false, false>;
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+step_fn_t step_fn(const kind_t kind, const isa_t isa, const bool count, const bool is_generic)
+{
+    if (kind == kind_t::table) {
+        return count ? details::step_table<true> : details::step_table<false>;
+    }
+    return step_fn(isa, count, is_generic);
+}
+
+} // namespace kernel
+} // namespace life
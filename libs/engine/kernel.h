@@ -0,0 +1,116 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_KERNEL_H
+#define LIFE_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "engine/bit_grid.h"
+#include "engine/rule.h"
+
+namespace life {
+namespace kernel {
+
+/**
+ * \brief   Instruction sets the stepping kernel is built for.
+ */
+enum class isa_t
+{
+    scalar,     ///< 64 cells per operation, portable.
+    avx2,       ///< 256 cells per operation.
+    avx512      ///< 512 cells per operation.
+};
+
+/**
+ * \brief   Ways the stepping kernel computes the next generation.
+ */
+enum class kind_t
+{
+    adder,      ///< Bit-parallel adder networks, built for every instruction set.
+    table       ///< 2x2 cell blocks looked up by their 4x4 neighbourhood, portable.
+};
+
+/**
+ * \brief   Result of a block step. Births and deaths are counted only by
+ *          the counting kernels.
+ */
+struct block_stats final
+{
+    bool changed = false;
+    uint64_t births = 0;
+    uint64_t deaths = 0;
+};
+
+/**
+ * \brief   Computes the block of rows [row_begin, row_end) and data words
+ *          [word_begin, word_end) of the next generation of 'src' into 'dst'.
+ *          Both grids must have the same size. Only generic kernels use
+ *          'r', the others always step Conway's rule.
+ * \return  Whether the block changed and, for counting kernels, its births
+ *          and deaths.
+ */
+using step_fn_t = block_stats (*)(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                           const size_t word_begin, const size_t word_end, const rule& r);
+
+/// The widest instruction set supported by both the build and the host CPU.
+isa_t best_isa();
+
+const char* isa_name(const isa_t isa);
+
+bool kind_from_string(const std::string& name, kind_t& kind);
+
+const char* kind_name(const kind_t kind);
+
+/// Kernel for the instruction set or nullptr if it is not supported.
+/// Counting kernels are slower, use them only when the counts are needed.
+/// Generic kernels step any rule, the others are a fast path for Conway's.
+step_fn_t step_fn(const isa_t isa, const bool count = false, const bool is_generic = false);
+
+/// Kernel of the kind. Table kernels are portable, step any rule and ignore
+/// 'isa' and 'is_generic'.
+step_fn_t step_fn(const kind_t kind, const isa_t isa, const bool count, const bool is_generic);
+
+namespace details {
+
+template<bool TCount, bool TGeneric>
+block_stats step_scalar(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                        const size_t word_begin, const size_t word_end, const rule& r);
+template<bool TCount, bool TGeneric>
+block_stats step_avx2(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                      const size_t word_begin, const size_t word_end, const rule& r);
+template<bool TCount, bool TGeneric>
+block_stats step_avx512(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                        const size_t word_begin, const size_t word_end, const rule& r);
+template<bool TCount>
+block_stats step_table(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                       const size_t word_begin, const size_t word_end, const rule& r);
+
+} // namespace details
+} // namespace kernel
+} // namespace life
+
+#endif // LIFE_KERNEL_H
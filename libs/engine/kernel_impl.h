@@ -0,0 +1,365 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_KERNEL_IMPL_H
+#define LIFE_KERNEL_IMPL_H
+
+#include <cstring>
+#include <type_traits>
+
+#include "engine/bit_grid.h"
+#include "engine/kernel.h"
+
+/*
+ * Word-parallel implementation of the stepping kernel. Every translation
+ * unit that includes this header gets its own copy (anonymous namespace),
+ * compiled with the instruction set flags of that unit, so copies built for
+ * different instruction sets are never merged by the linker.
+ */
+
+namespace life {
+namespace kernel {
+namespace {
+
+using word_t = bit_grid::word_t;
+
+template<typename TVec>
+struct vec_traits
+{
+    static constexpr size_t lanes = sizeof(TVec) / sizeof(word_t);
+
+    static TVec load(const word_t* p)
+    {
+        TVec v;
+        std::memcpy(&v, p, sizeof(TVec));
+        return v;
+    }
+
+    static void store(word_t* p, const TVec& v) { std::memcpy(p, &v, sizeof(TVec)); }
+};
+
+/*
+ * Conway's rule for (8 * sizeof(TVec)) cells at once. Every pointer
+ * addresses the same column of the row above, the row and the row below.
+ * The eight neighbour bits are summed with full adders: 'ones' is the low
+ * bit of the count, the remaining four carries have weight two. A cell is
+ * alive if exactly one carry is set (count 2 or 3) and either the count is
+ * odd (3) or the cell is already alive (2).
+ */
+template<typename TVec>
+inline TVec next_state(const word_t* p_up, const word_t* p_mid, const word_t* p_down)
+{
+    using traits = vec_traits<TVec>;
+    constexpr size_t top = bit_grid::word_bits - 1;
+
+    const TVec a = traits::load(p_up);
+    const TVec a_w = (a << 1) | (traits::load(p_up - 1) >> top);
+    const TVec a_e = (a >> 1) | (traits::load(p_up + 1) << top);
+    const TVec b = traits::load(p_mid);
+    const TVec b_w = (b << 1) | (traits::load(p_mid - 1) >> top);
+    const TVec b_e = (b >> 1) | (traits::load(p_mid + 1) << top);
+    const TVec c = traits::load(p_down);
+    const TVec c_w = (c << 1) | (traits::load(p_down - 1) >> top);
+    const TVec c_e = (c >> 1) | (traits::load(p_down + 1) << top);
+
+    const TVec a_x = a_w ^ a;
+    const TVec a_ones = a_x ^ a_e;
+    const TVec a_twos = (a_w & a) | (a_e & a_x);
+    const TVec b_ones = b_w ^ b_e;
+    const TVec b_twos = b_w & b_e;
+    const TVec c_x = c_w ^ c;
+    const TVec c_ones = c_x ^ c_e;
+    const TVec c_twos = (c_w & c) | (c_e & c_x);
+
+    const TVec ab_x = a_ones ^ b_ones;
+    const TVec ones = ab_x ^ c_ones;
+    const TVec ones_carry = (a_ones & b_ones) | (c_ones & ab_x);
+
+    const TVec p = a_twos ^ b_twos;
+    const TVec q = c_twos ^ ones_carry;
+    const TVec twos_many = (a_twos & b_twos) | (c_twos & ones_carry) | (p & q);
+
+    return (p ^ q) & ~twos_many & (ones | b);
+}
+
+/// All lanes set to 'w'.
+template<typename TVec>
+inline TVec splat(const word_t w)
+{
+    if constexpr (vec_traits<TVec>::lanes == 1) {
+        return w;
+    } else {
+        TVec v;
+        for (size_t i = 0; i < vec_traits<TVec>::lanes; ++i) {
+            v[i] = w;
+        }
+        return v;
+    }
+}
+
+/*
+ * Any outer totalistic rule. The neighbour count is summed with the same
+ * full adders as in next_state() but kept whole, as the bit planes c0..c3.
+ * The rule is compiled to two tables of nine all-zero or all-one vectors,
+ * birth and survival by count, looked up with a tree of bitwise selects on
+ * the count planes.
+ */
+template<typename TVec>
+class generic_rule final
+{
+public:
+    explicit generic_rule(const rule& r)
+    {
+        for (size_t n = 0; n <= 8; ++n) {
+            m_birth[n] = splat<TVec>(((r.birth() >> n) & 1) ? ~word_t(0) : 0);
+            m_survival[n] = splat<TVec>(((r.survival() >> n) & 1) ? ~word_t(0) : 0);
+        }
+    }
+
+    TVec next(const word_t* p_up, const word_t* p_mid, const word_t* p_down) const
+    {
+        using traits = vec_traits<TVec>;
+        constexpr size_t top = bit_grid::word_bits - 1;
+
+        const TVec a = traits::load(p_up);
+        const TVec a_w = (a << 1) | (traits::load(p_up - 1) >> top);
+        const TVec a_e = (a >> 1) | (traits::load(p_up + 1) << top);
+        const TVec b = traits::load(p_mid);
+        const TVec b_w = (b << 1) | (traits::load(p_mid - 1) >> top);
+        const TVec b_e = (b >> 1) | (traits::load(p_mid + 1) << top);
+        const TVec c = traits::load(p_down);
+        const TVec c_w = (c << 1) | (traits::load(p_down - 1) >> top);
+        const TVec c_e = (c >> 1) | (traits::load(p_down + 1) << top);
+
+        const TVec a_x = a_w ^ a;
+        const TVec a_ones = a_x ^ a_e;
+        const TVec a_twos = (a_w & a) | (a_e & a_x);
+        const TVec b_ones = b_w ^ b_e;
+        const TVec b_twos = b_w & b_e;
+        const TVec c_x = c_w ^ c;
+        const TVec c_ones = c_x ^ c_e;
+        const TVec c_twos = (c_w & c) | (c_e & c_x);
+
+        const TVec ab_x = a_ones ^ b_ones;
+        const TVec ones_carry = (a_ones & b_ones) | (c_ones & ab_x);
+        const TVec p = a_twos ^ b_twos;
+        const TVec q = c_twos ^ ones_carry;
+        const TVec k_ab = a_twos & b_twos;
+        const TVec k_c = c_twos & ones_carry;
+
+        const TVec c0 = ab_x ^ c_ones;
+        const TVec c1 = p ^ q;
+        const TVec c2 = k_ab ^ k_c ^ (p & q);
+        const TVec c3 = k_ab & k_c;
+
+        const TVec born = lookup(m_birth, c0, c1, c2, c3);
+        const TVec survives = lookup(m_survival, c0, c1, c2, c3);
+        return select(b, survives, born);
+    }
+
+private:
+    /// 'x' ? 'one' : 'zero', bitwise.
+    static TVec select(const TVec& x, const TVec& one, const TVec& zero) { return zero ^ (x & (one ^ zero)); }
+
+    static TVec lookup(const TVec* p_table, const TVec& c0, const TVec& c1, const TVec& c2, const TVec& c3)
+    {
+        const TVec t01 = select(c0, p_table[1], p_table[0]);
+        const TVec t23 = select(c0, p_table[3], p_table[2]);
+        const TVec t45 = select(c0, p_table[5], p_table[4]);
+        const TVec t67 = select(c0, p_table[7], p_table[6]);
+        const TVec t03 = select(c1, t23, t01);
+        const TVec t47 = select(c1, t67, t45);
+        // A count of 8 is the only one with c3 set, its low planes are zero.
+        return select(c3, p_table[8], select(c2, t47, t03));
+    }
+
+private:
+    TVec m_birth[9];
+    TVec m_survival[9];
+};
+
+/// Rule of the fast kernels, Conway's.
+template<typename TVec>
+class conway_rule final
+{
+public:
+    explicit conway_rule(const rule&) {}
+
+    TVec next(const word_t* p_up, const word_t* p_mid, const word_t* p_down) const
+    {
+        return next_state<TVec>(p_up, p_mid, p_down);
+    }
+};
+
+template<typename TVec, bool TGeneric>
+using rule_logic = typename std::conditional<TGeneric, generic_rule<TVec>, conway_rule<TVec>>::type;
+
+template<typename TVec>
+inline uint64_t bit_count(const TVec& v)
+{
+    if constexpr (vec_traits<TVec>::lanes == 1) {
+        return __builtin_popcountll(v);
+    } else {
+        uint64_t count = 0;
+        for (size_t i = 0; i < vec_traits<TVec>::lanes; ++i) {
+            count += __builtin_popcountll(v[i]);
+        }
+        return count;
+    }
+}
+
+/*
+ * Bit-sliced counter of set bits. Plane i holds bit i of the count of every
+ * bit position, so adding a vector costs a few logic operations and the
+ * popcounts are paid only when the planes are about to overflow.
+ */
+template<typename TVec>
+class bit_counter final
+{
+public:
+    static constexpr size_t planes = 4;
+    static constexpr size_t capacity = (size_t(1) << planes) - 1;
+
+    void add(TVec v)
+    {
+        for (size_t i = 0; i < planes; ++i) {
+            const TVec carry = m_planes[i] & v;
+            m_planes[i] ^= v;
+            v = carry;
+        }
+        if (++m_added == capacity) {
+            flush();
+        }
+    }
+
+    uint64_t total()
+    {
+        flush();
+        return m_total;
+    }
+
+private:
+    void flush()
+    {
+        for (size_t i = 0; i < planes; ++i) {
+            m_total += bit_count<TVec>(m_planes[i]) << i;
+            m_planes[i] = TVec{};
+        }
+        m_added = 0;
+    }
+
+private:
+    TVec m_planes[planes] = {};
+    size_t m_added = 0;
+    uint64_t m_total = 0;
+};
+
+template<typename TVec>
+inline word_t any_bits(const TVec& v)
+{
+    if constexpr (vec_traits<TVec>::lanes == 1) {
+        return v;
+    } else {
+        word_t any = 0;
+        for (size_t i = 0; i < vec_traits<TVec>::lanes; ++i) {
+            any |= v[i];
+        }
+        return any;
+    }
+}
+
+template<typename TVec, bool TCount, bool TGeneric>
+block_stats step_block(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                       const size_t word_begin, const size_t word_end, const rule& r)
+{
+    constexpr size_t lanes = vec_traits<TVec>::lanes;
+    const rule_logic<TVec, TGeneric> logic(r);
+    const rule_logic<word_t, TGeneric> tail_logic(r);
+
+    const size_t words = src.words();
+    const size_t stride = src.stride();
+    block_stats stats;
+    if (words == 0) {
+        return stats;
+    }
+    // The last word of a row is masked, so it is always done by the scalar tail.
+    const size_t vec_end = (word_end == words) ? word_end - 1 : word_end;
+
+    TVec vec_diff = {};
+    word_t diff = 0;
+    bit_counter<TVec> births;
+    bit_counter<TVec> deaths;
+    bit_counter<word_t> tail_births;
+    bit_counter<word_t> tail_deaths;
+    for (size_t r = row_begin; r < row_end; ++r) {
+        const word_t* p_mid = src.row_ptr(r);
+        const word_t* p_up = p_mid - stride;
+        const word_t* p_down = p_mid + stride;
+        word_t* p_out = dst.row_ptr(r);
+
+        size_t w = word_begin;
+        for (; (w + lanes) <= vec_end; w += lanes) {
+            const TVec prev = vec_traits<TVec>::load(p_mid + w);
+            const TVec next = logic.next(p_up + w, p_mid + w, p_down + w);
+            if constexpr (TCount) {
+                births.add(next & ~prev);
+                deaths.add(prev & ~next);
+            } else {
+                vec_diff |= next ^ prev;
+            }
+            vec_traits<TVec>::store(p_out + w, next);
+        }
+        for (; w < word_end; ++w) {
+            word_t prev = p_mid[w];
+            word_t next = tail_logic.next(p_up + w, p_mid + w, p_down + w);
+            if (w == (words - 1)) {
+                // Past the last column there may be a halo cell of the boundary.
+                prev &= src.last_word_mask();
+                next &= src.last_word_mask();
+            }
+            if constexpr (TCount) {
+                tail_births.add(next & ~prev);
+                tail_deaths.add(prev & ~next);
+            } else {
+                diff |= next ^ prev;
+            }
+            p_out[w] = next;
+        }
+    }
+
+    if constexpr (TCount) {
+        stats.births = births.total() + tail_births.total();
+        stats.deaths = deaths.total() + tail_deaths.total();
+        stats.changed = ((stats.births | stats.deaths) != 0);
+    } else {
+        stats.changed = ((diff | any_bits(vec_diff)) != 0);
+    }
+    return stats;
+}
+
+} // <anonymous> namespace
+} // namespace kernel
+} // namespace life
+
+#endif // LIFE_KERNEL_IMPL_H
@@ -0,0 +1,50 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "engine/kernel.h"
+#include "engine/kernel_impl.h"
+
+namespace life {
+namespace kernel {
+namespace details {
+
+template<bool TCount, bool TGeneric>
+block_stats step_scalar(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                        const size_t word_begin, const size_t word_end, const rule& r)
+{
+    return step_block<word_t, TCount, TGeneric>(src, dst, row_begin, row_end, word_begin, word_end, r);
+}
+
+template block_stats step_scalar<false, false>(const bit_grid&, bit_grid&, const size_t, const size_t, const size_t,
+                                               const size_t, const rule&);
+template block_stats step_scalar<false, true>(const bit_grid&, bit_grid&, const size_t, const size_t, const size_t,
+                                              const size_t, const rule&);
+template block_stats step_scalar<true, false>(const bit_grid&, bit_grid&, const size_t, const size_t, const size_t,
+                                              const size_t, const rule&);
+template block_stats step_scalar<true, true>(const bit_grid&, bit_grid&, const size_t, const size_t, const size_t,
+                                             const size_t, const rule&);
+
+} // namespace details
+} // namespace kernel
+} // namespace life
@@ -0,0 +1,192 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "engine/kernel.h"
+#include "engine/kernel_impl.h"
+
+/*
+ * Table kernel: the next state of a 2x2 block of cells depends only on the
+ * 4x4 neighbourhood around it, so all of them are computed once per rule.
+ * A step is then a table lookup per block instead of an adder network per
+ * word, which favours CPUs without wide vector units and rules whose adder
+ * logic is long. The kernel is portable and steps rows in pairs.
+ */
+
+namespace life {
+namespace kernel {
+namespace {
+
+/*
+ * Entry i is the next state of the centre 2x2 block of neighbourhood i.
+ * Bits 0-3 of 'i' are the top row of the neighbourhood from west to east,
+ * bits 4-7 the second row and so on. Bits 0-1 of an entry are the top row
+ * of the block, bits 2-3 the bottom one.
+ */
+using table_t = std::array<uint8_t, size_t(1) << 16>;
+
+constexpr size_t top = bit_grid::word_bits - 1;
+
+std::unique_ptr<table_t> make_table(const rule& r)
+{
+    std::unique_ptr<table_t> p_table = std::make_unique<table_t>();
+    for (size_t i = 0; i < p_table->size(); ++i) {
+        uint8_t block = 0;
+        for (size_t row = 1; row <= 2; ++row) {
+            for (size_t col = 1; col <= 2; ++col) {
+                size_t neighbours = 0;
+                for (size_t nr = row - 1; nr <= row + 1; ++nr) {
+                    for (size_t nc = col - 1; nc <= col + 1; ++nc) {
+                        neighbours += (i >> (nr * 4 + nc)) & 1;
+                    }
+                }
+                const bool is_alive = ((i >> (row * 4 + col)) & 1) != 0;
+                if (r.next(is_alive, neighbours - (is_alive ? 1 : 0))) {
+                    block |= uint8_t(1) << ((row - 1) * 2 + col - 1);
+                }
+            }
+        }
+        (*p_table)[i] = block;
+    }
+    return p_table;
+}
+
+/// Table of the rule. Tables are built once per rule and shared by all
+/// threads, each thread keeps the last one it used at hand.
+const table_t& table_for(const rule& r)
+{
+    thread_local const table_t* p_last = nullptr;
+    thread_local rule last_rule;
+    if ((p_last != nullptr) && (last_rule == r)) {
+        return *p_last;
+    }
+
+    static std::mutex mutex;
+    static std::map<uint32_t, std::unique_ptr<table_t>> tables;
+    const std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<table_t>& p_table = tables[(uint32_t(r.birth()) << 16) | r.survival()];
+    if (! p_table) {
+        p_table = make_table(r);
+    }
+    p_last = p_table.get();
+    last_rule = r;
+    return *p_last;
+}
+
+/// Index of the neighbourhood whose west column is bit 'shift' of the
+/// windows of the four rows.
+inline size_t table_index(const word_t* p_windows, const size_t shift)
+{
+    return ((p_windows[0] >> shift) & 0xf) | (((p_windows[1] >> shift) & 0xf) << 4)
+        | (((p_windows[2] >> shift) & 0xf) << 8) | (((p_windows[3] >> shift) & 0xf) << 12);
+}
+
+} // <anonymous> namespace
+
+namespace details {
+
+template<bool TCount>
+block_stats step_table(const bit_grid& src, bit_grid& dst, const size_t row_begin, const size_t row_end,
+                       const size_t word_begin, const size_t word_end, const rule& r)
+{
+    const table_t& table = table_for(r);
+
+    const size_t words = src.words();
+    block_stats stats;
+    if (words == 0) {
+        return stats;
+    }
+
+    word_t diff = 0;
+    bit_counter<word_t> births;
+    bit_counter<word_t> deaths;
+    for (size_t row = row_begin; row < row_end; row += 2) {
+        // An odd last row is paired with the row below it, which is only
+        // read. The fourth row is not needed then and may be past the halo.
+        const bool has_pair = (row + 1 < row_end);
+        const word_t* p_rows[4] = {src.row_ptr(row - 1), src.row_ptr(row), src.row_ptr(row + 1),
+                                   has_pair ? src.row_ptr(row + 2) : src.row_ptr(row + 1)};
+        word_t* p_out[2] = {dst.row_ptr(row), has_pair ? dst.row_ptr(row + 1) : nullptr};
+
+        for (size_t w = word_begin; w < word_end; ++w) {
+            // Bit j of a window is column j - 1 of the word, so 31 blocks
+            // come from the windows and the last one from the tails.
+            word_t windows[4];
+            word_t tails[4];
+            for (size_t i = 0; i < 4; ++i) {
+                const word_t* p = p_rows[i] + w;
+                windows[i] = (p[0] << 1) | (p[-1] >> top);
+                tails[i] = (p[0] >> (top - 2)) | ((p[1] & 1) << 3);
+            }
+
+            word_t next[2] = {0, 0};
+            for (size_t shift = 0; shift < top - 1; shift += 2) {
+                const word_t block = table[table_index(windows, shift)];
+                next[0] |= (block & 3) << shift;
+                next[1] |= (block >> 2) << shift;
+            }
+            const word_t block = table[table_index(tails, 0)];
+            next[0] |= (block & 3) << (top - 1);
+            next[1] |= (block >> 2) << (top - 1);
+
+            for (size_t i = 0; i < (has_pair ? 2 : 1); ++i) {
+                word_t prev = p_rows[i + 1][w];
+                if (w == (words - 1)) {
+                    // Past the last column there may be a halo cell of the boundary.
+                    prev &= src.last_word_mask();
+                    next[i] &= src.last_word_mask();
+                }
+                if constexpr (TCount) {
+                    births.add(next[i] & ~prev);
+                    deaths.add(prev & ~next[i]);
+                } else {
+                    diff |= next[i] ^ prev;
+                }
+                p_out[i][w] = next[i];
+            }
+        }
+    }
+
+    if constexpr (TCount) {
+        stats.births = births.total();
+        stats.deaths = deaths.total();
+        stats.changed = ((stats.births | stats.deaths) != 0);
+    } else {
+        stats.changed = (diff != 0);
+    }
+    return stats;
+}
+
+template block_stats step_table<false>(const bit_grid&, bit_grid&, const size_t, const size_t, const size_t,
+                                       const size_t, const rule&);
+template block_stats step_table<true>(const bit_grid&, bit_grid&, const size_t, const size_t, const size_t,
+                                      const size_t, const rule&);
+
+} // namespace details
+} // namespace kernel
+} // namespace life
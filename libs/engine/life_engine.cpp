@@ -23,92 +23,556 @@
  */
 
 #include <algorithm>
+#include <chrono>
 
 #include "engine/life_engine.h"
 
 namespace life {
+namespace {
+
+// Fewer tiles per thread cost more in synchronization than they save.
+constexpr size_t min_band_tiles = 2;
+
+constexpr size_t block_words = engine::tile_words * engine::block_tiles;
+
+// How a block came out of the last pass. A still block did not change in
+// its last generation and so in none of them.
+constexpr uint8_t block_still = 0;
+constexpr uint8_t block_repeats = 1;
+constexpr uint8_t block_changed = 2;
+
+// Finalizer of splitmix64, a bijection that keeps zero.
+inline uint64_t mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+} // <anonymous> namespace
 
 engine::engine(const size_t row_count, const size_t col_count)
     : m_row_count(row_count)
     , m_col_count(col_count)
-{}
+    , m_kind(kernel::kind_t::adder)
+    , m_isa(kernel::best_isa())
+    , m_is_counting(false)
+    , m_step(kernel::step_fn(m_kind, m_isa, m_is_counting, ! m_rule.is_conway()))
+    , m_boundary(boundary::boundary_t::dead)
+    , m_fill_halo(nullptr)
+    , m_block_depth(0)
+    , m_block_col_count(0)
+    , m_last_block_depth(0)
+    , m_generation(0)
+    , m_hash(0)
+    , m_empty_tiles(0)
+    , m_grid(row_count, col_count)
+    , m_next(row_count, col_count)
+{
+    touch_all();
+    reset_counters();
+}
 
-size_t engine::neighbors_count(const size_t row, const size_t col) const
+uint8_t engine::advance_block(const size_t block, const size_t depth, bit_grid* p_buffers)
 {
-    using point_t = std::pair<int, int>;
+    const size_t row_begin = (block / m_block_col_count) * tile_rows;
+    const size_t row_end = std::min(row_begin + tile_rows, m_row_count);
+    const size_t word_begin = (block % m_block_col_count) * block_words;
+    const size_t word_end = std::min(word_begin + block_words, m_grid.words());
+
+    // Every generation the wrong cells past the edges of the buffer reach one
+    // cell further in, so after 'depth' generations only the halo is wrong.
+    // A halo cut by an edge of the board ends there, the cells beyond are
+    // dead as they are on the board. A halo word is enough for any depth.
+    const size_t halo_begin = (row_begin == 0) ? 0 : row_begin - depth;
+    const size_t halo_end = std::min(row_end + depth, m_row_count);
+    const bool is_north_halo = (halo_begin != 0);
+    const bool is_south_halo = (halo_end != m_row_count);
+    const size_t west_words = (word_begin == 0) ? 0 : 1;
+    const bool is_last_col = (word_end == m_grid.words());
+    const size_t rows = halo_end - halo_begin;
+    const size_t words = word_end - word_begin + west_words + (is_last_col ? 0 : 1);
+
+    // The last column has buffers of its own, so that the kernel masks the
+    // last word of the board.
+    bit_grid* p_src = is_last_col ? p_buffers + 2 : p_buffers;
+    bit_grid* p_dst = p_src + 1;
+    for (size_t r = 0; r < rows; ++r) {
+        std::copy_n(m_grid.row_ptr(halo_begin + r) + word_begin - west_words, words, p_src->row_ptr(r));
+    }
+    if (rows < p_src->row_count()) {
+        std::fill_n(p_src->row_ptr(rows), p_src->words(), 0);
+        std::fill_n(p_dst->row_ptr(rows), p_dst->words(), 0);
+    }
+
+    // Rows of a halo are dropped as soon as they turn wrong, so the stepped
+    // rows narrow down to the block. The last generation is needed in the
+    // block only, which also tells whether it is still.
+    bool is_still = false;
+    for (size_t g = 0; g < depth; ++g) {
+        const size_t begin = is_north_halo ? g + 1 : 0;
+        const size_t end = is_south_halo ? rows - g - 1 : rows;
+        if (g + 1 == depth) {
+            is_still = ! m_step(*p_src, *p_dst, begin, end, west_words, west_words + word_end - word_begin,
+                                m_rule).changed;
+        } else {
+            m_step(*p_src, *p_dst, begin, end, 0, words, m_rule);
+        }
+        std::swap(p_src, p_dst);
+    }
+
+    bit_grid::word_t diff = 0;
+    for (size_t r = row_begin; r < row_end; ++r) {
+        const bit_grid::word_t* p_block = p_src->row_ptr(r - halo_begin) + west_words;
+        const bit_grid::word_t* p_prev = m_grid.row_ptr(r) + word_begin;
+        bit_grid::word_t* p_next = m_next.row_ptr(r) + word_begin;
+        for (size_t w = 0; w < word_end - word_begin; ++w) {
+            diff |= p_block[w] ^ p_prev[w];
+            p_next[w] = p_block[w];
+        }
+    }
+    if (diff != 0) {
+        return block_changed;
+    }
+    return is_still ? block_still : block_repeats;
+}
 
-    const int r = static_cast<int>(row);
-    const int c = static_cast<int>(col);
-    const std::vector<point_t> ps = {{r - 1, c - 1}, {r - 1, c}, {r - 1, c + 1},
-                                     {r, c - 1},     /*{r, c},*/     {r, c + 1},
-                                     {r + 1, c - 1}, {r + 1, c}, {r + 1, c + 1}};
+bool engine::can_block() const
+{
+    return (m_block_depth > 1) && (m_fill_halo == nullptr) && ! m_is_counting && ! m_cycles.enabled()
+        && ! m_block_buffers.empty();
+}
 
-    return std::count_if(ps.cbegin(), ps.cend(), [this](const point_t& p) -> bool {
-                                                     return (p.first >= 0) && (p.first < (int)m_row_count) &&
-                                                            (p.second >= 0) && (p.second < (int)m_col_count) &&
-                                                            (m_grid[p.first][p.second]);
-                                                 });
+const engine::grid_t& engine::grid() const
+{
+    m_grid_view.resize(m_row_count);
+    for (size_t r = 0; r < m_row_count; ++r) {
+        row_t& row = m_grid_view[r];
+        row.resize(m_col_count);
+        for (size_t c = 0; c < m_col_count; ++c) {
+            row[c] = m_grid.get(r, c);
+        }
+    }
+    return m_grid_view;
 }
 
-bool engine::next_step()
+engine::tile_hash engine::hash_tile(const bit_grid& grid, const size_t tile) const
 {
-    grid_t next_step(m_row_count);
-    std::for_each(next_step.begin(), next_step.end(), [this](row_t& r) { r.resize(m_col_count, false); });
-
-    for (size_t r = 0; r < m_grid.size(); ++r) {
-        const row_t& row = m_grid[r];
-        for (size_t c = 0; c < row.size(); ++c) {
-            const size_t n_count = neighbors_count(r, c);
-
-			/*if (n_count < 2) {
-				next_step[r][c] = false;
-			} else if (n_count > 3) {
-				next_step[r][c] = false;
-			} else if (n_count == 3) {
-				next_step[r][c] = true;
-			} else if (m_grid[r][c] && (n_count == 2)) {
-				next_step[r][c] = true;
-			} else {
-				next_step[r][c] = false;
-			}*/
-
-			if ((n_count == 3) || (m_grid[r][c] && (n_count == 2))) {
-				next_step[r][c] = true;
-			}
+    const size_t row_begin = (tile / m_tile_col_count) * tile_rows;
+    const size_t row_end = std::min(row_begin + tile_rows, m_row_count);
+    const size_t word_begin = (tile % m_tile_col_count) * tile_words;
+    const size_t word_end = std::min(word_begin + tile_words, grid.words());
+
+    // Every word is scaled by an odd number unique to its position and
+    // mixed, so equal words at different places differ and empty words
+    // add nothing.
+    tile_hash hash;
+    bit_grid::word_t any = 0;
+    for (size_t r = row_begin; r < row_end; ++r) {
+        const bit_grid::word_t* p_row = grid.row_ptr(r);
+        for (size_t w = word_begin; w < word_end; ++w) {
+            const uint64_t position = r * grid.words() + w;
+            hash.value ^= mix(p_row[w] * ((2 * position + 1) * 0x9e3779b97f4a7c15ull));
+            any |= p_row[w];
         }
     }
+    hash.is_empty = (any == 0);
+    return hash;
+}
 
-    std::swap(next_step, m_grid);
+bool engine::next_step()
+{
+    step();
     return true;
 }
 
+void engine::reserve_blocks()
+{
+    m_block_buffers.clear();
+    if ((m_block_depth < 2) || (m_grid.words() == 0)) {
+        return;
+    }
+
+    const size_t rows = tile_rows + 2 * m_block_depth;
+    const size_t last_begin = ((m_grid.words() - 1) / block_words) * block_words;
+    const size_t last_halo_begin = (last_begin == 0) ? 0 : last_begin - 1;
+    m_block_buffers.resize(4 * thread_count());
+    for (size_t i = 0; i < m_block_buffers.size(); i += 4) {
+        m_block_buffers[i].resize(rows, (block_words + 2) * bit_grid::word_bits);
+        m_block_buffers[i + 1].resize(rows, (block_words + 2) * bit_grid::word_bits);
+        m_block_buffers[i + 2].resize(rows, m_col_count - last_halo_begin * bit_grid::word_bits);
+        m_block_buffers[i + 3].resize(rows, m_col_count - last_halo_begin * bit_grid::word_bits);
+    }
+}
+
+void engine::reset_counters()
+{
+    m_generation = 0;
+    m_metrics = step_metrics();
+    m_metrics.population = m_is_counting ? m_grid.population() : 0;
+    m_latency.reset();
+    reset_cycles();
+}
+
+void engine::reset_cycles()
+{
+    m_cycles.reset();
+    if (! m_cycles.enabled()) {
+        return;
+    }
+
+    m_hash = 0;
+    m_empty_tiles = 0;
+    for (size_t tile = 0; tile < m_tile_hashes.size(); ++tile) {
+        m_tile_hashes[tile] = hash_tile(m_grid, tile);
+        m_hash ^= m_tile_hashes[tile].value;
+        m_empty_tiles += m_tile_hashes[tile].is_empty ? 1 : 0;
+    }
+    m_cycles.push(m_generation, m_hash, m_empty_tiles == m_tile_hashes.size());
+}
+
 bool engine::restart(const grid_t& begin_state)
 {
     stop();
     return start(begin_state);
 }
 
+void engine::set_boundary(const boundary::boundary_t boundary)
+{
+    m_boundary = boundary;
+    m_fill_halo = boundary::fill_fn(boundary);
+    touch_all();
+}
+
+void engine::set_cell_counting(const bool enabled)
+{
+    m_is_counting = enabled;
+    m_step = kernel::step_fn(m_kind, m_isa, m_is_counting, ! m_rule.is_conway());
+    m_metrics.population = m_is_counting ? m_grid.population() : 0;
+    m_metrics.births = 0;
+    m_metrics.deaths = 0;
+}
+
+void engine::set_cycle_detection(const size_t history)
+{
+    m_cycles.set_history(history);
+    reset_cycles();
+}
+
+void engine::set_generation(const uint64_t generation)
+{
+    m_generation = generation;
+    m_metrics.generation = generation;
+    reset_cycles();
+}
+
+bool engine::set_isa(const kernel::isa_t isa)
+{
+    // Checked with the adder kernels, the table ones run everywhere.
+    if (kernel::step_fn(isa, m_is_counting, ! m_rule.is_conway()) == nullptr) {
+        return false;
+    }
+    m_isa = isa;
+    m_step = kernel::step_fn(m_kind, m_isa, m_is_counting, ! m_rule.is_conway());
+    return true;
+}
+
+void engine::set_kernel(const kernel::kind_t kind)
+{
+    m_kind = kind;
+    m_step = kernel::step_fn(m_kind, m_isa, m_is_counting, ! m_rule.is_conway());
+}
+
+void engine::set_rule(const life::rule& r)
+{
+    m_rule = r;
+    m_step = kernel::step_fn(m_kind, m_isa, m_is_counting, ! m_rule.is_conway());
+    touch_all();
+}
+
+void engine::set_temporal_blocking(const size_t depth)
+{
+    m_block_depth = std::min(depth, max_block_depth);
+    m_last_block_depth = 0;
+    reserve_blocks();
+}
+
+void engine::set_thread_count(const size_t count)
+{
+    m_p_pool.reset();
+    if (count != 1) {
+        m_p_pool = std::make_unique<thread_pool>(count);
+    }
+    reserve_blocks();
+}
+
 bool engine::start(const grid_t& begin_state)
 {
-    m_grid.resize(m_row_count);
-    std::for_each(m_grid.begin(), m_grid.end(), [this](row_t& r) { r.resize(m_col_count, false); });
+    m_grid.resize(m_row_count, m_col_count);
+    m_next.resize(m_row_count, m_col_count);
+    touch_all();
 
-    for (size_t r = 0; r < begin_state.size(); ++r) {
+    const size_t row_count = std::min(begin_state.size(), m_row_count);
+    for (size_t r = 0; r < row_count; ++r) {
         const row_t& row = begin_state[r];
-        for (size_t c = 0; c < row.size(); ++c) {
-            m_grid[r][c] = begin_state[r][c];
+        const size_t col_count = std::min(row.size(), m_col_count);
+        for (size_t c = 0; c < col_count; ++c) {
+            m_grid.set(r, c, row[c]);
         }
     }
+    reset_counters();
 
     return true;
 }
 
-void engine::stop()
+bool engine::start(const bit_grid& begin_state)
+{
+    m_grid.resize(m_row_count, m_col_count);
+    m_next.resize(m_row_count, m_col_count);
+    touch_all();
+
+    const size_t row_count = std::min(begin_state.row_count(), m_row_count);
+    const size_t words = std::min(begin_state.words(), m_grid.words());
+    for (size_t r = 0; r < row_count; ++r) {
+        bit_grid::word_t* p_row = m_grid.row_ptr(r);
+        std::copy_n(begin_state.row_ptr(r), words, p_row);
+        if ((words != 0) && (words == m_grid.words())) {
+            p_row[words - 1] &= m_grid.last_word_mask();
+        }
+    }
+    reset_counters();
+
+    return true;
+}
+
+bool engine::start(bit_grid&& begin_state)
+{
+    if ((begin_state.row_count() != m_row_count) || (begin_state.col_count() != m_col_count)) {
+        return start(static_cast<const bit_grid&>(begin_state));
+    }
+
+    m_grid.swap(begin_state);
+    m_next.resize(m_row_count, m_col_count);
+    touch_all();
+    reset_counters();
+
+    return true;
+}
+
+void engine::step()
+{
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    m_last_block_depth = 0;
+
+    // A tile can only change if it or one of its neighbours changed in the
+    // previous step. Every other tile is stable, so the buffer of the
+    // previous generation already holds its next state.
+    // Across joined edges the neighbours are on the opposite side, so the
+    // edge tiles are simply always stepped.
+    const bool is_joined = (m_boundary == boundary::boundary_t::torus) || (m_boundary == boundary::boundary_t::klein);
+    m_active_tiles.clear();
+    for (size_t tr = 0; tr < m_tile_row_count; ++tr) {
+        const size_t r_begin = (tr == 0) ? 0 : tr - 1;
+        const size_t r_end = std::min(tr + 2, m_tile_row_count);
+        const bool is_edge_row = (tr == 0) || (tr + 1 == m_tile_row_count);
+        for (size_t tc = 0; tc < m_tile_col_count; ++tc) {
+            const size_t c_begin = (tc == 0) ? 0 : tc - 1;
+            const size_t c_end = std::min(tc + 2, m_tile_col_count);
+
+            bool is_active = is_joined && (is_edge_row || (tc == 0) || (tc + 1 == m_tile_col_count));
+            for (size_t r = r_begin; (r < r_end) && ! is_active; ++r) {
+                for (size_t c = c_begin; (c < c_end) && ! is_active; ++c) {
+                    is_active = (m_changed_tiles[r * m_tile_col_count + c] != 0);
+                }
+            }
+            if (is_active) {
+                m_active_tiles.push_back(tr * m_tile_col_count + tc);
+            }
+        }
+    }
+    std::fill(m_changed_tiles.begin(), m_changed_tiles.end(), 0);
+
+    if (m_fill_halo != nullptr) {
+        m_fill_halo(m_grid);
+    }
+
+    const size_t band_count = std::min(thread_count(), m_active_tiles.size() / min_band_tiles);
+    if (band_count < 2) {
+        for (const size_t tile : m_active_tiles) {
+            step_tile(tile);
+        }
+    } else {
+        m_p_pool->run(band_count, [this, band_count] (const size_t band) {
+            const size_t begin = m_active_tiles.size() * band / band_count;
+            const size_t end = m_active_tiles.size() * (band + 1) / band_count;
+            for (size_t i = begin; i < end; ++i) {
+                step_tile(m_active_tiles[i]);
+            }
+        });
+    }
+
+    if (m_fill_halo != nullptr) {
+        boundary::clear(m_grid);
+    }
+    m_grid.swap(m_next);
+
+    if (m_is_counting || m_cycles.enabled()) {
+        uint64_t births = 0;
+        uint64_t deaths = 0;
+        for (const size_t tile : m_active_tiles) {
+            const kernel::block_stats& stats = m_tile_stats[tile];
+            births += stats.births;
+            deaths += stats.deaths;
+            if (m_cycles.enabled() && stats.changed) {
+                const tile_hash& next = m_next_tile_hashes[tile];
+                tile_hash& hash = m_tile_hashes[tile];
+                m_hash ^= hash.value ^ next.value;
+                m_empty_tiles = m_empty_tiles + (next.is_empty ? 1 : 0) - (hash.is_empty ? 1 : 0);
+                hash = next;
+            }
+        }
+        if (m_is_counting) {
+            m_metrics.births = births;
+            m_metrics.deaths = deaths;
+            m_metrics.population += births - deaths;
+        }
+    }
+
+    ++m_generation;
+    m_metrics.generation = m_generation;
+    if (m_cycles.enabled()) {
+        m_cycles.push(m_generation, m_hash, m_empty_tiles == m_tile_hashes.size());
+    }
+    m_metrics.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    m_latency.record(m_metrics.wall_ns);
+}
+
+void engine::step_blocked(const size_t depth)
+{
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    // After single steps the tiles tell which blocks are still, a block
+    // changed if any of its tiles did.
+    if (m_last_block_depth == 0) {
+        std::fill(m_changed_blocks.begin(), m_changed_blocks.end(), block_still);
+        for (size_t tile = 0; tile < m_changed_tiles.size(); ++tile) {
+            if (m_changed_tiles[tile] != 0) {
+                m_changed_blocks[(tile / m_tile_col_count) * m_block_col_count
+                                 + (tile % m_tile_col_count) / block_tiles] = block_changed;
+            }
+        }
+    }
+
+    // A block the last pass left as it was repeats itself every 'depth' of
+    // that pass generations, a still one every generation. If its neighbours
+    // do so too, its halo repeats as well and both buffers already hold its
+    // next state.
+    m_active_blocks.clear();
+    for (size_t br = 0; br < m_tile_row_count; ++br) {
+        const size_t r_begin = (br == 0) ? 0 : br - 1;
+        const size_t r_end = std::min(br + 2, m_tile_row_count);
+        for (size_t bc = 0; bc < m_block_col_count; ++bc) {
+            const size_t c_begin = (bc == 0) ? 0 : bc - 1;
+            const size_t c_end = std::min(bc + 2, m_block_col_count);
+
+            const uint8_t max_state = (m_last_block_depth == depth) ? block_repeats : block_still;
+            bool is_active = false;
+            for (size_t r = r_begin; (r < r_end) && ! is_active; ++r) {
+                for (size_t c = c_begin; (c < c_end) && ! is_active; ++c) {
+                    is_active = (m_changed_blocks[r * m_block_col_count + c] > max_state);
+                }
+            }
+            if (is_active) {
+                m_active_blocks.push_back(br * m_block_col_count + bc);
+            }
+        }
+    }
+
+    const size_t band_count = std::min(thread_count(), m_active_blocks.size());
+    if (band_count < 2) {
+        for (const size_t block : m_active_blocks) {
+            m_changed_blocks[block] = advance_block(block, depth, m_block_buffers.data());
+        }
+    } else {
+        m_p_pool->run(band_count, [this, band_count, depth] (const size_t band) {
+            const size_t begin = m_active_blocks.size() * band / band_count;
+            const size_t end = m_active_blocks.size() * (band + 1) / band_count;
+            bit_grid* p_buffers = m_block_buffers.data() + 4 * band;
+            for (size_t i = begin; i < end; ++i) {
+                const size_t block = m_active_blocks[i];
+                m_changed_blocks[block] = advance_block(block, depth, p_buffers);
+            }
+        });
+    }
+
+    m_grid.swap(m_next);
+    m_last_block_depth = depth;
+    for (size_t tile = 0; tile < m_changed_tiles.size(); ++tile) {
+        const size_t block = (tile / m_tile_col_count) * m_block_col_count + (tile % m_tile_col_count) / block_tiles;
+        m_changed_tiles[tile] = (m_changed_blocks[block] != block_still) ? 1 : 0;
+    }
+
+    m_generation += depth;
+    m_metrics.generation = m_generation;
+    m_metrics.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count() / depth;
+    for (size_t g = 0; g < depth; ++g) {
+        m_latency.record(m_metrics.wall_ns);
+    }
+}
+
+bool engine::step_n(const uint64_t generations)
+{
+    uint64_t left = generations;
+    while (left != 0) {
+        const size_t depth = can_block() ? (size_t)std::min<uint64_t>(m_block_depth, left) : 1;
+        if (depth > 1) {
+            step_blocked(depth);
+        } else {
+            step();
+        }
+        left -= depth;
+    }
+    return true;
+}
+
+void engine::step_tile(const size_t tile)
 {
-    for (row_t& r : m_grid) {
-        std::fill(r.begin(), r.end(), false);
+    const size_t row_begin = (tile / m_tile_col_count) * tile_rows;
+    const size_t row_end = std::min(row_begin + tile_rows, m_row_count);
+    const size_t word_begin = (tile % m_tile_col_count) * tile_words;
+    const size_t word_end = std::min(word_begin + tile_words, m_grid.words());
+
+    m_tile_stats[tile] = m_step(m_grid, m_next, row_begin, row_end, word_begin, word_end, m_rule);
+    m_changed_tiles[tile] = m_tile_stats[tile].changed ? 1 : 0;
+    if (m_cycles.enabled() && m_tile_stats[tile].changed) {
+        m_next_tile_hashes[tile] = hash_tile(m_next, tile);
     }
 }
 
+void engine::stop()
+{
+    m_grid.clear();
+    touch_all();
+    reset_counters();
+}
+
+void engine::touch_all()
+{
+    m_tile_row_count = (m_row_count + tile_rows - 1) / tile_rows;
+    m_tile_col_count = (m_grid.words() + tile_words - 1) / tile_words;
+    m_changed_tiles.assign(m_tile_row_count * m_tile_col_count, 1);
+    m_tile_stats.resize(m_changed_tiles.size());
+    m_tile_hashes.resize(m_changed_tiles.size());
+    m_next_tile_hashes.resize(m_changed_tiles.size());
+    m_active_tiles.reserve(m_changed_tiles.size());
+
+    m_block_col_count = (m_grid.words() + block_words - 1) / block_words;
+    m_changed_blocks.resize(m_tile_row_count * m_block_col_count);
+    m_active_blocks.reserve(m_changed_blocks.size());
+    m_last_block_depth = 0;
+}
+
 } // namespace life
 
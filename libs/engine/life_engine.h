@@ -25,12 +25,45 @@
 #ifndef LIFE_ENGINE_H
 #define LIFE_ENGINE_H
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
+#include "engine/bit_grid.h"
+#include "engine/boundary.h"
+#include "engine/cycle_detector.h"
+#include "engine/kernel.h"
+#include "engine/metrics.h"
+#include "engine/rule.h"
+#include "engine/thread_pool.h"
+
 namespace life {
 
 /**
  * \brief   Engine for Conway's Game of Life.
+ *
+ * The board is split into tiles of tile_rows x tile_words words. A step
+ * recomputes only the tiles that changed in the previous step and their
+ * neighbours; the rest of the board is stable and is left as it is.
+ *
+ * Every step records its wall time. With cell counting on, the kernel also
+ * counts births and deaths while it computes the tiles, so the population is
+ * kept up to date without scanning the board. With cycle detection on, the
+ * tiles a step changed are rehashed and the board hash, the XOR of the tile
+ * hashes, is checked for repeats.
+ *
+ * The rule is Conway's unless set_rule() picks another outer totalistic
+ * one. Cells beyond the edges are dead by default. Other boundaries fill the
+ * halo of the board before every step; joined edges keep the edge tiles
+ * active, as a change on one edge reaches the opposite one.
+ *
+ * With temporal blocking on, step_n() copies blocks of block_tiles tiles
+ * together with a halo of 'depth' cells into small buffers, advances them
+ * 'depth' generations while they stay in cache and writes them back, so a
+ * board larger than the cache passes through memory once per 'depth'
+ * generations instead of once per generation. Neighbouring blocks compute
+ * the overlapping halos twice. It needs dead edges, no cell counting and no
+ * cycle detection; otherwise step_n() steps one generation at a time.
  */
 class engine final
 {
@@ -38,6 +71,12 @@ public:
     using row_t = std::vector<bool>;
     using grid_t = std::vector<row_t>;
 
+    static constexpr size_t tile_rows = 64;
+    static constexpr size_t tile_words = 8;
+    /// Tiles in a row of a temporally blocked step.
+    static constexpr size_t block_tiles = 8;
+    static constexpr size_t max_block_depth = tile_rows;
+
     engine(const size_t row_count = 25, const size_t col_count = 25);
 
     bool next_step();
@@ -46,6 +85,15 @@ public:
 
     bool start(const grid_t& begin_state);
 
+    /// Starts from a packed board, clipped to the engine size.
+    bool start(const bit_grid& begin_state);
+
+    /// Takes a packed board of the engine size over without copying.
+    bool start(bit_grid&& begin_state);
+
+    /// Advances the board by 'generations' without allocating memory.
+    bool step_n(const uint64_t generations);
+
     template<typename TType>
     bool start(const std::vector<std::vector<TType>>& begin, const TType& alive_val)
     {
@@ -55,9 +103,9 @@ public:
             r.resize(m_col_count, false);
         }
 
-        for (size_t r = 0; r < begin.size(); ++r) {
+        for (size_t r = 0; r < std::min(begin.size(), m_row_count); ++r) {
             const std::vector<TType>& row = begin[r];
-            for (size_t c = 0; c < row.size(); ++c) {
+            for (size_t c = 0; c < std::min(row.size(), m_col_count); ++c) {
                 begin_state[r][c] = (begin[r][c] == alive_val);
             }
         }
@@ -65,18 +113,156 @@ public:
         return start(begin_state);
     }
 
-    const grid_t& grid() const { return m_grid; }
+    /// Tiles recomputed by the last step.
+    size_t active_tile_count() const { return m_active_tiles.size(); }
+
+    bool alive(const size_t row, const size_t col) const { return m_grid.get(row, col); }
+
+    boundary::boundary_t boundary() const { return m_boundary; }
+
+    bool cell_counting() const { return m_is_counting; }
+
+    size_t col_count() const { return m_col_count; }
+
+    const cycle_detector& cycles() const { return m_cycles; }
+
+    uint64_t generation() const { return m_generation; }
+
+    /// Unpacked copy of the board. Use alive() or storage() on hot paths.
+    const grid_t& grid() const;
+
+    /// Hash of the board, maintained while cycle detection is on.
+    uint64_t hash() const { return m_hash; }
+
+    kernel::isa_t isa() const { return m_isa; }
+
+    kernel::kind_t kernel() const { return m_kind; }
+
+    /// Wall time distribution of the steps since the start.
+    const latency_histogram& latency() const { return m_latency; }
+
+    /// Counters of the last step. Population, births and deaths are zero
+    /// unless cell counting is on.
+    const step_metrics& metrics() const { return m_metrics; }
+
+    size_t population() const { return m_is_counting ? m_metrics.population : m_grid.population(); }
+
+    size_t row_count() const { return m_row_count; }
+
+    const life::rule& rule() const { return m_rule; }
+
+    void set_boundary(const boundary::boundary_t boundary);
+
+    /// Counts births, deaths and population in every step. Off by default,
+    /// the counting kernels are slower.
+    void set_cell_counting(const bool enabled);
+
+    /// Detects oscillators with a period up to 'history', 0 turns the
+    /// detection off.
+    void set_cycle_detection(const size_t history);
+
+    /// Sets the generation counter, e.g. of a board restored from a snapshot.
+    void set_generation(const uint64_t generation);
+
+    /// Selects the kernel instruction set. By default the best one is used.
+    bool set_isa(const kernel::isa_t isa);
+
+    /// Selects the kind of kernel, adder networks by default. Table kernels
+    /// are portable and ignore the instruction set.
+    void set_kernel(const kernel::kind_t kind);
+
+    /// Conway's rule is stepped by the fastest kernels, any other by
+    /// generic ones.
+    void set_rule(const life::rule& r);
+
+    /// Lets step_n() advance up to 'depth' generations per pass over the
+    /// board, clipped to max_block_depth. 0 or 1 turns it off.
+    void set_temporal_blocking(const size_t depth);
+
+    /// Steps the board on 'count' threads, 0 means all CPUs.
+    void set_thread_count(const size_t count);
 
     void stop();
 
+    const bit_grid& storage() const { return m_grid; }
+
+    size_t temporal_blocking() const { return m_block_depth; }
+
+    size_t thread_count() const { return m_p_pool ? m_p_pool->thread_count() : 1; }
+
+    size_t tile_count() const { return m_changed_tiles.size(); }
+
 private:
-    size_t neighbors_count(const size_t row, const size_t col) const;
+    struct tile_hash final
+    {
+        uint64_t value = 0;
+        bool is_empty = true;
+    };
+
+private:
+    uint8_t advance_block(const size_t block, const size_t depth, bit_grid* p_buffers);
+
+    bool can_block() const;
+
+    tile_hash hash_tile(const bit_grid& grid, const size_t tile) const;
+
+    void reserve_blocks();
+
+    void reset_counters();
+
+    void reset_cycles();
+
+    void step();
+
+    void step_blocked(const size_t depth);
+
+    void step_tile(const size_t tile);
+
+    void touch_all();
 
 private:
     size_t m_row_count;
     size_t m_col_count;
 
-    grid_t m_grid;
+    kernel::kind_t m_kind;
+    kernel::isa_t m_isa;
+    bool m_is_counting;
+    life::rule m_rule;
+    kernel::step_fn_t m_step;
+    boundary::boundary_t m_boundary;
+    boundary::fill_fn_t m_fill_halo;
+    std::unique_ptr<thread_pool> m_p_pool;
+
+    size_t m_tile_row_count;
+    size_t m_tile_col_count;
+    std::vector<uint8_t> m_changed_tiles;
+    std::vector<size_t> m_active_tiles;
+    std::vector<kernel::block_stats> m_tile_stats;
+    std::vector<tile_hash> m_tile_hashes;
+    std::vector<tile_hash> m_next_tile_hashes;
+
+    size_t m_block_depth;
+    size_t m_block_col_count;
+    // Depth of the last pass if it was blocked, else 0 and the tiles tell
+    // which blocks are still. Blocks the last pass left as they were are
+    // skipped by the next pass of the same depth, still ones by any pass.
+    size_t m_last_block_depth;
+    std::vector<uint8_t> m_changed_blocks;
+    std::vector<size_t> m_active_blocks;
+    // Two buffers of inner blocks and two of the last block column per thread.
+    std::vector<bit_grid> m_block_buffers;
+
+    uint64_t m_generation;
+    step_metrics m_metrics;
+    latency_histogram m_latency;
+
+    uint64_t m_hash;
+    size_t m_empty_tiles;
+    cycle_detector m_cycles;
+
+    bit_grid m_grid;
+    bit_grid m_next;
+    mutable grid_t m_grid_view;
 };
 
 } // namespace life
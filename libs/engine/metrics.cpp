@@ -0,0 +1,86 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "engine/metrics.h"
+
+namespace life {
+
+size_t latency_histogram::bucket(const uint64_t ns)
+{
+    if (ns < sub_buckets) {
+        return ns;
+    }
+    // Position of the top bit selects the range, the next bits the bucket.
+    const size_t msb = 63 - __builtin_clzll(ns);
+    const size_t shift = msb - sub_bucket_bits;
+    return (shift + 1) * sub_buckets + ((ns >> shift) & (sub_buckets - 1));
+}
+
+uint64_t latency_histogram::bucket_upper(const size_t idx)
+{
+    if (idx < sub_buckets) {
+        return idx;
+    }
+    const size_t shift = idx / sub_buckets - 1;
+    const uint64_t base = (uint64_t)(sub_buckets + idx % sub_buckets) << shift;
+    return base + ((uint64_t(1) << shift) - 1);
+}
+
+uint64_t latency_histogram::percentile(const double p) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(m_count * std::min(p, 100.0) / 100.0));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_buckets.size(); ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return std::min(std::max(bucket_upper(i), m_min), m_max);
+        }
+    }
+    return m_max;
+}
+
+void latency_histogram::record(const uint64_t ns)
+{
+    ++m_buckets[bucket(ns)];
+    ++m_count;
+    m_min = std::min(m_min, ns);
+    m_max = std::max(m_max, ns);
+}
+
+void latency_histogram::reset()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_min = UINT64_MAX;
+    m_max = 0;
+}
+
+} // namespace life
@@ -0,0 +1,87 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_METRICS_H
+#define LIFE_METRICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace life {
+
+/**
+ * \brief   Counters of one generation step.
+ */
+struct step_metrics final
+{
+    uint64_t generation = 0;
+    uint64_t wall_ns = 0;
+    uint64_t population = 0;
+    uint64_t births = 0;
+    uint64_t deaths = 0;
+
+    uint64_t changed() const { return births + deaths; }
+};
+
+/**
+ * \brief   Fixed size log-linear histogram of latencies in nanoseconds.
+ *
+ * Every power of two range is split into sub_buckets linear buckets, so
+ * percentiles are accurate to 1 / sub_buckets and recording never allocates.
+ */
+class latency_histogram final
+{
+public:
+    static constexpr size_t sub_bucket_bits = 3;
+    static constexpr size_t sub_buckets = size_t(1) << sub_bucket_bits;
+
+    uint64_t count() const { return m_count; }
+
+    uint64_t max() const { return m_max; }
+
+    uint64_t min() const { return (m_count == 0) ? 0 : m_min; }
+
+    /// Upper bound of the value below which 'p' percents of samples are.
+    uint64_t percentile(const double p) const;
+
+    void record(const uint64_t ns);
+
+    void reset();
+
+private:
+    static size_t bucket(const uint64_t ns);
+
+    static uint64_t bucket_upper(const size_t idx);
+
+private:
+    std::array<uint64_t, 64 * sub_buckets> m_buckets = {};
+    uint64_t m_count = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+};
+
+} // namespace life
+
+#endif // LIFE_METRICS_H
@@ -0,0 +1,104 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <cctype>
+
+#include "engine/rule.h"
+
+namespace life {
+namespace {
+
+/// Parses the digits of 's' into a mask, each digit at most once.
+bool to_mask(const std::string& s, uint16_t& mask)
+{
+    mask = 0;
+    for (const char ch : s) {
+        if ((ch < '0') || (ch > '8') || ((mask >> (ch - '0')) & 1)) {
+            return false;
+        }
+        mask |= uint16_t(1) << (ch - '0');
+    }
+    return true;
+}
+
+} // <anonymous> namespace
+
+std::string rule::to_string() const
+{
+    std::string text = "B";
+    for (size_t n = 0; n <= 8; ++n) {
+        if ((m_birth >> n) & 1) {
+            text += char('0' + n);
+        }
+    }
+    text += "/S";
+    for (size_t n = 0; n <= 8; ++n) {
+        if ((m_survival >> n) & 1) {
+            text += char('0' + n);
+        }
+    }
+    return text;
+}
+
+bool rule_from_string(const std::string& text, rule& r)
+{
+    const size_t slash = text.find('/');
+    if ((slash == std::string::npos) || (text.find('/', slash + 1) != std::string::npos)) {
+        return false;
+    }
+    const std::string first = text.substr(0, slash);
+    const std::string second = text.substr(slash + 1);
+
+    std::string birth;
+    std::string survival;
+    const bool is_bs = ! first.empty() && (std::toupper(first[0]) == 'B');
+    if (is_bs) {
+        if (second.empty() || (std::toupper(second[0]) != 'S')) {
+            return false;
+        }
+        birth = first.substr(1);
+        survival = second.substr(1);
+    } else if (! first.empty() && (std::toupper(first[0]) == 'S')) {
+        // "S23/B3" has the parts swapped.
+        if (second.empty() || (std::toupper(second[0]) != 'B')) {
+            return false;
+        }
+        survival = first.substr(1);
+        birth = second.substr(1);
+    } else {
+        survival = first;
+        birth = second;
+    }
+
+    uint16_t birth_mask = 0;
+    uint16_t survival_mask = 0;
+    if (! to_mask(birth, birth_mask) || ! to_mask(survival, survival_mask) || (birth_mask & 1)) {
+        return false;
+    }
+    r = rule(birth_mask, survival_mask);
+    return true;
+}
+
+} // namespace life
@@ -0,0 +1,85 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef LIFE_RULE_H
+#define LIFE_RULE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace life {
+
+/**
+ * \brief   Outer totalistic rule: bit n of the birth mask is set if a dead
+ *          cell with n live neighbours is born, bit n of the survival mask
+ *          if a live one survives.
+ */
+class rule final
+{
+public:
+    static constexpr uint16_t conway_birth = 1 << 3;
+    static constexpr uint16_t conway_survival = (1 << 2) | (1 << 3);
+
+    constexpr rule(const uint16_t birth = conway_birth, const uint16_t survival = conway_survival)
+        : m_birth(birth & 0x1ff)
+        , m_survival(survival & 0x1ff)
+    {}
+
+    constexpr uint16_t birth() const { return m_birth; }
+
+    constexpr bool is_conway() const { return (m_birth == conway_birth) && (m_survival == conway_survival); }
+
+    /// State of a cell in the next generation.
+    constexpr bool next(const bool alive, const size_t neighbours) const
+    {
+        return (((alive ? m_survival : m_birth) >> neighbours) & 1) != 0;
+    }
+
+    constexpr uint16_t survival() const { return m_survival; }
+
+    /// The rule in B/S notation, e.g. "B36/S23".
+    std::string to_string() const;
+
+    constexpr bool operator==(const rule& other) const
+    {
+        return (m_birth == other.m_birth) && (m_survival == other.m_survival);
+    }
+    constexpr bool operator!=(const rule& other) const { return ! (*this == other); }
+
+private:
+    uint16_t m_birth;
+    uint16_t m_survival;
+};
+
+/// Parses a rule in B/S notation ("B36/S23", case insensitive) or in the
+/// older S/B one ("23/36"). Rules with B0 are rejected: they turn the dead
+/// cells around a board and every empty region alive, which none of the
+/// engines can represent.
+bool rule_from_string(const std::string& text, rule& r);
+
+} // namespace life
+
+#endif // LIFE_RULE_H
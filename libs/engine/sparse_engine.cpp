@@ -0,0 +1,291 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "engine/kernel_impl.h"
+#include "engine/sparse_engine.h"
+
+namespace life {
+namespace {
+
+constexpr int64_t tile_shift = 6;
+constexpr int64_t tile_mask = sparse_engine::tile_size - 1;
+
+static_assert((int64_t(1) << tile_shift) == sparse_engine::tile_size, "tile size must match tile shift");
+
+/// Steps the 64 rows of a tile laid out with a halo row above and below.
+/// \return   Whether any cell of the tile is alive.
+template<typename TRule>
+bool step_rows(const TRule& logic, const sparse_engine::word_t* p_rows, const size_t stride,
+               sparse_engine::word_t* p_next)
+{
+    sparse_engine::word_t any = 0;
+    for (size_t r = 0; r < sparse_engine::tile_size; ++r) {
+        const sparse_engine::word_t* p_mid = p_rows + (r + 1) * stride + 1;
+        p_next[r] = logic.next(p_mid - stride, p_mid, p_mid + stride);
+        any |= p_next[r];
+    }
+    return (any != 0);
+}
+
+} // <anonymous> namespace
+
+sparse_engine::sparse_engine(const size_t row_count, const size_t col_count)
+    : m_row_count(row_count)
+    , m_col_count(col_count)
+    , m_generation(0)
+{}
+
+bool sparse_engine::alive(const int64_t row, const int64_t col) const
+{
+    const tiles_t::const_iterator it = m_tiles.find({row >> tile_shift, col >> tile_shift});
+    if (it == m_tiles.cend()) {
+        return false;
+    }
+    return ((it->second[row & tile_mask] >> (col & tile_mask)) & 1) != 0;
+}
+
+const sparse_engine::grid_t& sparse_engine::grid() const
+{
+    m_grid_view.resize(m_row_count);
+    for (row_t& row : m_grid_view) {
+        row.assign(m_col_count, false);
+    }
+
+    for (const tiles_t::value_type& t : m_tiles) {
+        const int64_t top = t.first.row * (int64_t)tile_size;
+        const int64_t left = t.first.col * (int64_t)tile_size;
+        for (size_t r = 0; r < tile_size; ++r) {
+            const int64_t row = top + (int64_t)r;
+            if ((row < 0) || (row >= (int64_t)m_row_count) || (t.second[r] == 0)) {
+                continue;
+            }
+            for (size_t c = 0; c < tile_size; ++c) {
+                const int64_t col = left + (int64_t)c;
+                if ((col >= 0) && (col < (int64_t)m_col_count)) {
+                    m_grid_view[row][col] = ((t.second[r] >> c) & 1) != 0;
+                }
+            }
+        }
+    }
+    return m_grid_view;
+}
+
+bool sparse_engine::next_step()
+{
+    // Every live tile may change, its neighbours only if live cells touch
+    // their common border.
+    constexpr size_t last = tile_size - 1;
+
+    m_candidates.clear();
+    for (const tiles_t::value_type& t : m_tiles) {
+        const tile_t& cells = t.second;
+        word_t west = 0;
+        word_t east = 0;
+        for (const word_t w : cells) {
+            west |= w;
+            east |= w;
+        }
+        west &= 1;
+        east >>= last;
+        const word_t north = cells[0];
+        const word_t south = cells[last];
+
+        const int64_t r = t.first.row;
+        const int64_t c = t.first.col;
+        m_candidates.push_back({r, c});
+        if (north != 0) {
+            m_candidates.push_back({r - 1, c});
+        }
+        if (south != 0) {
+            m_candidates.push_back({r + 1, c});
+        }
+        if (west != 0) {
+            m_candidates.push_back({r, c - 1});
+        }
+        if (east != 0) {
+            m_candidates.push_back({r, c + 1});
+        }
+        if ((north & 1) != 0) {
+            m_candidates.push_back({r - 1, c - 1});
+        }
+        if ((north >> last) != 0) {
+            m_candidates.push_back({r - 1, c + 1});
+        }
+        if ((south & 1) != 0) {
+            m_candidates.push_back({r + 1, c - 1});
+        }
+        if ((south >> last) != 0) {
+            m_candidates.push_back({r + 1, c + 1});
+        }
+    }
+    std::sort(m_candidates.begin(), m_candidates.end());
+    m_candidates.erase(std::unique(m_candidates.begin(), m_candidates.end()), m_candidates.end());
+
+    // The nodes of the previous generation are reused and tiles are stepped
+    // right into them, so a run whose tile count does not grow does not
+    // allocate.
+    for (tiles_t::const_iterator it = m_next_tiles.cbegin(); it != m_next_tiles.cend();) {
+        m_spare_tiles.push_back(m_next_tiles.extract(it++));
+    }
+    for (const tile_key& key : m_candidates) {
+        if (m_spare_tiles.empty()) {
+            const tiles_t::iterator it = m_next_tiles.emplace(key, tile_t()).first;
+            if (! next_tile(key, it->second)) {
+                m_spare_tiles.push_back(m_next_tiles.extract(it));
+            }
+            continue;
+        }
+        tiles_t::node_type& node = m_spare_tiles.back();
+        if (next_tile(key, node.mapped())) {
+            node.key() = key;
+            m_next_tiles.insert(std::move(node));
+            m_spare_tiles.pop_back();
+        }
+    }
+
+    m_tiles.swap(m_next_tiles);
+    ++m_generation;
+    return true;
+}
+
+bool sparse_engine::next_tile(const tile_key& key, tile_t& next) const
+{
+    static const tile_t dead_tile = {};
+
+    const tile_t* p_tiles[3][3];
+    for (int64_t dr = -1; dr <= 1; ++dr) {
+        for (int64_t dc = -1; dc <= 1; ++dc) {
+            const tiles_t::const_iterator it = m_tiles.find({key.row + dr, key.col + dc});
+            p_tiles[dr + 1][dc + 1] = (it == m_tiles.cend()) ? &dead_tile : &it->second;
+        }
+    }
+
+    // Rows -1..64 of the tile with the adjacent words of the west and east
+    // neighbours, laid out as the stepping kernel expects.
+    constexpr size_t stride = 3;
+    word_t rows[(tile_size + 2) * stride];
+    for (size_t r = 0; r < tile_size + 2; ++r) {
+        const size_t band = (r == 0) ? 0 : ((r <= tile_size) ? 1 : 2);
+        const size_t y = (r + tile_size - 1) % tile_size;
+        rows[r * stride] = (*p_tiles[band][0])[y];
+        rows[r * stride + 1] = (*p_tiles[band][1])[y];
+        rows[r * stride + 2] = (*p_tiles[band][2])[y];
+    }
+
+    if (m_rule.is_conway()) {
+        return step_rows(kernel::conway_rule<word_t>(m_rule), rows, stride, next.data());
+    }
+    return step_rows(kernel::generic_rule<word_t>(m_rule), rows, stride, next.data());
+}
+
+uint64_t sparse_engine::population() const
+{
+    uint64_t count = 0;
+    for (const tiles_t::value_type& t : m_tiles) {
+        for (const word_t w : t.second) {
+            count += __builtin_popcountll(w);
+        }
+    }
+    return count;
+}
+
+bool sparse_engine::restart(const grid_t& begin_state)
+{
+    stop();
+    return start(begin_state);
+}
+
+void sparse_engine::set(const int64_t row, const int64_t col, const bool alive)
+{
+    const tile_key key = {row >> tile_shift, col >> tile_shift};
+    const word_t bit = word_t(1) << (col & tile_mask);
+    if (alive) {
+        m_tiles[key][row & tile_mask] |= bit;
+        return;
+    }
+
+    const tiles_t::iterator it = m_tiles.find(key);
+    if (it == m_tiles.end()) {
+        return;
+    }
+    it->second[row & tile_mask] &= ~bit;
+    if (std::all_of(it->second.cbegin(), it->second.cend(), [] (const word_t w) -> bool { return w == 0; })) {
+        m_tiles.erase(it);
+    }
+}
+
+bool sparse_engine::start(const grid_t& begin_state)
+{
+    stop();
+
+    for (size_t r = 0; r < std::min(begin_state.size(), m_row_count); ++r) {
+        const row_t& row = begin_state[r];
+        for (size_t c = 0; c < std::min(row.size(), m_col_count); ++c) {
+            if (row[c]) {
+                set(r, c, true);
+            }
+        }
+    }
+    return true;
+}
+
+bool sparse_engine::start(const bit_grid& begin_state)
+{
+    stop();
+
+    // A data word of the packed board is exactly a row of a tile.
+    static_assert(bit_grid::word_bits == tile_size, "tile rows must match packed words");
+    const size_t row_count = std::min(begin_state.row_count(), m_row_count);
+    const size_t col_count = std::min(begin_state.col_count(), m_col_count);
+    const size_t words = (col_count + tile_size - 1) / tile_size;
+    for (size_t r = 0; r < row_count; ++r) {
+        const bit_grid::word_t* p_row = begin_state.row_ptr(r);
+        for (size_t w = 0; w < words; ++w) {
+            word_t bits = p_row[w];
+            if (((w + 1) * tile_size) > col_count) {
+                bits &= (word_t(1) << (col_count % tile_size)) - 1;
+            }
+            if (bits != 0) {
+                m_tiles[tile_key{int64_t(r) >> tile_shift, int64_t(w)}][r & tile_mask] |= bits;
+            }
+        }
+    }
+    return true;
+}
+
+bool sparse_engine::step_n(const uint64_t generations)
+{
+    for (uint64_t i = 0; i < generations; ++i) {
+        next_step();
+    }
+    return true;
+}
+
+void sparse_engine::stop()
+{
+    m_tiles.clear();
+    m_generation = 0;
+}
+
+} // namespace life
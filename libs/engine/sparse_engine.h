@@ -0,0 +1,157 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_SPARSE_ENGINE_H
+#define LIFE_SPARSE_ENGINE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/bit_grid.h"
+#include "engine/rule.h"
+
+namespace life {
+
+/**
+ * \brief   Unbounded engine for Conway's Game of Life that stores only
+ *          the occupied 64x64 tiles of the universe.
+ *
+ * Tiles are kept in a hash map keyed by tile coordinates. A tile is created
+ * as soon as a live cell touches its border and dropped as soon as it dies
+ * out, so memory follows the live area of the pattern rather than its
+ * bounding box. grid() shows the row_count() x col_count() window at the
+ * origin.
+ */
+class sparse_engine final
+{
+public:
+    using row_t = std::vector<bool>;
+    using grid_t = std::vector<row_t>;
+
+    using word_t = uint64_t;
+
+    static constexpr size_t tile_size = 64;
+
+    sparse_engine(const size_t row_count = 25, const size_t col_count = 25);
+
+    bool next_step();
+
+    bool restart(const grid_t& begin_state);
+
+    bool start(const grid_t& begin_state);
+
+    /// Starts from a packed board, clipped to the window size.
+    bool start(const bit_grid& begin_state);
+
+    /// Advances the universe by 'generations', without allocating memory
+    /// once the number of tiles stops growing.
+    bool step_n(const uint64_t generations);
+
+    template<typename TType>
+    bool start(const std::vector<std::vector<TType>>& begin, const TType& alive_val)
+    {
+        grid_t begin_state(std::min(begin.size(), m_row_count));
+        for (size_t r = 0; r < begin_state.size(); ++r) {
+            const std::vector<TType>& row = begin[r];
+            begin_state[r].resize(std::min(row.size(), m_col_count));
+            for (size_t c = 0; c < begin_state[r].size(); ++c) {
+                begin_state[r][c] = (row[c] == alive_val);
+            }
+        }
+
+        return start(begin_state);
+    }
+
+    bool alive(const int64_t row, const int64_t col) const;
+
+    size_t col_count() const { return m_col_count; }
+
+    uint64_t generation() const { return m_generation; }
+
+    /// The row_count() x col_count() window of the universe at the origin.
+    const grid_t& grid() const;
+
+    uint64_t population() const;
+
+    size_t row_count() const { return m_row_count; }
+
+    const life::rule& rule() const { return m_rule; }
+
+    void set(const int64_t row, const int64_t col, const bool alive);
+
+    void set_rule(const life::rule& r) { m_rule = r; }
+
+    void stop();
+
+    size_t tile_count() const { return m_tiles.size(); }
+
+private:
+    using tile_t = std::array<word_t, tile_size>;
+
+    struct tile_key final
+    {
+        int64_t row;
+        int64_t col;
+
+        bool operator==(const tile_key& other) const { return (row == other.row) && (col == other.col); }
+        bool operator<(const tile_key& other) const
+        {
+            return (row < other.row) || ((row == other.row) && (col < other.col));
+        }
+    };
+
+    struct tile_key_hash final
+    {
+        size_t operator()(const tile_key& k) const
+        {
+            const uint64_t h = (uint64_t)k.row * 0x9E3779B97F4A7C15ull + (uint64_t)k.col;
+            return h ^ (h >> 31);
+        }
+    };
+
+    using tiles_t = std::unordered_map<tile_key, tile_t, tile_key_hash>;
+
+private:
+    bool next_tile(const tile_key& key, tile_t& next) const;
+
+private:
+    size_t m_row_count;
+    size_t m_col_count;
+    uint64_t m_generation;
+    life::rule m_rule;
+
+    tiles_t m_tiles;
+    tiles_t m_next_tiles;
+    std::vector<tiles_t::node_type> m_spare_tiles;
+    std::vector<tile_key> m_candidates;
+
+    mutable grid_t m_grid_view;
+};
+
+} // namespace life
+
+#endif // LIFE_SPARSE_ENGINE_H
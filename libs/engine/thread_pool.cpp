@@ -0,0 +1,120 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "engine/thread_pool.h"
+
+namespace life {
+
+thread_pool::thread_pool(const size_t thread_count)
+{
+    size_t count = thread_count;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_workers.reserve(count - 1);
+    for (size_t i = 1; i < count; ++i) {
+        m_workers.emplace_back(&thread_pool::worker_loop, this);
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stopped = true;
+    }
+    m_start_cv.notify_all();
+    for (std::thread& t : m_workers) {
+        t.join();
+    }
+}
+
+void thread_pool::run_impl(const size_t task_count, const void* p_task, const call_t call)
+{
+    if (m_workers.empty() || (task_count < 2)) {
+        for (size_t i = 0; i < task_count; ++i) {
+            call(p_task, i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_p_task = p_task;
+        m_call = call;
+        m_task_count = task_count;
+        m_next_task = 0;
+        m_busy_workers = m_workers.size();
+        ++m_round;
+    }
+    m_start_cv.notify_all();
+
+    run_tasks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cv.wait(lock, [this] () -> bool { return (m_busy_workers == 0); });
+    m_p_task = nullptr;
+}
+
+void thread_pool::run_tasks()
+{
+    while (true) {
+        size_t idx;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_next_task == m_task_count) {
+                return;
+            }
+            idx = m_next_task++;
+        }
+        m_call(m_p_task, idx);
+    }
+}
+
+void thread_pool::worker_loop()
+{
+    uint64_t round = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_cv.wait(lock, [this, round] () -> bool { return m_is_stopped || (m_round != round); });
+            if (m_is_stopped) {
+                return;
+            }
+            round = m_round;
+        }
+
+        run_tasks();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy_workers == 0) {
+            m_done_cv.notify_one();
+        }
+    }
+}
+
+} // namespace life
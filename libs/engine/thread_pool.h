@@ -0,0 +1,92 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIFE_THREAD_POOL_H
+#define LIFE_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace life {
+
+/**
+ * \brief   Persistent pool of worker threads for fork-join loops.
+ *
+ * Threads are created once in the constructor and sleep between calls of
+ * run(), so a parallel step costs a wake up instead of a thread creation.
+ */
+class thread_pool final
+{
+public:
+    /// 'thread_count' includes the calling thread, 0 means all CPUs.
+    explicit thread_pool(const size_t thread_count = 0);
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool();
+
+    /// Calls task(i) for every i in [0, task_count) and waits for all calls.
+    /// The task is passed by reference, so a call never allocates memory.
+    template<typename TTask>
+    void run(const size_t task_count, const TTask& task)
+    {
+        run_impl(task_count, &task, [] (const void* p_task, const size_t idx) {
+                                        (*static_cast<const TTask*>(p_task))(idx);
+                                    });
+    }
+
+    size_t thread_count() const { return m_workers.size() + 1; }
+
+private:
+    using call_t = void (*)(const void* p_task, const size_t idx);
+
+    void run_impl(const size_t task_count, const void* p_task, const call_t call);
+
+    void run_tasks();
+
+    void worker_loop();
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start_cv;
+    std::condition_variable m_done_cv;
+
+    const void* m_p_task = nullptr;
+    call_t m_call = nullptr;
+    size_t m_task_count = 0;
+    size_t m_next_task = 0;
+    size_t m_busy_workers = 0;
+    uint64_t m_round = 0;
+    bool m_is_stopped = false;
+};
+
+} // namespace life
+
+#endif // LIFE_THREAD_POOL_H
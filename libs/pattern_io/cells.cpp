@@ -0,0 +1,95 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pattern_io/cells.h"
+
+namespace pio {
+
+cells_parser::cells_parser(sink& out)
+    : parser(out)
+    , m_is_comment(false)
+    , m_is_line_start(true)
+    , m_row(0)
+    , m_col(0)
+    , m_run_begin(-1)
+{}
+
+void cells_parser::end_run()
+{
+    if (m_run_begin >= 0) {
+        m_sink.on_cells(m_row, m_run_begin, m_col - m_run_begin);
+        m_run_begin = -1;
+    }
+}
+
+bool cells_parser::feed(const char* p_data, const size_t size)
+{
+    if (has_error()) {
+        return false;
+    }
+
+    for (const char* p = p_data; p != (p_data + size); ++p) {
+        const char c = *p;
+        if (c == '\n') {
+            end_run();
+            if (! m_is_comment) {
+                ++m_row;
+            }
+            m_col = 0;
+            m_is_comment = false;
+            m_is_line_start = true;
+            ++m_line;
+            continue;
+        }
+        if (m_is_comment) {
+            continue;
+        }
+        if (m_is_line_start && (c == '!')) {
+            m_is_comment = true;
+            continue;
+        }
+        m_is_line_start = false;
+
+        if ((c == 'O') || (c == '*')) {
+            if (m_run_begin < 0) {
+                m_run_begin = m_col;
+            }
+            ++m_col;
+        } else if (c == '.') {
+            end_run();
+            ++m_col;
+        } else if ((c != ' ') && (c != '\t') && (c != '\r')) {
+            return fail(std::string("unexpected character '") + c + "'");
+        }
+    }
+    return true;
+}
+
+bool cells_parser::finish()
+{
+    end_run();
+    return ! has_error();
+}
+
+} // namespace pio
@@ -0,0 +1,613 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(PATTERN_IO_ZLIB)
+#include <zlib.h>
+#endif
+
+#include "pattern_io/generation_log.h"
+
+namespace pio {
+namespace {
+
+constexpr char magic[8] = {'L', 'I', 'F', 'E', 'H', 'I', 'S', 'T'};
+constexpr char index_magic[8] = {'H', 'I', 'S', 'T', 'I', 'N', 'D', 'X'};
+constexpr uint32_t version = 1;
+constexpr uint32_t byte_order = 0x01020304;
+constexpr size_t align = 64;
+constexpr size_t max_rule_size = 4096;
+// Longer sides are beyond any board that fits in memory, so they can only
+// come from a corrupted header.
+constexpr uint64_t max_side = uint64_t(1) << 24;
+
+struct file_header final
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t row_count;
+    uint64_t col_count;
+    uint64_t keyframe_every;
+    uint32_t compression;
+    uint32_t rule_size;
+    uint64_t reserved[2];
+};
+
+static_assert(sizeof(file_header) == align, "log header must fill a cache line");
+
+enum record_kind_t : uint32_t
+{
+    keyframe_record = 1,
+    delta_record = 2,
+    index_record = 3
+};
+
+struct record_header final
+{
+    uint64_t generation;
+    uint32_t kind;
+    uint32_t size;          ///< Stored payload bytes.
+    uint32_t raw_size;      ///< Payload bytes before compression.
+    uint32_t checksum;      ///< Of the fields above and the stored payload.
+};
+
+/// The index record is followed by its offset and a magic, the last bytes
+/// of a closed log.
+struct index_trailer final
+{
+    uint64_t index_offset;
+    char magic[8];
+};
+
+size_t align_up(const size_t size)
+{
+    return ((size + align - 1) / align) * align;
+}
+
+/// FNV style hash over whole words, folded to 32 bits.
+uint32_t checksum(const char* p_data, const size_t size, uint64_t h = 0xcbf29ce484222325ull)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t w;
+        std::memcpy(&w, p_data + i, sizeof(w));
+        h = (h ^ w) * 0x100000001b3ull;
+    }
+    for (; i < size; ++i) {
+        h = (h ^ (uint8_t)p_data[i]) * 0x100000001b3ull;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+void append_varint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+bool read_varint(const char*& p, const char* p_end, uint64_t& value)
+{
+    value = 0;
+    for (size_t shift = 0; (p != p_end) && (shift < 64); shift += 7) {
+        const uint8_t byte = (uint8_t)*p++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Encodes the words as pairs of a zero word run length and a literal word
+/// count, each pair followed by its literal words.
+void encode(const std::vector<uint64_t>& words, std::string& out)
+{
+    out.clear();
+    size_t i = 0;
+    while (i < words.size()) {
+        const size_t zero_begin = i;
+        while ((i < words.size()) && (words[i] == 0)) {
+            ++i;
+        }
+        const size_t literal_begin = i;
+        while ((i < words.size()) && (words[i] != 0)) {
+            ++i;
+        }
+        append_varint(out, literal_begin - zero_begin);
+        append_varint(out, i - literal_begin);
+        out.append(reinterpret_cast<const char*>(words.data() + literal_begin), (i - literal_begin) * sizeof(uint64_t));
+    }
+}
+
+/// XORs the encoded words into 'words'.
+bool decode_xor(const char* p, const char* p_end, std::vector<uint64_t>& words)
+{
+    size_t i = 0;
+    while (p != p_end) {
+        uint64_t zeros = 0;
+        uint64_t literals = 0;
+        if (! read_varint(p, p_end, zeros) || ! read_varint(p, p_end, literals)
+            || (zeros > words.size() - i) || (literals > words.size() - i - zeros)
+            || (literals > (size_t)(p_end - p) / sizeof(uint64_t))) {
+            return false;
+        }
+        i += zeros;
+        for (uint64_t n = 0; n < literals; ++n, ++i, p += sizeof(uint64_t)) {
+            uint64_t w;
+            std::memcpy(&w, p, sizeof(w));
+            words[i] ^= w;
+        }
+    }
+    return true;
+}
+
+/// Covers the header fields before the checksum and the stored payload.
+uint32_t checksum(const record_header& h, const char* p_payload)
+{
+    const size_t fields_size = offsetof(record_header, checksum);
+    return checksum(p_payload, h.size, checksum(reinterpret_cast<const char*>(&h), fields_size));
+}
+
+} // <anonymous> namespace
+
+bool compression_from_string(const std::string& name, compression_t& compression)
+{
+    if (name == "none") {
+        compression = compression_t::none;
+    } else if (name == "zlib") {
+        compression = compression_t::zlib;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool has_compression(const compression_t compression)
+{
+#if defined(PATTERN_IO_ZLIB)
+    return (compression == compression_t::none) || (compression == compression_t::zlib);
+#else
+    return (compression == compression_t::none);
+#endif
+}
+
+log_writer::log_writer()
+    : m_row_count(0)
+    , m_col_count(0)
+    , m_keyframe_every(0)
+    , m_compression(compression_t::none)
+    , m_offset(0)
+    , m_frame_count(0)
+    , m_generation(0)
+    , m_next_keyframe(0)
+{}
+
+log_writer::~log_writer()
+{
+    close();
+}
+
+bool log_writer::close()
+{
+    if (m_out.is_open()) {
+        // Index payload: frame count, first and last generations, then the
+        // generation and offset of every keyframe.
+        m_encoded.clear();
+        const uint64_t first = m_keyframes.empty() ? 0 : m_keyframes.front();
+        for (const uint64_t value : {m_frame_count, first, m_generation}) {
+            m_encoded.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        m_encoded.append(reinterpret_cast<const char*>(m_keyframes.data()), m_keyframes.size() * sizeof(uint64_t));
+
+        index_trailer trailer;
+        trailer.index_offset = m_offset;
+        std::memcpy(trailer.magic, index_magic, sizeof(index_magic));
+        if (write_record(index_record, m_generation)) {
+            m_out.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+            m_out.close();
+            if (m_out.fail()) {
+                fail("could not write '" + m_path + "'");
+            }
+        }
+    }
+    return m_error.empty();
+}
+
+bool log_writer::fail(const std::string& msg)
+{
+    if (m_error.empty()) {
+        m_error = msg;
+    }
+    m_out.close();
+    return false;
+}
+
+bool log_writer::open(const std::string& path, const size_t row_count, const size_t col_count, const std::string& rule,
+                      const uint64_t keyframe_every, const compression_t compression)
+{
+    close();
+    m_error.clear();
+    if (keyframe_every == 0) {
+        return fail("keyframe interval must be positive");
+    }
+    if (! has_compression(compression)) {
+        return fail("compression is not supported by this build");
+    }
+    if (rule.size() > max_rule_size) {
+        return fail("rule is too long");
+    }
+
+    m_out.open(path, std::ios::binary | std::ios::trunc);
+    if (! m_out.is_open()) {
+        return fail("could not open '" + path + "'");
+    }
+
+    file_header h = {};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.byte_order = byte_order;
+    h.row_count = row_count;
+    h.col_count = col_count;
+    h.keyframe_every = keyframe_every;
+    h.compression = (uint32_t)compression;
+    h.rule_size = (uint32_t)rule.size();
+    std::string head(reinterpret_cast<const char*>(&h), sizeof(h));
+    head += rule;
+    head.resize(align_up(head.size()), '\0');
+    m_out.write(head.data(), head.size());
+
+    m_path = path;
+    m_row_count = row_count;
+    m_col_count = col_count;
+    m_keyframe_every = keyframe_every;
+    m_compression = compression;
+    m_offset = head.size();
+    m_frame_count = 0;
+    m_generation = 0;
+    m_next_keyframe = 0;
+    m_keyframes.clear();
+    const size_t words = (col_count + life::bit_grid::word_bits - 1) / life::bit_grid::word_bits;
+    m_last.assign(row_count * words, 0);
+    m_words.assign(row_count * words, 0);
+    return m_out.good() || fail("could not write '" + path + "'");
+}
+
+bool log_writer::write(const life::bit_grid& grid, const uint64_t generation)
+{
+    if (! m_out.is_open()) {
+        return fail("log is not open");
+    }
+    if ((grid.row_count() != m_row_count) || (grid.col_count() != m_col_count)) {
+        return fail("board size differs from the log");
+    }
+    if ((m_frame_count != 0) && (generation <= m_generation)) {
+        return fail("generation " + std::to_string(generation) + " is not after the last written one");
+    }
+
+    const size_t words = grid.words();
+    for (size_t r = 0; r < m_row_count; ++r) {
+        uint64_t* p_dst = m_words.data() + r * words;
+        std::copy_n(grid.row_ptr(r), words, p_dst);
+        p_dst[words - 1] &= grid.last_word_mask();
+    }
+
+    const bool is_keyframe = (m_frame_count == 0) || (generation >= m_next_keyframe);
+    if (is_keyframe) {
+        encode(m_words, m_encoded);
+        m_keyframes.push_back(generation);
+        m_keyframes.push_back(m_offset);
+        m_next_keyframe = generation + m_keyframe_every;
+    } else {
+        for (size_t i = 0; i < m_last.size(); ++i) {
+            m_last[i] ^= m_words[i];
+        }
+        encode(m_last, m_encoded);
+    }
+    m_last.swap(m_words);
+
+    if (! write_record(is_keyframe ? keyframe_record : delta_record, generation)) {
+        return false;
+    }
+    ++m_frame_count;
+    m_generation = generation;
+    return true;
+}
+
+bool log_writer::write_record(const uint32_t kind, const uint64_t generation)
+{
+    const std::string* p_payload = &m_encoded;
+#if defined(PATTERN_IO_ZLIB)
+    if ((m_compression == compression_t::zlib) && (kind != index_record)) {
+        uLongf size = compressBound(m_encoded.size());
+        m_compressed.resize(size);
+        if (compress2(reinterpret_cast<Bytef*>(&m_compressed[0]), &size,
+                      reinterpret_cast<const Bytef*>(m_encoded.data()), m_encoded.size(), 1) != Z_OK) {
+            return fail("could not compress generation " + std::to_string(generation));
+        }
+        m_compressed.resize(size);
+        p_payload = &m_compressed;
+    }
+#endif
+    if ((p_payload->size() > UINT32_MAX) || (m_encoded.size() > UINT32_MAX)) {
+        return fail("generation " + std::to_string(generation) + " is too large for a record");
+    }
+
+    record_header h;
+    h.generation = generation;
+    h.kind = kind;
+    h.size = (uint32_t)p_payload->size();
+    h.raw_size = (uint32_t)m_encoded.size();
+    h.checksum = checksum(h, p_payload->data());
+    m_out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    m_out.write(p_payload->data(), p_payload->size());
+    if (! m_out.good()) {
+        return fail("could not write '" + m_path + "'");
+    }
+    m_offset += sizeof(h) + p_payload->size();
+    return true;
+}
+
+log_reader::log_reader()
+    : m_row_count(0)
+    , m_col_count(0)
+    , m_compression(compression_t::none)
+    , m_first_generation(0)
+    , m_last_generation(0)
+    , m_frame_count(0)
+    , m_offset(0)
+    , m_generation(0)
+    , m_has_frame(false)
+{}
+
+bool log_reader::fail(const std::string& msg)
+{
+    m_error = msg;
+    return false;
+}
+
+bool log_reader::next(life::bit_grid& grid)
+{
+    if (! read_record()) {
+        return false;
+    }
+    store(grid);
+    return true;
+}
+
+bool log_reader::open(const std::string& path)
+{
+    m_error.clear();
+    m_keyframes.clear();
+    m_frame_count = 0;
+    m_first_generation = 0;
+    m_last_generation = 0;
+    m_generation = 0;
+    m_has_frame = false;
+
+    if (! m_file.open(path, mapped_file::none)) {
+        return fail(m_file.error_msg());
+    }
+
+    file_header h;
+    if (m_file.size() < sizeof(h)) {
+        return fail("'" + path + "' is not a generation log");
+    }
+    std::memcpy(&h, m_file.data(), sizeof(h));
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0) {
+        return fail("'" + path + "' is not a generation log");
+    }
+    if (h.byte_order != byte_order) {
+        return fail("'" + path + "' was written on a machine of another byte order");
+    }
+    if (h.version != version) {
+        return fail("'" + path + "' has unsupported version " + std::to_string(h.version));
+    }
+    if ((h.rule_size > max_rule_size) || (h.compression > (uint32_t)compression_t::zlib)
+        || (h.row_count > max_side) || (h.col_count > max_side)) {
+        return fail("'" + path + "' has a corrupted header");
+    }
+    m_compression = (compression_t)h.compression;
+    if (! has_compression(m_compression)) {
+        return fail("'" + path + "' is compressed, this build can not read it");
+    }
+    const uint64_t data_offset = align_up(sizeof(h) + h.rule_size);
+    if (m_file.size() < data_offset) {
+        return fail("'" + path + "' is truncated");
+    }
+
+    m_row_count = h.row_count;
+    m_col_count = h.col_count;
+    m_rule.assign(m_file.data() + sizeof(h), h.rule_size);
+    if (! read_index(data_offset)) {
+        scan_records(data_offset);
+    }
+
+    // Frames come from records of up to UINT32_MAX bytes, a board larger
+    // than that per record of the file does not fit in it. The sides are
+    // bounded, so the sizes do not overflow.
+    const uint64_t words = (m_col_count + life::bit_grid::word_bits - 1) / life::bit_grid::word_bits;
+    const uint64_t frame_size = m_row_count * words * sizeof(uint64_t);
+    if (((words == 0) && (m_col_count != 0))
+        || (frame_size / std::max<uint64_t>(m_frame_count, 1) > UINT32_MAX)) {
+        return fail("'" + path + "' has a corrupted header");
+    }
+    m_words.assign(m_row_count * words, 0);
+    m_offset = data_offset;
+    return true;
+}
+
+bool log_reader::read_index(const uint64_t data_offset)
+{
+    index_trailer trailer;
+    if (m_file.size() < data_offset + sizeof(record_header) + sizeof(trailer)) {
+        return false;
+    }
+    std::memcpy(&trailer, m_file.data() + m_file.size() - sizeof(trailer), sizeof(trailer));
+    if ((std::memcmp(trailer.magic, index_magic, sizeof(index_magic)) != 0) || (trailer.index_offset < data_offset)
+        || (trailer.index_offset > m_file.size() - sizeof(trailer) - sizeof(record_header))) {
+        return false;
+    }
+
+    record_header h;
+    std::memcpy(&h, m_file.data() + trailer.index_offset, sizeof(h));
+    const char* p_payload = m_file.data() + trailer.index_offset + sizeof(h);
+    const uint64_t values_size = 3 * sizeof(uint64_t);
+    if ((h.kind != index_record) || (trailer.index_offset + sizeof(h) + h.size + sizeof(trailer) != m_file.size())
+        || (h.size < values_size) || ((h.size - values_size) % (2 * sizeof(uint64_t)) != 0)
+        || (h.checksum != checksum(h, p_payload))) {
+        return false;
+    }
+
+    uint64_t values[3];
+    std::memcpy(values, p_payload, values_size);
+    m_frame_count = values[0];
+    m_first_generation = values[1];
+    m_last_generation = values[2];
+    m_keyframes.resize((h.size - values_size) / sizeof(keyframe));
+    std::memcpy(m_keyframes.data(), p_payload + values_size, h.size - values_size);
+    return true;
+}
+
+bool log_reader::read_record()
+{
+    record_header h;
+    if (m_offset + sizeof(h) > m_file.size()) {
+        return false;
+    }
+    std::memcpy(&h, m_file.data() + m_offset, sizeof(h));
+    if ((h.kind != keyframe_record) && (h.kind != delta_record)) {
+        return false;
+    }
+    if (h.size > m_file.size() - m_offset - sizeof(h)) {
+        return fail("generation " + std::to_string(h.generation) + " is truncated");
+    }
+    const char* p_payload = m_file.data() + m_offset + sizeof(h);
+    if (checksum(h, p_payload) != h.checksum) {
+        return fail("generation " + std::to_string(h.generation) + " is corrupted, checksum mismatch");
+    }
+    if ((h.kind == delta_record) && ! m_has_frame) {
+        return fail("generation " + std::to_string(h.generation) + " is a delta without a keyframe");
+    }
+
+    const char* p_begin = p_payload;
+    const char* p_end = p_payload + h.size;
+#if defined(PATTERN_IO_ZLIB)
+    if (m_compression == compression_t::zlib) {
+        m_decoded.resize(h.raw_size);
+        uLongf size = h.raw_size;
+        if ((uncompress(reinterpret_cast<Bytef*>(&m_decoded[0]), &size, reinterpret_cast<const Bytef*>(p_payload),
+                        h.size) != Z_OK) || (size != h.raw_size)) {
+            return fail("generation " + std::to_string(h.generation) + " could not be decompressed");
+        }
+        p_begin = m_decoded.data();
+        p_end = m_decoded.data() + m_decoded.size();
+    }
+#endif
+
+    if (h.kind == keyframe_record) {
+        std::fill(m_words.begin(), m_words.end(), 0);
+    }
+    if (! decode_xor(p_begin, p_end, m_words)) {
+        m_has_frame = false;
+        return fail("generation " + std::to_string(h.generation) + " is corrupted");
+    }
+    m_generation = h.generation;
+    m_has_frame = true;
+    m_offset += sizeof(h) + h.size;
+    return true;
+}
+
+void log_reader::scan_records(const uint64_t data_offset)
+{
+    // Walks the headers of a log that was not closed, up to the first
+    // record that is not whole.
+    record_header h;
+    for (uint64_t offset = data_offset; offset + sizeof(h) <= m_file.size(); offset += sizeof(h) + h.size) {
+        std::memcpy(&h, m_file.data() + offset, sizeof(h));
+        if (((h.kind != keyframe_record) && (h.kind != delta_record))
+            || (h.size > m_file.size() - offset - sizeof(h))) {
+            break;
+        }
+        if (h.kind == keyframe_record) {
+            m_keyframes.push_back({h.generation, offset});
+        }
+        if (m_frame_count == 0) {
+            m_first_generation = h.generation;
+        }
+        m_last_generation = h.generation;
+        ++m_frame_count;
+    }
+}
+
+bool log_reader::seek(const uint64_t generation, life::bit_grid& grid)
+{
+    m_error.clear();
+    if ((m_frame_count == 0) || (generation < m_first_generation) || (generation > m_last_generation)) {
+        return fail("generation " + std::to_string(generation) + " is not in the log");
+    }
+
+    // The last keyframe at or before the generation. Reading on from the
+    // current record is cheaper if it is already past that keyframe.
+    const auto it = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), generation,
+                                     [] (const uint64_t g, const keyframe& k) { return g < k.generation; });
+    if (it == m_keyframes.cbegin()) {
+        return fail("generation " + std::to_string(generation) + " is not in the log");
+    }
+    const keyframe& key = *(it - 1);
+    if (! m_has_frame || (m_generation > generation) || (m_generation < key.generation)) {
+        m_offset = key.offset;
+        m_has_frame = false;
+    }
+
+    while (! m_has_frame || (m_generation < generation)) {
+        if (! read_record()) {
+            return m_error.empty() ? fail("generation " + std::to_string(generation) + " is not in the log") : false;
+        }
+    }
+    if (m_generation != generation) {
+        return fail("generation " + std::to_string(generation) + " was not recorded");
+    }
+    store(grid);
+    return true;
+}
+
+void log_reader::store(life::bit_grid& grid) const
+{
+    if ((grid.row_count() != m_row_count) || (grid.col_count() != m_col_count)) {
+        grid.resize(m_row_count, m_col_count);
+    }
+    const size_t words = grid.words();
+    for (size_t r = 0; r < m_row_count; ++r) {
+        std::copy_n(m_words.data() + r * words, words, grid.row_ptr(r));
+    }
+}
+
+} // namespace pio
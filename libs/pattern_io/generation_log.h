@@ -0,0 +1,202 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PATTERN_IO_GENERATION_LOG_H
+#define PATTERN_IO_GENERATION_LOG_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "engine/bit_grid.h"
+#include "pattern_io/mapped_file.h"
+
+namespace pio {
+
+/**
+ * \brief   Compression of the frames of a generation log.
+ */
+enum class compression_t
+{
+    none,
+    zlib        ///< Only if the library is built with zlib.
+};
+
+bool compression_from_string(const std::string& name, compression_t& compression);
+
+/// Whether the build can write and read logs with the compression.
+bool has_compression(const compression_t compression);
+
+/**
+ * \brief   Writes the history of a board as a generation log.
+ *
+ * A log is a 64 byte header with the board size, a rule string padded to
+ * 64 bytes and one record per written generation. Every keyframe_every
+ * generations a record holds the whole board, the others hold the XOR with
+ * the previous record, so a step that changes a few cells costs a few
+ * bytes. Records encode runs of zero words and literal words and may be
+ * compressed on top. close() appends an index of the keyframes; a log that
+ * was never closed is still readable, the reader then finds the keyframes
+ * by walking the records.
+ */
+class log_writer final
+{
+public:
+    log_writer();
+
+    log_writer(const log_writer&) = delete;
+
+    log_writer& operator=(const log_writer&) = delete;
+
+    ~log_writer();
+
+    /// Writes the keyframe index and closes the file.
+    /// \return   false if any write failed since open().
+    bool close();
+
+    const std::string& error_msg() const { return m_error; }
+
+    bool open(const std::string& path, const size_t row_count, const size_t col_count, const std::string& rule,
+              const uint64_t keyframe_every, const compression_t compression = compression_t::none);
+
+    /// Appends the board of 'generation', generations must grow. After a
+    /// failed write the log stays closed and further writes fail at once.
+    bool write(const life::bit_grid& grid, const uint64_t generation);
+
+private:
+    bool fail(const std::string& msg);
+
+    bool write_record(const uint32_t kind, const uint64_t generation);
+
+private:
+    std::ofstream m_out;
+    std::string m_path;
+    std::string m_error;
+
+    size_t m_row_count;
+    size_t m_col_count;
+    uint64_t m_keyframe_every;
+    compression_t m_compression;
+
+    uint64_t m_offset;
+    uint64_t m_frame_count;
+    uint64_t m_generation;
+    uint64_t m_next_keyframe;
+
+    // Previous board, words of all rows without halos, and encoding buffers.
+    std::vector<uint64_t> m_last;
+    std::vector<uint64_t> m_words;
+    std::string m_encoded;
+    std::string m_compressed;
+
+    // Generation and file offset of every keyframe.
+    std::vector<uint64_t> m_keyframes;
+};
+
+/**
+ * \brief   Reads a generation log. Any generation is decoded from the
+ *          keyframe before it, so seeking costs at most keyframe_every
+ *          records whatever the length of the log.
+ */
+class log_reader final
+{
+public:
+    log_reader();
+
+    size_t col_count() const { return m_col_count; }
+
+    compression_t compression() const { return m_compression; }
+
+    const std::string& error_msg() const { return m_error; }
+
+    uint64_t first_generation() const { return m_first_generation; }
+
+    uint64_t frame_count() const { return m_frame_count; }
+
+    /// Generation of the last board read.
+    uint64_t generation() const { return m_generation; }
+
+    size_t keyframe_count() const { return m_keyframes.size(); }
+
+    uint64_t last_generation() const { return m_last_generation; }
+
+    /// Reads the board of the record after the last one read, or the first
+    /// one after open().
+    /// \return   false at the end of the log or on errors.
+    bool next(life::bit_grid& grid);
+
+    bool open(const std::string& path);
+
+    size_t row_count() const { return m_row_count; }
+
+    const std::string& rule() const { return m_rule; }
+
+    /// Reads the board of 'generation', which must have been written.
+    bool seek(const uint64_t generation, life::bit_grid& grid);
+
+private:
+    struct keyframe final
+    {
+        uint64_t generation;
+        uint64_t offset;
+    };
+
+private:
+    bool fail(const std::string& msg);
+
+    /// Applies the record at m_offset to m_words.
+    bool read_record();
+
+    bool read_index(const uint64_t data_offset);
+
+    void scan_records(const uint64_t data_offset);
+
+    void store(life::bit_grid& grid) const;
+
+private:
+    mapped_file m_file;
+    std::string m_error;
+
+    size_t m_row_count;
+    size_t m_col_count;
+    std::string m_rule;
+    compression_t m_compression;
+
+    uint64_t m_first_generation;
+    uint64_t m_last_generation;
+    uint64_t m_frame_count;
+    std::vector<keyframe> m_keyframes;
+
+    // Offset of the next record, generation and words of the last one.
+    uint64_t m_offset;
+    uint64_t m_generation;
+    bool m_has_frame;
+    std::vector<uint64_t> m_words;
+    std::string m_decoded;
+};
+
+} // namespace pio
+
+#endif // PATTERN_IO_GENERATION_LOG_H
@@ -0,0 +1,53 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pattern_io/grid_sink.h"
+
+namespace pio {
+
+grid_sink::grid_sink(life::bit_grid& grid, const int64_t top, const int64_t left)
+    : m_grid(grid)
+    , m_top(top)
+    , m_left(left)
+{}
+
+void grid_sink::on_cells(const int64_t row, const int64_t col, const uint64_t count)
+{
+    const int64_t r = row - m_top;
+    int64_t c = col - m_left;
+    uint64_t n = count;
+    if ((r < 0) || (r >= (int64_t)m_grid.row_count())) {
+        return;
+    }
+    if (c < 0) {
+        if (n <= (uint64_t)-c) {
+            return;
+        }
+        n -= (uint64_t)-c;
+        c = 0;
+    }
+    m_grid.set_run(r, c, n);
+}
+
+} // namespace pio
@@ -0,0 +1,61 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PATTERN_IO_GRID_SINK_H
+#define PATTERN_IO_GRID_SINK_H
+
+#include "engine/bit_grid.h"
+#include "pattern_io/parser.h"
+
+namespace pio {
+
+/**
+ * \brief   Sink that writes a pattern straight into a packed board.
+ *
+ * Cell (top, left) of the pattern goes to cell (0, 0) of the board, cells
+ * outside the board are dropped.
+ */
+class grid_sink final : public sink
+{
+public:
+    explicit grid_sink(life::bit_grid& grid, const int64_t top = 0, const int64_t left = 0);
+
+    void on_cells(const int64_t row, const int64_t col, const uint64_t count) override;
+
+    void on_header(const header& h) override { m_header = h; }
+
+    /// Header of the pattern, empty if it has none.
+    const header& pattern_header() const { return m_header; }
+
+private:
+    life::bit_grid& m_grid;
+    const int64_t m_top;
+    const int64_t m_left;
+
+    header m_header;
+};
+
+} // namespace pio
+
+#endif // PATTERN_IO_GRID_SINK_H
@@ -0,0 +1,114 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pattern_io/life106.h"
+
+namespace pio {
+namespace {
+
+constexpr int64_t max_coordinate = int64_t(1) << 40;
+
+} // <anonymous> namespace
+
+life106_parser::life106_parser(sink& out)
+    : parser(out)
+    , m_is_comment(false)
+    , m_is_line_start(true)
+    , m_in_number(false)
+    , m_is_negative(false)
+    , m_number_count(0)
+    , m_numbers{0, 0}
+{}
+
+bool life106_parser::end_line()
+{
+    if (m_number_count == 2) {
+        m_sink.on_cells(m_numbers[1], m_numbers[0], 1);
+    } else if (m_number_count != 0) {
+        return fail("expected 'x y' position");
+    }
+
+    m_is_comment = false;
+    m_is_line_start = true;
+    m_in_number = false;
+    m_is_negative = false;
+    m_number_count = 0;
+    return true;
+}
+
+bool life106_parser::feed(const char* p_data, const size_t size)
+{
+    if (has_error()) {
+        return false;
+    }
+
+    for (const char* p = p_data; p != (p_data + size); ++p) {
+        const char c = *p;
+        if (c == '\n') {
+            if (! end_line()) {
+                return false;
+            }
+            ++m_line;
+            continue;
+        }
+        if (m_is_comment) {
+            continue;
+        }
+        if (m_is_line_start && (c == '#')) {
+            m_is_comment = true;
+            continue;
+        }
+        m_is_line_start = false;
+
+        if ((c >= '0') && (c <= '9')) {
+            if (! m_in_number) {
+                if (m_number_count == 2) {
+                    return fail("expected 'x y' position");
+                }
+                m_in_number = true;
+                m_numbers[m_number_count++] = 0;
+            }
+            int64_t& n = m_numbers[m_number_count - 1];
+            n = n * 10 + (m_is_negative ? -(c - '0') : (c - '0'));
+            if ((n > max_coordinate) || (n < -max_coordinate)) {
+                return fail("coordinate is too large");
+            }
+        } else if (((c == '-') || (c == '+')) && ! m_in_number) {
+            m_is_negative = (c == '-');
+        } else if ((c == ' ') || (c == '\t') || (c == '\r')) {
+            m_in_number = false;
+            m_is_negative = false;
+        } else {
+            return fail(std::string("unexpected character '") + c + "'");
+        }
+    }
+    return true;
+}
+
+bool life106_parser::finish()
+{
+    return ! has_error() && end_line();
+}
+
+} // namespace pio
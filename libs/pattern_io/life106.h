@@ -0,0 +1,59 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PATTERN_IO_LIFE106_H
+#define PATTERN_IO_LIFE106_H
+
+#include "pattern_io/parser.h"
+
+namespace pio {
+
+/**
+ * \brief   Parser of Life 1.06 patterns: '#' lines are comments, every
+ *          other line is the "x y" position of a live cell.
+ */
+class life106_parser final : public parser
+{
+public:
+    explicit life106_parser(sink& out);
+
+    bool feed(const char* p_data, const size_t size) override;
+
+    bool finish() override;
+
+private:
+    bool end_line();
+
+private:
+    bool m_is_comment;
+    bool m_is_line_start;
+    bool m_in_number;
+    bool m_is_negative;
+    size_t m_number_count;
+    int64_t m_numbers[2];
+};
+
+} // namespace pio
+
+#endif // PATTERN_IO_LIFE106_H
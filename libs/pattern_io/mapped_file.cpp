@@ -0,0 +1,167 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pattern_io/mapped_file.h"
+
+namespace pio {
+
+mapped_file::mapped_file()
+    : m_p_data(nullptr)
+    , m_size(0)
+    , m_is_open(false)
+{}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+void mapped_file::close()
+{
+    if (m_p_data != nullptr) {
+        munmap(const_cast<char*>(m_p_data), m_size);
+    }
+    m_p_data = nullptr;
+    m_size = 0;
+    m_is_open = false;
+}
+
+bool mapped_file::open(const std::string& path, const unsigned hints)
+{
+    close();
+    m_error.clear();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        m_error = "could not open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        m_error = "could not stat '" + path + "': " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if (! S_ISREG(st.st_mode)) {
+        m_error = "'" + path + "' is not a regular file";
+        ::close(fd);
+        return false;
+    }
+
+    m_size = (size_t)st.st_size;
+    if (m_size == 0) {
+        ::close(fd);
+        m_is_open = true;
+        return true;
+    }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if ((hints & sequential) != 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
+    int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    if ((hints & populate) != 0) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void* p = mmap(nullptr, m_size, PROT_READ, flags, fd, 0);
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        m_error = "could not map '" + path + "': " + std::strerror(errno);
+        m_size = 0;
+        return false;
+    }
+    m_p_data = static_cast<const char*>(p);
+    m_is_open = true;
+
+    // Advice is only a hint, an unsupported one is not an error.
+#if defined(MADV_SEQUENTIAL)
+    if ((hints & sequential) != 0) {
+        madvise(p, m_size, MADV_SEQUENTIAL);
+    }
+#endif
+#if defined(MADV_HUGEPAGE)
+    if ((hints & huge_pages) != 0) {
+        madvise(p, m_size, MADV_HUGEPAGE);
+    }
+#endif
+    return true;
+}
+
+void mapped_file::release(const size_t offset, const size_t size)
+{
+    if ((m_p_data == nullptr) || (offset >= m_size)) {
+        return;
+    }
+
+    // Only whole pages inside the range can go.
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t begin = ((offset + page - 1) / page) * page;
+    const size_t end = (std::min(offset + size, m_size) / page) * page;
+    if (begin < end) {
+        madvise(const_cast<char*>(m_p_data) + begin, end - begin, MADV_DONTNEED);
+    }
+}
+
+bool load_hints_from_string(const std::string& list, unsigned& hints)
+{
+    unsigned result = mapped_file::none;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        const std::string name = list.substr(begin, end - begin);
+        if (name == "populate") {
+            result |= mapped_file::populate;
+        } else if (name == "sequential") {
+            result |= mapped_file::sequential;
+        } else if (name == "hugepages") {
+            result |= mapped_file::huge_pages;
+        } else if (name != "none") {
+            return false;
+        }
+        begin = end + 1;
+    }
+    hints = result;
+    return true;
+}
+
+} // namespace pio
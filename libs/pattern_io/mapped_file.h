@@ -0,0 +1,90 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef PATTERN_IO_MAPPED_FILE_H
+#define PATTERN_IO_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace pio {
+
+/**
+ * \brief   Read-only memory mapping of a whole file.
+ *
+ * The parsers read the mapping in place, so a file is read once by the
+ * kernel with no copies through stream buffers.
+ */
+class mapped_file final
+{
+public:
+    /// Hints to the kernel on how the mapping is read, may be combined.
+    enum hint_t : unsigned
+    {
+        none = 0,
+        populate = 1,       ///< Read the whole file in at open (MAP_POPULATE).
+        sequential = 2,     ///< Aggressive read ahead (MADV_SEQUENTIAL).
+        huge_pages = 4      ///< Back the mapping with huge pages where the file system can.
+    };
+
+    mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file();
+
+    void close();
+
+    const char* data() const { return m_p_data; }
+
+    const std::string& error_msg() const { return m_error; }
+
+    bool is_open() const { return m_is_open; }
+
+    /// Maps the file at 'path'. An empty file maps to no data.
+    bool open(const std::string& path, const unsigned hints = sequential);
+
+    /// Drops the pages of [offset, offset + size) that were already read,
+    /// they are read again from the file if accessed.
+    void release(const size_t offset, const size_t size);
+
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_p_data;
+    size_t m_size;
+    bool m_is_open;
+    std::string m_error;
+};
+
+/// Parses a comma separated list of "populate", "sequential", "hugepages"
+/// or "none".
+bool load_hints_from_string(const std::string& list, unsigned& hints);
+
+} // namespace pio
+
+#endif // PATTERN_IO_MAPPED_FILE_H
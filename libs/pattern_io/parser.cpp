@@ -0,0 +1,121 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "pattern_io/parser.h"
+
+namespace pio {
+namespace {
+
+constexpr size_t chunk_size = size_t(1) << 20;
+
+// Pages of a mapping are dropped once a window is parsed, which keeps the
+// memory use of huge files flat.
+constexpr size_t window_size = size_t(64) << 20;
+
+bool ends_with(const std::string& s, const std::string& suffix)
+{
+    return (s.size() >= suffix.size()) && (s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+} // <anonymous> namespace
+
+bool parser::fail(const std::string& msg)
+{
+    if (m_error.empty()) {
+        m_error = "line " + std::to_string(m_line) + ": " + msg;
+    }
+    return false;
+}
+
+bool parser::parse(std::istream& in)
+{
+    std::vector<char> chunk(chunk_size);
+    while (in) {
+        in.read(chunk.data(), chunk.size());
+        if ((in.gcount() > 0) && ! feed(chunk.data(), (size_t)in.gcount())) {
+            return false;
+        }
+    }
+    if (in.bad()) {
+        return fail("read error");
+    }
+    return finish();
+}
+
+bool parser::parse_file(const std::string& path, const unsigned hints)
+{
+    mapped_file file;
+    if (file.open(path, hints)) {
+        for (size_t offset = 0; offset < file.size(); offset += window_size) {
+            const size_t size = std::min(window_size, file.size() - offset);
+            if (! feed(file.data() + offset, size)) {
+                return false;
+            }
+            file.release(offset, size);
+        }
+        return finish();
+    }
+
+    // Pipes and special files can not be mapped.
+    std::ifstream in(path, std::ios::binary);
+    if (! in.is_open()) {
+        m_error = "could not open '" + path + "'";
+        return false;
+    }
+    return parse(in);
+}
+
+format_t format_by_name(const std::string& path)
+{
+    if (ends_with(path, ".rle")) {
+        return format_t::rle;
+    } else if (ends_with(path, ".cells")) {
+        return format_t::cells;
+    } else if (ends_with(path, ".lif") || ends_with(path, ".life")) {
+        return format_t::life106;
+    }
+    return format_t::table;
+}
+
+bool format_from_string(const std::string& name, format_t& format)
+{
+    if (name == "cells") {
+        format = format_t::cells;
+    } else if (name == "life106") {
+        format = format_t::life106;
+    } else if (name == "rle") {
+        format = format_t::rle;
+    } else if (name == "table") {
+        format = format_t::table;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace pio
@@ -0,0 +1,127 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PATTERN_IO_PARSER_H
+#define PATTERN_IO_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+
+#include "pattern_io/mapped_file.h"
+
+namespace pio {
+
+/**
+ * \brief   Size and rule declared in the header of a pattern file.
+ */
+struct header final
+{
+    uint64_t width = 0;
+    uint64_t height = 0;
+    std::string rule;
+};
+
+/**
+ * \brief   Receives the live cells of a pattern as it is parsed.
+ */
+class sink
+{
+public:
+    virtual ~sink() = default;
+
+    /// Called before any cell if the pattern has a header.
+    virtual void on_header(const header& /*h*/) {}
+
+    /// 'count' live cells of the row from 'col' on.
+    virtual void on_cells(const int64_t row, const int64_t col, const uint64_t count) = 0;
+};
+
+/**
+ * \brief   Base of the streaming pattern parsers.
+ *
+ * A parser is a state machine fed with chunks of any size, so an input is
+ * never held in memory as a whole. Cells go to the sink as soon as they are
+ * parsed.
+ */
+class parser
+{
+public:
+    explicit parser(sink& out)
+        : m_sink(out)
+        , m_line(1)
+    {}
+
+    virtual ~parser() = default;
+
+    /// Parses the next chunk of the input.
+    /// \return False on a syntax error, see error_msg().
+    virtual bool feed(const char* p_data, const size_t size) = 0;
+
+    /// Completes the input.
+    virtual bool finish() = 0;
+
+    const std::string& error_msg() const { return m_error; }
+
+    bool has_error() const { return ! m_error.empty(); }
+
+    /// Feeds the whole stream and finishes the input.
+    bool parse(std::istream& in);
+
+    /// Parses a file in place from a memory mapping, read through a stream
+    /// if the file can not be mapped. 'hints' are mapped_file::hint_t flags.
+    bool parse_file(const std::string& path, const unsigned hints = mapped_file::sequential);
+
+protected:
+    bool fail(const std::string& msg);
+
+protected:
+    sink& m_sink;
+    size_t m_line;
+
+private:
+    std::string m_error;
+};
+
+/**
+ * \brief   Supported pattern formats.
+ */
+enum class format_t
+{
+    cells,      ///< Plaintext, '.' is dead and 'O' is alive.
+    life106,    ///< Life 1.06, a "x y" pair per live cell.
+    rle,        ///< Run length encoded.
+    table       ///< Delimiter separated tokens.
+};
+
+/// Format by the file extension, the table format if it is unknown.
+format_t format_by_name(const std::string& path);
+
+/// Parses a format name: "cells", "life106", "rle" or "table".
+bool format_from_string(const std::string& name, format_t& format);
+
+} // namespace pio
+
+#endif // PATTERN_IO_PARSER_H
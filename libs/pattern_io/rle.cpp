@@ -0,0 +1,328 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "pattern_io/rle.h"
+
+namespace pio {
+namespace {
+
+// Header lines are short, a longer one is a broken file.
+constexpr size_t max_header_size = 4096;
+// Keeps the run counts and coordinates far from overflows.
+constexpr uint64_t max_count = uint64_t(1) << 40;
+constexpr size_t max_line_size = 70;
+constexpr size_t write_chunk_size = size_t(1) << 20;
+
+std::string trim(const std::string& s)
+{
+    const size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+}
+
+bool to_size(const std::string& s, uint64_t& value)
+{
+    if (s.empty() || (s.find_first_not_of("0123456789") != std::string::npos) || (s.size() > 12)) {
+        return false;
+    }
+    value = std::strtoull(s.c_str(), nullptr, 10);
+    return true;
+}
+
+// First column from 'col' on whose cell is 'alive', 'col_count' if none.
+size_t find_cell(const life::bit_grid::word_t* p_row, const size_t col_count, size_t col, const bool alive)
+{
+    while (col < col_count) {
+        const size_t w = col / life::bit_grid::word_bits;
+        const life::bit_grid::word_t word = (alive ? p_row[w] : ~p_row[w]) >> (col % life::bit_grid::word_bits);
+        if (word != 0) {
+            return std::min(col + __builtin_ctzll(word), col_count);
+        }
+        col = (w + 1) * life::bit_grid::word_bits;
+    }
+    return col_count;
+}
+
+} // <anonymous> namespace
+
+rle_parser::rle_parser(sink& out)
+    : parser(out)
+    , m_state(state_t::preamble)
+    , m_row(0)
+    , m_col(0)
+    , m_count(0)
+{}
+
+const char* rle_parser::body(const char* p, const char* p_end)
+{
+    // The hot loop works on locals, members would be reloaded after every
+    // call of the sink.
+    int64_t row = m_row;
+    int64_t col = m_col;
+    uint64_t count = m_count;
+    for (; p != p_end; ++p) {
+        const char c = *p;
+        const unsigned digit = (unsigned char)c - '0';
+        if (digit < 10) {
+            count = count * 10 + digit;
+            if (count > max_count) {
+                fail("run count is too large");
+                return nullptr;
+            }
+            continue;
+        }
+
+        const uint64_t n = (count == 0) ? 1 : count;
+        switch (c) {
+        case 'b':
+        case '.':
+            col += n;
+            break;
+        case 'o':
+            m_sink.on_cells(row, col, n);
+            col += n;
+            break;
+        case '$':
+            row += n;
+            col = 0;
+            break;
+        case '!':
+            m_state = state_t::done;
+            p = p_end - 1;
+            break;
+        case '\n':
+            ++m_line;
+            continue;
+        case ' ':
+        case '\t':
+        case '\r':
+            continue;
+        default:
+            if ((c < 'A') || (c > 'Z')) {
+                fail(std::string("unexpected character '") + c + "'");
+                return nullptr;
+            }
+            m_sink.on_cells(row, col, n);
+            col += n;
+            break;
+        }
+        count = 0;
+        if ((row > (int64_t)max_count) || (col > (int64_t)max_count)) {
+            fail("pattern is too large");
+            return nullptr;
+        }
+    }
+
+    m_row = row;
+    m_col = col;
+    m_count = count;
+    return p_end;
+}
+
+bool rle_parser::feed(const char* p_data, const size_t size)
+{
+    if (has_error()) {
+        return false;
+    }
+
+    const char* p = p_data;
+    const char* const p_end = p_data + size;
+    while (p != p_end) {
+        switch (m_state) {
+        case state_t::preamble: {
+            const char c = *p;
+            if (c == '#') {
+                m_state = state_t::comment;
+                ++p;
+            } else if (c == 'x') {
+                m_state = state_t::header;
+                m_header_line.assign(1, c);
+                ++p;
+            } else if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) {
+                m_line += (c == '\n') ? 1 : 0;
+                ++p;
+            } else {
+                m_state = state_t::body;
+            }
+            break;
+        }
+        case state_t::comment: {
+            const char* p_eol = (const char*)std::memchr(p, '\n', p_end - p);
+            if (p_eol == nullptr) {
+                return true;
+            }
+            ++m_line;
+            m_state = state_t::preamble;
+            p = p_eol + 1;
+            break;
+        }
+        case state_t::header: {
+            const char c = *p++;
+            if (c == '\n') {
+                ++m_line;
+                if (! parse_header()) {
+                    return false;
+                }
+                m_state = state_t::body;
+            } else if (m_header_line.size() < max_header_size) {
+                m_header_line.push_back(c);
+            } else {
+                return fail("header line is too long");
+            }
+            break;
+        }
+        case state_t::body:
+            p = body(p, p_end);
+            if (p == nullptr) {
+                return false;
+            }
+            break;
+        case state_t::done:
+            return true;
+        }
+    }
+    return true;
+}
+
+bool rle_parser::finish()
+{
+    if (has_error()) {
+        return false;
+    }
+    if (m_state == state_t::header) {
+        return parse_header();
+    }
+    return true;
+}
+
+bool rle_parser::parse_header()
+{
+    header h;
+    size_t begin = 0;
+    while (begin <= m_header_line.size()) {
+        size_t end = m_header_line.find(',', begin);
+        if (end == std::string::npos) {
+            end = m_header_line.size();
+        }
+        const std::string item = m_header_line.substr(begin, end - begin);
+        begin = end + 1;
+
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            return fail("invalid header item '" + trim(item) + "'");
+        }
+        const std::string key = trim(item.substr(0, eq));
+        const std::string value = trim(item.substr(eq + 1));
+        if (key == "x") {
+            if (! to_size(value, h.width)) {
+                return fail("invalid width '" + value + "'");
+            }
+        } else if (key == "y") {
+            if (! to_size(value, h.height)) {
+                return fail("invalid height '" + value + "'");
+            }
+        } else if (key == "rule") {
+            h.rule = value;
+        }
+    }
+
+    m_sink.on_header(h);
+    return true;
+}
+
+rle_writer::rle_writer(std::ostream& out)
+    : m_out(out)
+    , m_line_size(0)
+{}
+
+void rle_writer::append(const uint64_t count, const char tag)
+{
+    char token[24];
+    size_t size = 0;
+    if (count > 1) {
+        size = (size_t)std::snprintf(token, sizeof(token), "%llu", (unsigned long long)count);
+    }
+    token[size++] = tag;
+
+    if (m_line_size + size > max_line_size) {
+        m_buffer += '\n';
+        m_line_size = 0;
+    }
+    m_buffer.append(token, size);
+    m_line_size += size;
+
+    if (m_buffer.size() >= write_chunk_size) {
+        m_out.write(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+    }
+}
+
+bool rle_writer::write(const life::bit_grid& grid, const std::string& rule)
+{
+    m_buffer = "x = " + std::to_string(grid.col_count()) + ", y = " + std::to_string(grid.row_count());
+    if (! rule.empty()) {
+        m_buffer += ", rule = " + rule;
+    }
+    m_buffer += '\n';
+    m_line_size = 0;
+
+    // Row ends are held back until the next live cell, so empty rows
+    // collapse into one counted '$' and the bottom ones are dropped.
+    uint64_t row_ends = 0;
+    for (size_t r = 0; r < grid.row_count(); ++r) {
+        const life::bit_grid::word_t* p_row = grid.row_ptr(r);
+        size_t col = find_cell(p_row, grid.col_count(), 0, true);
+        if ((col < grid.col_count()) && (row_ends != 0)) {
+            append(row_ends, '$');
+            row_ends = 0;
+        }
+        if ((col != 0) && (col < grid.col_count())) {
+            append(col, 'b');
+        }
+        while (col < grid.col_count()) {
+            const size_t dead = find_cell(p_row, grid.col_count(), col, false);
+            append(dead - col, 'o');
+            col = find_cell(p_row, grid.col_count(), dead, true);
+            if (col < grid.col_count()) {
+                append(col - dead, 'b');
+            }
+        }
+        ++row_ends;
+    }
+    append(1, '!');
+    m_buffer += '\n';
+
+    m_out.write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+    return m_out.good();
+}
+
+} // namespace pio
@@ -0,0 +1,104 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PATTERN_IO_RLE_H
+#define PATTERN_IO_RLE_H
+
+#include <ostream>
+#include <string>
+
+#include "engine/bit_grid.h"
+#include "pattern_io/parser.h"
+
+namespace pio {
+
+/**
+ * \brief   Parser of run length encoded patterns.
+ *
+ * '#' lines before the pattern are comments, an optional header line
+ * "x = <width>, y = <height>, rule = <rule>" goes to sink::on_header().
+ * In the pattern 'b' and '.' are dead cells, 'o' and 'A'-'Z' are alive,
+ * '$' ends a row and '!' ends the pattern; every tag may be preceded by a
+ * repeat count.
+ */
+class rle_parser final : public parser
+{
+public:
+    explicit rle_parser(sink& out);
+
+    bool feed(const char* p_data, const size_t size) override;
+
+    bool finish() override;
+
+private:
+    enum class state_t
+    {
+        preamble,
+        comment,
+        header,
+        body,
+        done
+    };
+
+private:
+    /// Parses the pattern body, nullptr on an error.
+    const char* body(const char* p, const char* p_end);
+
+    bool parse_header();
+
+private:
+    state_t m_state;
+    std::string m_header_line;
+
+    int64_t m_row;
+    int64_t m_col;
+    uint64_t m_count;
+};
+
+/**
+ * \brief   Writer of run length encoded patterns.
+ *
+ * Runs are found a word at a time, trailing dead cells of a row and empty
+ * rows at the bottom are left out, lines are at most 70 characters.
+ */
+class rle_writer final
+{
+public:
+    explicit rle_writer(std::ostream& out);
+
+    /// \return False on a stream error.
+    bool write(const life::bit_grid& grid, const std::string& rule);
+
+private:
+    void append(const uint64_t count, const char tag);
+
+private:
+    std::ostream& m_out;
+    std::string m_buffer;
+    size_t m_line_size;
+};
+
+} // namespace pio
+
+#endif // PATTERN_IO_RLE_H
@@ -0,0 +1,270 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "pattern_io/snapshot.h"
+
+namespace pio {
+namespace {
+
+constexpr char magic[8] = {'L', 'I', 'F', 'E', 'S', 'N', 'A', 'P'};
+constexpr uint32_t version = 1;
+constexpr uint32_t byte_order = 0x01020304;
+constexpr size_t align = 64;
+constexpr size_t max_rule_size = 4096;
+// Longer sides are beyond any board that fits in memory, so they can only
+// come from a corrupted header.
+constexpr uint64_t max_side = uint64_t(1) << 24;
+
+// Rows are written through a buffer of this size and the pages of a mapping
+// are dropped in windows of this size while restoring.
+constexpr size_t window_size = size_t(64) << 20;
+
+struct file_header final
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t row_count;
+    uint64_t col_count;
+    uint64_t generation;
+    uint64_t checksum;
+    uint32_t rule_size;
+    uint32_t reserved[3];
+};
+
+static_assert(sizeof(file_header) == align, "snapshot header must fill a cache line");
+
+size_t align_up(const size_t size)
+{
+    return ((size + align - 1) / align) * align;
+}
+
+/**
+ * \brief   Checksum of the data words, four independent lanes so it keeps
+ *          up with memory bandwidth.
+ */
+class checksum final
+{
+public:
+    void add(const uint64_t* p_words, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t& lane = m_lanes[m_next];
+            lane = (lane ^ p_words[i]) * 0x100000001b3ull;
+            m_next = (m_next + 1) & 3;
+        }
+    }
+
+    uint64_t value() const
+    {
+        return m_lanes[0] ^ (m_lanes[1] << 1) ^ (m_lanes[2] << 2) ^ (m_lanes[3] << 3);
+    }
+
+private:
+    uint64_t m_lanes[4] = {0xcbf29ce484222325ull, 0x84222325cbf29ce4ull, 0xcbf29ce4ull, 0x84222325ull};
+    size_t m_next = 0;
+};
+
+bool write_all(const int fd, const char* p_data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = write(fd, p_data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p_data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+std::string dir_name(const std::string& path)
+{
+    const size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return (slash == 0) ? "/" : path.substr(0, slash);
+}
+
+} // <anonymous> namespace
+
+snapshot::snapshot()
+    : m_generation(0)
+{}
+
+bool snapshot::fail(const std::string& msg)
+{
+    m_error = msg;
+    return false;
+}
+
+bool snapshot::load(const std::string& path, life::bit_grid& grid, const unsigned hints)
+{
+    m_error.clear();
+
+    mapped_file file;
+    if (! file.open(path, hints)) {
+        return fail(file.error_msg());
+    }
+
+    file_header h;
+    if (file.size() < sizeof(h)) {
+        return fail("'" + path + "' is not a snapshot");
+    }
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0) {
+        return fail("'" + path + "' is not a snapshot");
+    }
+    if (h.byte_order != byte_order) {
+        return fail("'" + path + "' was written on a machine of another byte order");
+    }
+    if (h.version != version) {
+        return fail("'" + path + "' has unsupported version " + std::to_string(h.version));
+    }
+    if ((h.rule_size > max_rule_size) || (h.row_count > max_side) || (h.col_count > max_side)) {
+        return fail("'" + path + "' has a corrupted header");
+    }
+
+    const size_t words = (h.col_count + life::bit_grid::word_bits - 1) / life::bit_grid::word_bits;
+    if ((words == 0) && (h.col_count != 0)) {
+        return fail("'" + path + "' has a corrupted header");
+    }
+    const size_t row_size = words * sizeof(uint64_t);
+    const size_t data_offset = align_up(sizeof(h) + h.rule_size);
+    if (file.size() < data_offset) {
+        return fail("'" + path + "' is truncated");
+    }
+    const size_t data_size = file.size() - data_offset;
+    if ((words == 0) ? ((h.row_count != 0) || (data_size != 0))
+                     : ((data_size % row_size != 0) || (data_size / row_size != h.row_count))) {
+        return fail("'" + path + "' has a size not matching its header");
+    }
+
+    grid.resize(h.row_count, h.col_count);
+    checksum sum;
+    size_t released = data_offset;
+    for (size_t r = 0; r < h.row_count; ++r) {
+        const size_t offset = data_offset + r * row_size;
+        uint64_t* p_row = grid.row_ptr(r);
+        std::memcpy(p_row, file.data() + offset, row_size);
+        sum.add(p_row, words);
+        p_row[words - 1] &= grid.last_word_mask();
+        if (offset - released >= window_size) {
+            file.release(released, offset - released);
+            released = offset;
+        }
+    }
+    if (sum.value() != h.checksum) {
+        grid.clear();
+        return fail("'" + path + "' is corrupted, checksum mismatch");
+    }
+
+    m_generation = h.generation;
+    m_rule.assign(file.data() + sizeof(h), h.rule_size);
+    return true;
+}
+
+bool snapshot::save(const std::string& path, const life::bit_grid& grid)
+{
+    m_error.clear();
+    if (m_rule.size() > max_rule_size) {
+        return fail("rule is too long");
+    }
+
+    const std::string temp_path = path + ".tmp";
+    const int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return fail("could not create '" + temp_path + "': " + std::strerror(errno));
+    }
+
+    file_header h = {};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.byte_order = byte_order;
+    h.row_count = grid.row_count();
+    h.col_count = grid.col_count();
+    h.generation = m_generation;
+    h.rule_size = (uint32_t)m_rule.size();
+
+    // The header goes first with the checksum known only at the end, it is
+    // rewritten once the rows are out.
+    std::vector<char> buffer(align_up(sizeof(h) + m_rule.size()), 0);
+    std::memcpy(buffer.data(), &h, sizeof(h));
+    std::memcpy(buffer.data() + sizeof(h), m_rule.data(), m_rule.size());
+    buffer.reserve(window_size);
+
+    checksum sum;
+    bool is_ok = true;
+    const size_t row_size = grid.words() * sizeof(uint64_t);
+    for (size_t r = 0; is_ok && (r < grid.row_count()); ++r) {
+        const uint64_t* p_row = grid.row_ptr(r);
+        sum.add(p_row, grid.words());
+        const char* p_bytes = reinterpret_cast<const char*>(p_row);
+        buffer.insert(buffer.end(), p_bytes, p_bytes + row_size);
+        if (buffer.size() + row_size > window_size) {
+            is_ok = write_all(fd, buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    is_ok = is_ok && write_all(fd, buffer.data(), buffer.size());
+
+    h.checksum = sum.value();
+    is_ok = is_ok && (pwrite(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h));
+    is_ok = is_ok && (fsync(fd) == 0);
+    const int error = errno;
+    is_ok = (close(fd) == 0) && is_ok;
+    if (! is_ok) {
+        unlink(temp_path.c_str());
+        return fail("could not write '" + temp_path + "': " + std::strerror(error));
+    }
+
+    if (rename(temp_path.c_str(), path.c_str()) != 0) {
+        const int rename_error = errno;
+        unlink(temp_path.c_str());
+        return fail("could not rename '" + temp_path + "': " + std::strerror(rename_error));
+    }
+
+    // The rename itself is durable only once the directory is synced.
+    const int dir_fd = open(dir_name(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return true;
+}
+
+} // namespace pio
@@ -0,0 +1,78 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef PATTERN_IO_SNAPSHOT_H
+#define PATTERN_IO_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+
+#include "engine/bit_grid.h"
+#include "pattern_io/mapped_file.h"
+
+namespace pio {
+
+/**
+ * \brief   Binary checkpoint of a packed board.
+ *
+ * A snapshot file is a 64 byte header with the board size, the generation
+ * and a checksum, the rule string padded to 64 bytes, and the data words of
+ * every row one after another in native byte order. Restoring one is a copy
+ * of rows out of a memory mapping, nothing is parsed.
+ */
+class snapshot final
+{
+public:
+    snapshot();
+
+    const std::string& error_msg() const { return m_error; }
+
+    uint64_t generation() const { return m_generation; }
+
+    /// Restores the board from 'path', 'grid' is resized to the stored size.
+    bool load(const std::string& path, life::bit_grid& grid, const unsigned hints = mapped_file::sequential);
+
+    const std::string& rule() const { return m_rule; }
+
+    /// Writes the board to a temporary file next to 'path', syncs it and
+    /// renames it over 'path', so 'path' always holds a whole snapshot.
+    bool save(const std::string& path, const life::bit_grid& grid);
+
+    void set_generation(const uint64_t generation) { m_generation = generation; }
+
+    void set_rule(const std::string& rule) { m_rule = rule; }
+
+private:
+    bool fail(const std::string& msg);
+
+private:
+    uint64_t m_generation;
+    std::string m_rule;
+    std::string m_error;
+};
+
+} // namespace pio
+
+#endif // PATTERN_IO_SNAPSHOT_H
@@ -0,0 +1,176 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pattern_io/table.h"
+
+namespace pio {
+namespace {
+
+constexpr size_t max_token_size = 4096;
+
+} // <anonymous> namespace
+
+table_parser::table_parser(sink& out, const std::string& alive_token, const std::string& delimiter)
+    : parser(out)
+    , m_alive(alive_token)
+    , m_delimiter(delimiter)
+    , m_token_size(0)
+    , m_is_prefix(true)
+    , m_has_line(false)
+    , m_row(0)
+    , m_col(0)
+    , m_col_count(-1)
+    , m_run_begin(-1)
+{
+    m_token.reserve(m_alive.size() + m_delimiter.size() + 1);
+}
+
+void table_parser::end_run()
+{
+    if (m_run_begin >= 0) {
+        m_sink.on_cells(m_row, m_run_begin, m_col - m_run_begin);
+        m_run_begin = -1;
+    }
+}
+
+bool table_parser::end_line(const bool is_alive)
+{
+    end_token(is_alive);
+    end_run();
+    if (m_col_count < 0) {
+        m_col_count = m_col;
+    } else if (m_col != m_col_count) {
+        return fail("expected " + std::to_string(m_col_count) + " cells, got " + std::to_string(m_col));
+    }
+
+    ++m_row;
+    m_col = 0;
+    m_has_line = false;
+    return true;
+}
+
+void table_parser::end_token(const bool is_alive)
+{
+    if (is_alive) {
+        if (m_run_begin < 0) {
+            m_run_begin = m_col;
+        }
+    } else {
+        end_run();
+    }
+    ++m_col;
+    m_token.clear();
+    m_token_size = 0;
+    m_is_prefix = true;
+}
+
+bool table_parser::feed(const char* p_data, const size_t size)
+{
+    if (has_error()) {
+        return false;
+    }
+    if (m_delimiter.empty()) {
+        return fail("empty delimiter");
+    }
+    if (m_delimiter.size() == 1) {
+        return feed_char_delimited(p_data, size);
+    }
+
+    for (const char* p = p_data; p != (p_data + size); ++p) {
+        const char c = *p;
+        if (c == '\n') {
+            if (! end_line(is_token_alive())) {
+                return false;
+            }
+            ++m_line;
+            continue;
+        }
+        if (c == '\r') {
+            continue;
+        }
+
+        m_has_line = true;
+        m_token.push_back(c);
+        // The earliest match of the delimiter ends the token.
+        if ((m_token.size() >= m_delimiter.size())
+            && (m_token.compare(m_token.size() - m_delimiter.size(), m_delimiter.size(), m_delimiter) == 0)) {
+            m_token.resize(m_token.size() - m_delimiter.size());
+            end_token(is_token_alive());
+        } else if (m_token.size() > max_token_size) {
+            return fail("token is too long");
+        }
+    }
+    return true;
+}
+
+bool table_parser::feed_char_delimited(const char* p_data, const size_t size)
+{
+    // Tokens are compared with the alive token char by char as they come,
+    // nothing is collected.
+    const char delimiter = m_delimiter[0];
+    const size_t alive_size = m_alive.size();
+    size_t token_size = m_token_size;
+    bool is_prefix = m_is_prefix;
+    for (const char* p = p_data; p != (p_data + size); ++p) {
+        const char c = *p;
+        if (c == delimiter) {
+            end_token(is_prefix && (token_size == alive_size));
+            token_size = 0;
+            is_prefix = true;
+        } else if (c == '\n') {
+            if (! end_line(is_prefix && (token_size == alive_size))) {
+                return false;
+            }
+            ++m_line;
+            token_size = 0;
+            is_prefix = true;
+        } else if (c != '\r') {
+            m_has_line = true;
+            is_prefix = is_prefix && (token_size < alive_size) && (m_alive[token_size] == c);
+            ++token_size;
+        }
+    }
+
+    m_token_size = token_size;
+    m_is_prefix = is_prefix;
+    return true;
+}
+
+bool table_parser::finish()
+{
+    if (has_error()) {
+        return false;
+    }
+    return ! m_has_line || end_line(is_token_alive());
+}
+
+bool table_parser::is_token_alive() const
+{
+    if (m_delimiter.size() == 1) {
+        return m_is_prefix && (m_token_size == m_alive.size());
+    }
+    return m_token == m_alive;
+}
+
+} // namespace pio
@@ -1,5 +1,9 @@
+add_subdirectory(libs/cluster)
+add_subdirectory(libs/display)
 add_subdirectory(libs/engine)
+add_subdirectory(libs/pattern_io)
 add_subdirectory(libs/prog_opts)
 add_subdirectory(src)
 add_subdirectory(tests)
+add_subdirectory(bench)
 
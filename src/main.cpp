@@ -22,82 +22,567 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <chrono>
+#include <csignal>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <thread>
+#include <type_traits>
 
+#include <unistd.h>
+
+#include "cluster/coordinator.h"
+#include "display/frame_ring.h"
+#include "display/renderer.h"
+#include "engine/census.h"
+#include "engine/hashlife.h"
 #include "engine/life_engine.h"
+#include "engine/sparse_engine.h"
+#include "pattern_io/cells.h"
+#include "pattern_io/generation_log.h"
+#include "pattern_io/grid_sink.h"
+#include "pattern_io/life106.h"
+#include "pattern_io/mapped_file.h"
+#include "pattern_io/rle.h"
+#include "pattern_io/snapshot.h"
+#include "pattern_io/table.h"
 #include "prog_opts/prog_opts.h"
 
 namespace {
 
-void split(const std::string& s, std::vector<std::string>& out_str, const std::string& delimiter)
+volatile std::sig_atomic_t g_is_stopping = 0;
+
+void on_stop_signal(int)
 {
-    size_t begin_pos = 0;
-    size_t pos = 0;
-    while ((pos = s.find(delimiter, begin_pos)) != std::string::npos) {
-        out_str.emplace_back(s.substr(begin_pos, pos - begin_pos));
-        begin_pos = pos + delimiter.length();
+    g_is_stopping = 1;
+}
+
+/// Parses "<rows>x<columns>" of positive numbers.
+bool parse_size(const std::string& text, size_t& row_count, size_t& col_count)
+{
+    const size_t x = text.find('x');
+    if ((x == 0) || (x == std::string::npos) || (x + 1 == text.size())
+        || (text.find_first_not_of("0123456789x") != std::string::npos)
+        || (text.find('x', x + 1) != std::string::npos)) {
+        return false;
     }
-    if (pos == std::string::npos) {
-        out_str.emplace_back(s.substr(begin_pos, s.size() - begin_pos));
+    // Nine digits at most, stoul can not overflow.
+    if ((x > 9) || (text.size() - x - 1 > 9)) {
+        return false;
     }
+    row_count = std::stoul(text.substr(0, x));
+    col_count = std::stoul(text.substr(x + 1));
+    return (row_count != 0) && (col_count != 0);
 }
 
-std::vector<std::string> split(const std::string& s, const std::string& delimiter)
+bool load_pattern(const std::string& path, const std::string& format_name, const std::string& alive_state,
+                  const std::string& delimiter, const unsigned load_hints, life::bit_grid& grid, std::string& rule)
 {
-    std::vector<std::string> out_str;
-    split(s, out_str, delimiter);
-    return out_str;
+    pio::format_t format = pio::format_by_name(path);
+    if ((format_name != "auto") && ! pio::format_from_string(format_name, format)) {
+        std::cerr << "Unsupported format '" << format_name << "'" << std::endl;
+        return false;
+    }
+
+    // Life 1.06 positions are relative to the pattern center, so the origin
+    // goes to the middle of the board.
+    const bool is_centered = (format == pio::format_t::life106);
+    pio::grid_sink sink(grid, is_centered ? -(int64_t)(grid.row_count() / 2) : 0,
+                        is_centered ? -(int64_t)(grid.col_count() / 2) : 0);
+
+    std::unique_ptr<pio::parser> p_parser;
+    switch (format) {
+    case pio::format_t::cells:
+        p_parser = std::make_unique<pio::cells_parser>(sink);
+        break;
+    case pio::format_t::life106:
+        p_parser = std::make_unique<pio::life106_parser>(sink);
+        break;
+    case pio::format_t::rle:
+        p_parser = std::make_unique<pio::rle_parser>(sink);
+        break;
+    case pio::format_t::table:
+        p_parser = std::make_unique<pio::table_parser>(sink, alive_state, delimiter);
+        break;
+    }
+
+    if (! p_parser->parse_file(path, load_hints)) {
+        std::cerr << "Could not load '" << path << "': " << p_parser->error_msg() << std::endl;
+        return false;
+    }
+
+    rule = sink.pattern_header().rule;
+    return true;
 }
 
-life::engine::grid_t grid_form_stream(std::istream& in, const std::string& alive_state, const std::string& delimiter)
+/// The board of an engine as a packed frame, 'buffer' holds it for the
+/// engines without packed storage. Distributed boards are gathered from
+/// the workers.
+template<typename TEngine>
+const life::bit_grid& frame(TEngine& gl, life::bit_grid& buffer)
 {
-    life::engine::grid_t grid;
+    if constexpr (std::is_same<TEngine, life::engine>::value) {
+        return gl.storage();
+    } else if constexpr (std::is_same<TEngine, cluster::coordinator>::value) {
+        gl.snapshot(buffer);
+        return buffer;
+    } else {
+        buffer.resize(gl.row_count(), gl.col_count());
+        for (size_t r = 0; r < gl.row_count(); ++r) {
+            for (size_t c = 0; c < gl.col_count(); ++c) {
+                if (gl.alive(r, c)) {
+                    buffer.set(r, c, true);
+                }
+            }
+        }
+        return buffer;
+    }
+}
+
+/**
+ * \brief   Streams per-generation metrics as CSV or JSON lines.
+ */
+class metrics_stream final
+{
+public:
+    enum class format_t
+    {
+        csv,
+        json
+    };
 
-    size_t col_size = 0;
-    std::string in_str;
-    while(std::getline(in, in_str)) {
-        const std::vector<std::string> r = split(in_str, delimiter);
-        if (r.size() == 0) {
-            return life::engine::grid_t();
+    metrics_stream(std::ostream& out, const format_t format)
+        : m_out(out)
+        , m_format(format)
+    {
+        if (m_format == format_t::csv) {
+            m_out << "generation,wall_ns,population,births,deaths,changed" << std::endl;
         }
-        if (col_size == 0) {
-            col_size = r.size();
+    }
+
+    void summary(const life::latency_histogram& latency)
+    {
+        if (m_format == format_t::csv) {
+            m_out << "# generations=" << latency.count() << " p50_ns=" << latency.percentile(50)
+                  << " p99_ns=" << latency.percentile(99) << " max_ns=" << latency.max() << std::endl;
+        } else {
+            m_out << "{\"summary\": {\"generations\": " << latency.count()
+                  << ", \"p50_ns\": " << latency.percentile(50) << ", \"p99_ns\": " << latency.percentile(99)
+                  << ", \"max_ns\": " << latency.max() << "}}" << std::endl;
         }
-        if (col_size != r.size()) {
-            return life::engine::grid_t();
+    }
+
+    void write(const life::step_metrics& m)
+    {
+        if (m_format == format_t::csv) {
+            m_out << m.generation << ',' << m.wall_ns << ',' << m.population << ','
+                  << m.births << ',' << m.deaths << ',' << m.changed() << '\n';
+        } else {
+            m_out << "{\"generation\": " << m.generation << ", \"wall_ns\": " << m.wall_ns
+                  << ", \"population\": " << m.population << ", \"births\": " << m.births
+                  << ", \"deaths\": " << m.deaths << ", \"changed\": " << m.changed() << "}\n";
         }
+    }
+
+private:
+    std::ostream& m_out;
+    const format_t m_format;
+};
+
+struct run_options final
+{
+    size_t step_count = 0;
+    size_t jump = 1;
+    display::renderer* p_renderer = nullptr;
+    metrics_stream* p_metrics = nullptr;
+    bool stop_on_cycle = false;
+    bool is_headless = false;
+    uint64_t begin_generation = 0;
+    std::string checkpoint_path;
+    uint64_t checkpoint_every = 0;
+    std::string output_path;
+    uint64_t output_every = 0;
+    std::string rule;
+    display::frame_ring* p_ring = nullptr;
+    pio::log_writer* p_log = nullptr;
+};
+
+/// Next multiple of 'every' after 'generation', never if 'every' is 0.
+uint64_t next_multiple(const uint64_t generation, const uint64_t every)
+{
+    return (every == 0) ? UINT64_MAX : (generation / every + 1) * every;
+}
+
+/// 'path' with the generation inserted before the extension.
+std::string numbered_path(const std::string& path, const uint64_t generation)
+{
+    const size_t slash = path.rfind('/');
+    const size_t dot = path.rfind('.');
+    if ((dot == std::string::npos) || ((slash != std::string::npos) && (dot < slash))) {
+        return path + "." + std::to_string(generation);
+    }
+    return path.substr(0, dot) + "." + std::to_string(generation) + path.substr(dot);
+}
+
+bool save_checkpoint(const life::engine& gl, const std::string& path)
+{
+    pio::snapshot snap;
+    snap.set_generation(gl.generation());
+    snap.set_rule(gl.rule().to_string());
+    if (! snap.save(path, gl.storage())) {
+        std::cerr << "Could not write checkpoint: " << snap.error_msg() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool save_state(const life::bit_grid& grid, const std::string& rule, const std::string& path)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (! out.is_open() || ! pio::rle_writer(out).write(grid, rule)) {
+        std::cerr << "Could not write '" << path << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
 
-        grid.emplace_back(life::engine::row_t(col_size));
-        life::engine::row_t& row = grid.back();
-        for (size_t i = 0; i < col_size; ++i) {
-            row[i] = (r[i] == alive_state);
+/// Draws a frame, or in the headless mode writes it to a numbered file or,
+/// the last one, to the output file. Runs on the writer thread when the
+/// output is pipelined.
+void write_frame(const life::bit_grid& grid, const uint64_t generation, const bool is_last, const run_options& opts)
+{
+    if (opts.is_headless) {
+        save_state(grid, opts.rule, is_last ? opts.output_path : numbered_path(opts.output_path, generation));
+        return;
+    }
+    opts.p_renderer->draw(grid);
+    if (! is_last && (g_is_stopping == 0)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+}
+
+/// Hands the board to the writer thread or writes it right away.
+template<typename TEngine>
+void output(TEngine& gl, const bool is_last, const run_options& opts, life::bit_grid& buffer)
+{
+    if (opts.p_ring != nullptr) {
+        opts.p_ring->push(frame(gl, buffer), gl.generation(), is_last);
+    } else {
+        write_frame(frame(gl, buffer), gl.generation(), is_last, opts);
+    }
+}
+
+/// Takes frames off the ring until it is closed and drained.
+void write_frames(const run_options& opts)
+{
+    for (const display::frame_ring::frame* p_frame = opts.p_ring->front(); p_frame != nullptr;
+         p_frame = opts.p_ring->front()) {
+        write_frame(p_frame->grid, p_frame->generation, p_frame->is_last, opts);
+        opts.p_ring->pop();
+    }
+}
+
+void print_cycle(const life::cycle_detector& cycles)
+{
+    switch (cycles.state()) {
+    case life::cycle_detector::state_t::running:
+        return;
+    case life::cycle_detector::state_t::extinct:
+        std::cerr << "Extinct since generation " << cycles.cycle_start() << std::endl;
+        return;
+    case life::cycle_detector::state_t::still_life:
+        std::cerr << "Still life since generation " << cycles.cycle_start() << std::endl;
+        return;
+    case life::cycle_detector::state_t::oscillator:
+        std::cerr << "Oscillator with period " << cycles.period() << " since generation "
+                  << cycles.cycle_start() << std::endl;
+        return;
+    }
+}
+
+/// Advances the board, streaming the metrics and logging the board of every
+/// generation if asked.
+template<typename TEngine>
+void advance(TEngine& gl, const uint64_t generations, const run_options& opts, life::bit_grid& buffer)
+{
+    bool is_metered = false;
+    if constexpr (std::is_same<TEngine, life::engine>::value) {
+        is_metered = (opts.p_metrics != nullptr);
+    }
+    if (! is_metered && (opts.p_log == nullptr)) {
+        gl.step_n(generations);
+        return;
+    }
+
+    for (uint64_t i = 0; i < generations; ++i) {
+        gl.next_step();
+        if constexpr (std::is_same<TEngine, life::engine>::value) {
+            if (is_metered) {
+                opts.p_metrics->write(gl.metrics());
+            }
+        }
+        if (opts.p_log != nullptr) {
+            // A failed write is reported when the log is closed.
+            opts.p_log->write(frame(gl, buffer), gl.generation());
         }
     }
-    return grid;
 }
 
-life::engine::grid_t grid_form_file(const std::string& file, const std::string& alive_state, const std::string& delimiter)
+template<typename TEngine>
+void begin_run(TEngine& gl, life::bit_grid&& begin_state, const run_options& opts, life::bit_grid& buffer)
 {
-    std::ifstream in(file);
-    if (! in.is_open()) {
-        return life::engine::grid_t();
+    gl.start(std::move(begin_state));
+    if constexpr (std::is_same<TEngine, life::engine>::value) {
+        gl.set_generation(opts.begin_generation);
+    }
+    if (opts.p_log != nullptr) {
+        opts.p_log->write(frame(gl, buffer), gl.generation());
     }
-    return grid_form_stream(in, alive_state, delimiter);
 }
 
-void print_grid(const life::engine::grid_t& grid)
+template<typename TEngine>
+void end_run(TEngine& gl, const run_options& opts)
 {
-    std::cout << std::endl;
-    for (const life::engine::row_t& row : grid) {
-        for (size_t c = 0; c < row.size(); ++c) {
-            std::cout << (row[c] ? '*' : '-');
+    if constexpr (std::is_same<TEngine, life::engine>::value) {
+        if (! opts.checkpoint_path.empty()) {
+            save_checkpoint(gl, opts.checkpoint_path);
+        }
+        if (opts.p_metrics != nullptr) {
+            opts.p_metrics->summary(gl.latency());
         }
-        std::cout << std::endl;
     }
-    std::cout << std::endl;
+}
+
+/// Checkpoints at 'next_checkpoint' and tells if the board is done.
+template<typename TEngine>
+bool check_run(TEngine& gl, const run_options& opts, uint64_t& next_checkpoint)
+{
+    if constexpr (std::is_same<TEngine, cluster::coordinator>::value) {
+        return ! gl.error_msg().empty();
+    }
+    if constexpr (std::is_same<TEngine, life::engine>::value) {
+        if (gl.generation() >= next_checkpoint) {
+            save_checkpoint(gl, opts.checkpoint_path);
+            next_checkpoint = next_multiple(gl.generation(), opts.checkpoint_every);
+        }
+        if (opts.stop_on_cycle && gl.cycles().detected()) {
+            print_cycle(gl.cycles());
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename TEngine>
+void run_interactive(TEngine& gl, life::bit_grid&& begin_state, const run_options& opts)
+{
+    life::bit_grid buffer;
+    begin_run(gl, std::move(begin_state), opts, buffer);
+    uint64_t next_checkpoint = next_multiple(gl.generation(), opts.checkpoint_every);
+
+    size_t step_count = opts.step_count;
+    do {
+        output(gl, false, opts, buffer);
+        advance(gl, opts.jump, opts, buffer);
+        if (check_run(gl, opts, next_checkpoint)) {
+            output(gl, true, opts, buffer);
+            break;
+        }
+    } while ((--step_count > 0) && (g_is_stopping == 0));
+
+    end_run(gl, opts);
+}
+
+/// Runs 'step_count' generations at full speed with no board output.
+template<typename TEngine>
+void run_headless(TEngine& gl, life::bit_grid&& begin_state, const run_options& opts)
+{
+    // Cycles and the signals that write a checkpoint are looked for every
+    // few generations of the packed engine. Other batches run up to the next
+    // output or checkpoint; HashLife takes them as power of two jumps and
+    // looks for signals in between.
+    uint64_t max_batch = UINT64_MAX;
+    if constexpr (std::is_same<TEngine, life::engine>::value) {
+        if (opts.stop_on_cycle || ! opts.checkpoint_path.empty()) {
+            max_batch = 64;
+        }
+    }
+
+    life::bit_grid buffer;
+    begin_run(gl, std::move(begin_state), opts, buffer);
+    const uint64_t begin_generation = gl.generation();
+    const uint64_t end_generation = begin_generation + opts.step_count;
+    uint64_t next_checkpoint = next_multiple(begin_generation, opts.checkpoint_every);
+    uint64_t next_output = next_multiple(begin_generation, opts.output_every);
+
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    while ((gl.generation() < end_generation) && (g_is_stopping == 0)) {
+        uint64_t batch = std::min({end_generation, next_checkpoint, next_output}) - gl.generation();
+        batch = std::min(batch, max_batch);
+        if constexpr (std::is_same<TEngine, life::hashlife>::value) {
+            batch = uint64_t(1) << (63 - __builtin_clzll(batch));
+        }
+        advance(gl, batch, opts, buffer);
+        if (gl.generation() >= next_output) {
+            output(gl, false, opts, buffer);
+            next_output = next_multiple(gl.generation(), opts.output_every);
+        }
+        if (check_run(gl, opts, next_checkpoint)) {
+            break;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    if (! opts.output_path.empty()) {
+        output(gl, true, opts, buffer);
+    }
+    end_run(gl, opts);
+
+    const uint64_t generations = gl.generation() - begin_generation;
+    std::cout << "Generations: " << generations << ", time: " << seconds << " s, "
+              << ((seconds > 0) ? generations / seconds : 0) << " generations/s" << std::endl;
+}
+
+/// With a frame ring the board is drawn or written on a writer thread
+/// while the engine goes on.
+template<typename TEngine>
+void run(TEngine& gl, life::bit_grid&& begin_state, const run_options& opts)
+{
+    std::thread writer;
+    if (opts.p_ring != nullptr) {
+        writer = std::thread(write_frames, std::cref(opts));
+    }
+
+    if (opts.is_headless) {
+        run_headless(gl, std::move(begin_state), opts);
+    } else {
+        run_interactive(gl, std::move(begin_state), opts);
+    }
+
+    if (writer.joinable()) {
+        opts.p_ring->close();
+        writer.join();
+        if (opts.p_ring->dropped() != 0) {
+            std::cerr << "Dropped frames: " << opts.p_ring->dropped() << std::endl;
+        }
+    }
+    if ((opts.p_log != nullptr) && ! opts.p_log->close()) {
+        std::cerr << "Could not write the log: " << opts.p_log->error_msg() << std::endl;
+    }
+}
+
+void print_histogram(const char* p_name, const life::census_report::histogram_t& histogram)
+{
+    std::cout << p_name << ":" << std::endl;
+    for (size_t b = 0; b < histogram.size(); ++b) {
+        if (histogram[b] != 0) {
+            const uint64_t low = (b == 0) ? 0 : uint64_t(1) << (b - 1);
+            std::cout << "  " << std::setw(10) << low << " - " << std::setw(10) << ((b == 0) ? 0 : 2 * low - 1)
+                      << ": " << histogram[b] << std::endl;
+        }
+    }
+}
+
+void print_census(const life::census& c, const double seconds)
+{
+    const life::census_report& r = c.report();
+    const auto share = [&r] (const uint64_t count) {
+        std::ostringstream ss;
+        ss << " (" << std::fixed << std::setprecision(2) << ((r.soup_count == 0) ? 0.0 : 100.0 * count / r.soup_count)
+           << "%)";
+        return ss.str();
+    };
+    std::cout << "Soups: " << r.soup_count << " of " << c.soup_rows() << "x" << c.soup_cols() << " at density "
+              << c.density() << " on " << c.row_count() << "x" << c.col_count() << ", seed " << c.seed()
+              << ", rule " << c.rule().to_string() << std::endl
+              << "Generations: " << r.generations << ", time: " << seconds << " s, "
+              << ((seconds > 0) ? r.soup_count / seconds : 0) << " soups/s" << std::endl
+              << "Extinct: " << r.extinct_count << share(r.extinct_count) << std::endl
+              << "Still lifes: " << r.still_life_count << share(r.still_life_count) << std::endl
+              << "Oscillators: " << r.oscillator_count << share(r.oscillator_count) << std::endl
+              << "Unsettled after " << c.max_generations() << " generations: " << r.unsettled_count
+              << share(r.unsettled_count) << std::endl;
+    if (r.settled_count() == 0) {
+        return;
+    }
+
+    std::cout << "Lifespan: mean " << (double)r.lifespan_sum / r.settled_count() << ", max " << r.max_lifespan
+              << " (soup " << r.max_lifespan_soup << ")" << std::endl
+              << "Final population: mean " << (double)r.population_sum / r.settled_count() << ", max "
+              << r.max_population << std::endl;
+    print_histogram("Lifespans", r.lifespans);
+    print_histogram("Final populations", r.populations);
+    std::cout << "Periods:" << std::endl;
+    for (const auto& p : r.periods) {
+        std::cout << "  " << std::setw(10) << p.first << ": " << p.second << std::endl;
+    }
+}
+
+/// Runs the soups in batches, so a signal stops the census with the report
+/// of the soups run so far.
+int run_census(const po::prog_opts& po)
+{
+    // Bounds the time to notice a signal.
+    constexpr uint64_t max_batch = 1 << 16;
+
+    const int soup_count = po.value<int>("--census");
+    const int rows_count = po.value<int>("--row");
+    const int cols_count = po.value<int>("--column");
+    const int soup_size = po.value<int>("--soup-size");
+    if ((soup_count < 0) || (rows_count < 1) || (cols_count < 1)) {
+        std::cerr << "Invalid census of " << soup_count << " soups on " << rows_count << "x" << cols_count
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    if ((soup_size < 1) || (soup_size > rows_count) || (soup_size > cols_count)) {
+        std::cerr << "Invalid soup size '" << soup_size << "', soups must fit the board" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const double density = po.value<double>("--density");
+    if ((density < 0) || (density > 1)) {
+        std::cerr << "Invalid density '" << density << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int threads_count = po.value<int>("--threads");
+    const int max_generations = po.value<int>("--max-generations");
+    const int cycle_history = po.value<int>("--cycle-history");
+    if ((threads_count < 0) || (max_generations < 0) || (cycle_history < 1)) {
+        std::cerr << "Invalid threads count, generation limit or cycle history" << std::endl;
+        return EXIT_FAILURE;
+    }
+    life::rule rule;
+    if (po.has_value("--rule") && ! life::rule_from_string(po.value<std::string>("--rule"), rule)) {
+        std::cerr << "Unsupported rule '" << po.value<std::string>("--rule") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    life::boundary::boundary_t boundary = life::boundary::boundary_t::dead;
+    if (! life::boundary::from_string(po.value<std::string>("--boundary"), boundary)) {
+        std::cerr << "Unsupported boundary '" << po.value<std::string>("--boundary") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    life::census c(rows_count, cols_count, soup_size, soup_size);
+    c.set_seed((uint32_t)po.value<int>("--seed"));
+    c.set_density(density);
+    c.set_max_generations(max_generations);
+    c.set_max_period(cycle_history);
+    c.set_rule(rule);
+    c.set_boundary(boundary);
+    c.set_thread_count(threads_count);
+
+    std::signal(SIGTERM, on_stop_signal);
+    std::signal(SIGINT, on_stop_signal);
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    while ((c.next_soup() < (uint64_t)soup_count) && (g_is_stopping == 0)) {
+        c.run(std::min(max_batch, soup_count - c.next_soup()));
+    }
+    print_census(c, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    return EXIT_SUCCESS;
 }
 
 } // <anonymous> namespace
@@ -108,9 +593,65 @@ int main(int argc, char* argv[])
     po.insert<int>("-r,--row", 20, "Rows count. (default 20)");
     po.insert<int>("-c,--column", 40, "Columns count. (default 40)");
     po.insert<int>("-s,--step", 20, "Steps count. (default 20)");
-    po.insert<std::string>("-a,--alive-state", "*", "Alive state. (default '*')");
-    po.insert<std::string>("-d,--delimiter", " ", "Base state delimiter. (default ' ')");
+    po.insert<int>("-t,--threads", 1, "Stepping threads count, 0 - all CPUs. (default 1)");
+    po.insert<int>("-j,--jump", 1, "Generations between printed steps. (default 1)");
+    po.insert<std::string>("-e,--engine", "packed",
+                           "Engine: 'packed', 'hashlife', 'sparse' or 'distributed' over worker processes. "
+                           "(default 'packed')");
+    po.insert<std::string>("-W,--workers", "2x2",
+                           "Distributed engine subdomains as rows x columns, one worker process each. (default '2x2')");
+    po.insert<std::string>("-b,--boundary", "dead",
+                           "Packed board edges: 'dead', 'torus', 'mirror' or 'klein'. (default 'dead')");
+    po.insert<std::string>("-k,--kernel", "adder",
+                           "Packed stepping kernel: 'adder' networks or 'table' lookups of 2x2 blocks. "
+                           "(default 'adder')");
+    po.insert<int>("-T,--temporal-blocking", 0,
+                   "Generations the packed engine advances per pass over cache sized blocks of a board with dead "
+                   "edges, 0 - one per pass. (default 0)");
+    po.insert<std::string>("-R,--rule",
+                           "Rule in B/S notation, e.g. 'B36/S23', B0 rules are not supported. "
+                           "(default the pattern rule or 'B3/S23')");
+    po.insert<int>("-m,--memory", 512, "HashLife node cache limit in MiB. (default 512)");
+    po.insert<std::string>("-a,--alive-state", "*", "Alive state of the table format. (default '*')");
+    po.insert<std::string>("-d,--delimiter", " ", "Delimiter of the table format. (default ' ')");
     po.insert<std::string>("-f,--file", "Input file with base state.");
+    po.insert<std::string>("-u,--resume", "Resume the packed engine from a checkpoint instead of '--file'.");
+    po.insert<std::string>("-C,--checkpoint", "Checkpoint file of the packed engine, written at exit and on SIGTERM.");
+    po.insert<int>("-i,--checkpoint-every", 0, "Generations between checkpoints, 0 - only at exit. (default 0)");
+    po.insert<std::string>("-F,--format", "auto",
+                           "Input format: 'rle', 'life106', 'cells', 'table' or 'auto' by extension. (default 'auto')");
+    po.insert<std::string>("-L,--load-hints", "sequential",
+                           "Input mapping hints: 'populate', 'sequential', 'hugepages' or 'none', comma separated. "
+                           "(default 'sequential')");
+    po.insert<std::string>("-D,--display", "auto",
+                           "Board output: 'ansi' redraws changed cells only, 'plain' prints whole boards, "
+                           "'auto' is 'ansi' on terminals. (default 'auto')");
+    po.insert<int>("-P,--pipeline", 0,
+                   "Frames queued for a writer thread that draws or writes them while the engine goes on, "
+                   "0 - no writer thread. (default 0)");
+    po.insert<std::string>("-B,--backpressure", "block",
+                           "Pipeline full: 'block' waits for the writer, 'drop' skips the frame. (default 'block')");
+    po.insert<std::string>("-l,--log",
+                           "Generation log of every generation, keyframes and deltas, replayed with "
+                           "'game_of_life_replay'.");
+    po.insert<int>("-K,--keyframe-every", 64, "Generations between whole boards in the log. (default 64)");
+    po.insert<std::string>("-z,--compress", "none", "Log compression: 'none' or 'zlib'. (default 'none')");
+    po.insert("-H,--headless", false, "Run '--step' generations at full speed without drawing the board.");
+    po.insert<std::string>("-o,--output", "Headless mode RLE output file of the last generation.");
+    po.insert<int>("-n,--output-every", 0,
+                   "Generations between headless outputs, written to '--output' numbered files. (default 0)");
+    po.insert<std::string>("-M,--metrics", "Stream per-generation metrics of the packed engine: 'csv' or 'json'.");
+    po.insert<std::string>("-O,--metrics-file", "Output file of the metrics. (default stderr)");
+    po.insert("-x,--stop-on-cycle", false, "Stop when the packed board dies out, becomes still or periodic.");
+    po.insert<int>("-y,--cycle-history", 1024, "Longest detected oscillator period. (default 1024)");
+    po.insert<int>("-S,--census",
+                   "Census of this many random soups run until they settle, instead of a board from '--file'. "
+                   "Uses '--row', '--column', '--threads', '--rule', '--boundary' and '--cycle-history'.");
+    po.insert<int>("-g,--soup-size", 16, "Census soup side in the middle of the board. (default 16)");
+    po.insert<double>("-p,--density", 0.5, "Census soup density of live cells. (default 0.5)");
+    po.insert<int>("-E,--seed", 1, "Census master seed, the same seed gives the same soups. (default 1)");
+    po.insert<int>("-G,--max-generations", 10000,
+                   "Census generations after which a soup counts as unsettled. (default 10000)");
     po.insert("-h,--help", false, "Print this message.");
 
     if (po.has_error()) {
@@ -130,28 +671,270 @@ int main(int argc, char* argv[])
         return EXIT_SUCCESS;
     }
 
-    if (! po.has_value("--file")) {
-        std::cerr << "Key '--file' is requared" << std::endl;
+    if (po.has_value("--census")) {
+        return run_census(po);
+    }
+
+    if (! po.has_value("--file") && ! po.has_value("--resume")) {
+        std::cerr << "Key '--file' or '--resume' is requared" << std::endl;
         std::cout << po.usage() << std::endl;
         return EXIT_FAILURE;
     }
 
-    const size_t rows_count = po.value<int>("--row");
-    const size_t cols_count = po.value<int>("--column");
-    size_t step_count = po.value<int>("--step");
+    size_t rows_count = po.value<int>("--row");
+    size_t cols_count = po.value<int>("--column");
+    const size_t step_count = po.value<int>("--step");
+    const int threads_count = po.value<int>("--threads");
+    if (threads_count < 0) {
+        std::cerr << "Invalid threads count '" << threads_count << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int temporal_blocking = po.value<int>("--temporal-blocking");
+    if ((temporal_blocking < 0) || (temporal_blocking > (int)life::engine::max_block_depth)) {
+        std::cerr << "Invalid temporal blocking '" << temporal_blocking << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int jump = po.value<int>("--jump");
+    if (jump < 1) {
+        std::cerr << "Invalid jump '" << jump << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int memory_mb = po.value<int>("--memory");
+    if (memory_mb < 1) {
+        std::cerr << "Invalid memory limit '" << memory_mb << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    unsigned load_hints = pio::mapped_file::none;
+    if (! pio::load_hints_from_string(po.value<std::string>("--load-hints"), load_hints)) {
+        std::cerr << "Invalid load hints '" << po.value<std::string>("--load-hints") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
 
-    const life::engine::grid_t begin_state = grid_form_file(po.value<std::string>("--file"),
-                                                            po.value<std::string>("--alive-state"),
-                                                            po.value<std::string>("--delimiter"));
+    // The pattern is parsed straight into the packed board the engine takes
+    // over, so the only copy of a huge input is the mapping itself.
+    life::bit_grid begin_state(rows_count, cols_count);
+    uint64_t begin_generation = 0;
+    std::string rule_name;
+    if (po.has_value("--resume")) {
+        // The board size comes from the checkpoint.
+        pio::snapshot snap;
+        if (! snap.load(po.value<std::string>("--resume"), begin_state, load_hints)) {
+            std::cerr << "Could not resume: " << snap.error_msg() << std::endl;
+            return EXIT_FAILURE;
+        }
+        rows_count = begin_state.row_count();
+        cols_count = begin_state.col_count();
+        begin_generation = snap.generation();
+        rule_name = snap.rule();
+    } else if (! load_pattern(po.value<std::string>("--file"), po.value<std::string>("--format"),
+                              po.value<std::string>("--alive-state"), po.value<std::string>("--delimiter"),
+                              load_hints, begin_state, rule_name)) {
+        return EXIT_FAILURE;
+    }
 
-    life::engine gl(rows_count, cols_count);
-    gl.start(begin_state);
+    // The rule option overrides the one the pattern or checkpoint was saved with.
+    if (po.has_value("--rule")) {
+        rule_name = po.value<std::string>("--rule");
+    }
+    life::rule rule;
+    if (! rule_name.empty() && ! life::rule_from_string(rule_name, rule)) {
+        std::cerr << "Unsupported rule '" << rule_name << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
 
-    do {
-        print_grid(gl.grid());
-        std::this_thread::sleep_for(std::chrono::milliseconds(300));
-        gl.next_step();
-    } while (--step_count > 0);
+    const std::string& engine_name = po.value<std::string>("--engine");
+
+    std::unique_ptr<metrics_stream> p_metrics;
+    std::ofstream metrics_file;
+    if (po.has_value("--metrics")) {
+        const std::string& format = po.value<std::string>("--metrics");
+        if ((format != "csv") && (format != "json")) {
+            std::cerr << "Unsupported metrics format '" << format << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (engine_name != "packed") {
+            std::cerr << "Metrics are supported by the packed engine only" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (po.has_value("--metrics-file")) {
+            metrics_file.open(po.value<std::string>("--metrics-file"));
+            if (! metrics_file.is_open()) {
+                std::cerr << "Could not open '" << po.value<std::string>("--metrics-file") << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        p_metrics = std::make_unique<metrics_stream>(metrics_file.is_open() ? metrics_file : std::cerr,
+            (format == "csv") ? metrics_stream::format_t::csv : metrics_stream::format_t::json);
+    }
+
+    const std::string& display_name = po.value<std::string>("--display");
+    display::renderer::mode_t display_mode = display::renderer::auto_mode(STDOUT_FILENO);
+    if (display_name == "ansi") {
+        display_mode = display::renderer::mode_t::ansi;
+    } else if (display_name == "plain") {
+        display_mode = display::renderer::mode_t::plain;
+    } else if (display_name != "auto") {
+        std::cerr << "Unsupported display '" << display_name << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    display::renderer board_renderer(STDOUT_FILENO, display_mode);
+
+    run_options opts;
+    opts.p_renderer = &board_renderer;
+    opts.step_count = step_count;
+    opts.jump = jump;
+    opts.p_metrics = p_metrics.get();
+    opts.stop_on_cycle = po.value<bool>("--stop-on-cycle");
+    const int cycle_history = po.value<int>("--cycle-history");
+    if (cycle_history < 1) {
+        std::cerr << "Invalid cycle history '" << cycle_history << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (opts.stop_on_cycle && (engine_name != "packed")) {
+        std::cerr << "Cycle detection is supported by the packed engine only" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    opts.begin_generation = begin_generation;
+    const int checkpoint_every = po.value<int>("--checkpoint-every");
+    if (checkpoint_every < 0) {
+        std::cerr << "Invalid checkpoint interval '" << checkpoint_every << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (po.has_value("--checkpoint")) {
+        opts.checkpoint_path = po.value<std::string>("--checkpoint");
+        opts.checkpoint_every = checkpoint_every;
+    }
+    if ((po.has_value("--checkpoint") || po.has_value("--resume")) && (engine_name != "packed")) {
+        std::cerr << "Checkpoints are supported by the packed engine only" << std::endl;
+        return EXIT_FAILURE;
+    }
+    life::boundary::boundary_t boundary = life::boundary::boundary_t::dead;
+    if (! life::boundary::from_string(po.value<std::string>("--boundary"), boundary)) {
+        std::cerr << "Unsupported boundary '" << po.value<std::string>("--boundary") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const bool is_distributed_torus = (engine_name == "distributed")
+                                      && (boundary == life::boundary::boundary_t::torus);
+    if ((boundary != life::boundary::boundary_t::dead) && (engine_name != "packed") && ! is_distributed_torus) {
+        std::cerr << "Boundaries are supported by the packed engine only, torus by the distributed one too"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    life::kernel::kind_t kernel = life::kernel::kind_t::adder;
+    if (! life::kernel::kind_from_string(po.value<std::string>("--kernel"), kernel)) {
+        std::cerr << "Unsupported kernel '" << po.value<std::string>("--kernel") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if ((kernel != life::kernel::kind_t::adder) && (engine_name != "packed")) {
+        std::cerr << "Kernels are selected for the packed engine only" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    opts.is_headless = po.value<bool>("--headless");
+    const int output_every = po.value<int>("--output-every");
+    if (output_every < 0) {
+        std::cerr << "Invalid output interval '" << output_every << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (po.has_value("--output")) {
+        opts.output_path = po.value<std::string>("--output");
+        opts.output_every = output_every;
+    }
+    if ((po.has_value("--output") || (output_every != 0)) && ! opts.is_headless) {
+        std::cerr << "Key '--output' requires '--headless'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if ((output_every != 0) && ! po.has_value("--output")) {
+        std::cerr << "Key '--output-every' requires '--output'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int pipeline = po.value<int>("--pipeline");
+    if (pipeline < 0) {
+        std::cerr << "Invalid pipeline length '" << pipeline << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    display::frame_ring::backpressure_t backpressure = display::frame_ring::backpressure_t::block;
+    if (! display::backpressure_from_string(po.value<std::string>("--backpressure"), backpressure)) {
+        std::cerr << "Unsupported backpressure '" << po.value<std::string>("--backpressure") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::unique_ptr<display::frame_ring> p_ring;
+    if (pipeline != 0) {
+        p_ring = std::make_unique<display::frame_ring>(pipeline, backpressure);
+        opts.p_ring = p_ring.get();
+    }
+    opts.rule = rule.to_string();
+
+    const int keyframe_every = po.value<int>("--keyframe-every");
+    if (keyframe_every < 1) {
+        std::cerr << "Invalid keyframe interval '" << keyframe_every << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    pio::compression_t compression = pio::compression_t::none;
+    if (! pio::compression_from_string(po.value<std::string>("--compress"), compression)
+        || ! pio::has_compression(compression)) {
+        std::cerr << "Unsupported compression '" << po.value<std::string>("--compress") << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    pio::log_writer log;
+    if (po.has_value("--log")) {
+        if (! log.open(po.value<std::string>("--log"), rows_count, cols_count, opts.rule, keyframe_every,
+                       compression)) {
+            std::cerr << "Could not open the log: " << log.error_msg() << std::endl;
+            return EXIT_FAILURE;
+        }
+        opts.p_log = &log;
+    }
+
+    if (! opts.checkpoint_path.empty()) {
+        // A preempted run stops at the next printed step or batch and
+        // writes its last checkpoint.
+        std::signal(SIGTERM, on_stop_signal);
+        std::signal(SIGINT, on_stop_signal);
+    }
+
+    if (engine_name == "packed") {
+        life::engine gl(rows_count, cols_count);
+        gl.set_thread_count(threads_count);
+        gl.set_temporal_blocking(temporal_blocking);
+        gl.set_boundary(boundary);
+        gl.set_kernel(kernel);
+        gl.set_rule(rule);
+        gl.set_cell_counting(p_metrics != nullptr);
+        gl.set_cycle_detection(opts.stop_on_cycle ? cycle_history : 0);
+        run(gl, std::move(begin_state), opts);
+    } else if (engine_name == "hashlife") {
+        life::hashlife gl(rows_count, cols_count);
+        gl.set_memory_limit(size_t(memory_mb) << 20);
+        gl.set_rule(rule);
+        run(gl, std::move(begin_state), opts);
+    } else if (engine_name == "sparse") {
+        life::sparse_engine gl(rows_count, cols_count);
+        gl.set_rule(rule);
+        run(gl, std::move(begin_state), opts);
+    } else if (engine_name == "distributed") {
+        size_t band_rows = 0;
+        size_t band_cols = 0;
+        if (! parse_size(po.value<std::string>("--workers"), band_rows, band_cols) || (band_rows > rows_count)
+            || (band_cols > cols_count)) {
+            std::cerr << "Invalid workers '" << po.value<std::string>("--workers") << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        cluster::coordinator gl(rows_count, cols_count, band_rows, band_cols);
+        gl.set_boundary(boundary);
+        gl.set_rule(rule);
+        run(gl, std::move(begin_state), opts);
+        if (! gl.error_msg().empty()) {
+            std::cerr << "Distributed run failed: " << gl.error_msg() << std::endl;
+            return EXIT_FAILURE;
+        }
+    } else {
+        std::cerr << "Unsupported engine '" << engine_name << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,160 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2022 Chistyakov Alexander.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include <unistd.h>
+
+#include "display/renderer.h"
+#include "pattern_io/generation_log.h"
+#include "pattern_io/rle.h"
+#include "prog_opts/prog_opts.h"
+
+namespace {
+
+void print_info(const pio::log_reader& log)
+{
+    std::cout << "Board: " << log.row_count() << "x" << log.col_count() << std::endl
+              << "Rule: " << log.rule() << std::endl
+              << "Compression: " << ((log.compression() == pio::compression_t::zlib) ? "zlib" : "none") << std::endl
+              << "Generations: " << log.first_generation() << " - " << log.last_generation() << std::endl
+              << "Frames: " << log.frame_count() << ", keyframes: " << log.keyframe_count() << std::endl;
+}
+
+} // <anonymous> namespace
+
+int main(int argc, char* argv[])
+{
+    po::prog_opts po;
+    po.insert<std::string>("-f,--file", "Generation log written by 'game_of_life --log'.");
+    po.insert<int>("-g,--generation", -1, "First generation to show. (default the first one of the log)");
+    po.insert<int>("-s,--step", 1, "Frames to play from '--generation', 0 - up to the end. (default 1)");
+    po.insert<int>("-w,--wait", 300, "Milliseconds between played frames. (default 300)");
+    po.insert<std::string>("-o,--output", "RLE output file of the last played generation instead of drawing.");
+    po.insert<std::string>("-D,--display", "auto",
+                           "Board output: 'ansi' redraws changed cells only, 'plain' prints whole boards, "
+                           "'auto' is 'ansi' on terminals. (default 'auto')");
+    po.insert("-I,--info", false, "Print the board size, rule and generations of the log.");
+    po.insert("-h,--help", false, "Print this message.");
+
+    if (po.has_error()) {
+        std::cerr << po.error_msg() << std::endl;
+        std::cout << po.usage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (! po.parse(argc, argv)) {
+        std::cerr << po.error_msg() << std::endl;
+        std::cout << po.usage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (po.value<bool>("--help")) {
+        std::cout << po.usage() << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    if (! po.has_value("--file")) {
+        std::cerr << "Key '--file' is requared" << std::endl;
+        std::cout << po.usage() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    pio::log_reader log;
+    if (! log.open(po.value<std::string>("--file"))) {
+        std::cerr << "Could not open the log: " << log.error_msg() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (po.value<bool>("--info")) {
+        print_info(log);
+        return EXIT_SUCCESS;
+    }
+    if (log.frame_count() == 0) {
+        std::cerr << "The log is empty" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int step_count = po.value<int>("--step");
+    if (step_count < 0) {
+        std::cerr << "Invalid steps count '" << step_count << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int wait_ms = po.value<int>("--wait");
+    if (wait_ms < 0) {
+        std::cerr << "Invalid wait '" << wait_ms << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string& display_name = po.value<std::string>("--display");
+    display::renderer::mode_t display_mode = display::renderer::auto_mode(STDOUT_FILENO);
+    if (display_name == "ansi") {
+        display_mode = display::renderer::mode_t::ansi;
+    } else if (display_name == "plain") {
+        display_mode = display::renderer::mode_t::plain;
+    } else if (display_name != "auto") {
+        std::cerr << "Unsupported display '" << display_name << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    display::renderer board_renderer(STDOUT_FILENO, display_mode);
+
+    // Seeking decodes from the keyframe before the generation, playing on
+    // applies one delta per frame.
+    const int generation = po.value<int>("--generation");
+    life::bit_grid grid;
+    if (! log.seek((generation < 0) ? log.first_generation() : generation, grid)) {
+        std::cerr << "Could not seek: " << log.error_msg() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const bool is_drawn = ! po.has_value("--output");
+    for (int frame = 1; ; ++frame) {
+        if (is_drawn) {
+            board_renderer.draw(grid);
+        }
+        if ((frame == step_count) || (log.generation() == log.last_generation())) {
+            break;
+        }
+        if (is_drawn && (wait_ms != 0)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+        }
+        if (! log.next(grid)) {
+            std::cerr << "Could not read the log: " << log.error_msg() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (! is_drawn) {
+        const std::string& path = po.value<std::string>("--output");
+        std::ofstream out(path, std::ios::binary);
+        if (! out.is_open() || ! pio::rle_writer(out).write(grid, log.rule())) {
+            std::cerr << "Could not write '" << path << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
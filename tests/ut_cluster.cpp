@@ -0,0 +1,114 @@
+#include <random>
+#include <set>
+#include <string>
+
+#include "cluster/coordinator.h"
+#include "cluster/layout.h"
+#include "engine/life_engine.h"
+
+#include "testdefs.h"
+
+namespace {
+
+life::bit_grid random_board(const size_t row_count, const size_t col_count, const uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    life::bit_grid grid(row_count, col_count);
+    for (size_t r = 0; r < row_count; ++r) {
+        for (size_t c = 0; c < col_count; ++c) {
+            grid.set(r, c, (gen() % 3) == 0);
+        }
+    }
+    return grid;
+}
+
+} // <anonymous> namespace
+
+TEST(cluster, layout)
+{
+    // Subdomains cover the board once, bands differ by one at most.
+    const cluster::layout l(70, 150, 3, 4);
+    EXPECTED((l.worker_count() == 12) && (l.max_rows() == 24) && (l.max_cols() == 38));
+    std::set<std::pair<size_t, size_t>> cells;
+    for (size_t w = 0; w < l.worker_count(); ++w) {
+        const cluster::layout::area a = l.subdomain(w);
+        EXPECTED((a.row_count >= 23) && (a.row_count <= 24) && (a.col_count >= 37) && (a.col_count <= 38));
+        for (size_t r = a.row_begin; r < a.row_begin + a.row_count; ++r) {
+            for (size_t c = a.col_begin; c < a.col_begin + a.col_count; ++c) {
+                cells.emplace(r, c);
+            }
+        }
+    }
+    EXPECTED(cells.size() == 70 * 150);
+
+    EXPECTED((l.neighbour(5, -1, -1) == 0) && (l.neighbour(5, 1, 1) == 10) && (l.neighbour(5, 0, 1) == 6));
+    EXPECTED((l.neighbour(0, -1, 0) == cluster::layout::none) && (l.neighbour(3, 0, 1) == cluster::layout::none));
+    EXPECTED(l.neighbour(11, 1, 1) == cluster::layout::none);
+
+    const cluster::layout torus(70, 150, 3, 4, true);
+    EXPECTED((torus.neighbour(0, -1, -1) == 11) && (torus.neighbour(3, 0, 1) == 0));
+    EXPECTED(torus.neighbour(11, 1, 1) == 0);
+    const cluster::layout single(10, 10, 1, 1, true);
+    EXPECTED((single.neighbour(0, -1, 1) == 0) && (single.neighbour(0, 1, 0) == 0));
+}
+
+TEST(cluster, coordinator)
+{
+    // The workers together step the board exactly like one engine.
+    struct setup final
+    {
+        size_t col_count;
+        size_t band_rows;
+        size_t band_cols;
+        life::boundary::boundary_t boundary;
+        const char* p_rule;
+    };
+    const setup setups[] = {
+        {150, 1, 1, life::boundary::boundary_t::dead, "B3/S23"},
+        {150, 2, 3, life::boundary::boundary_t::dead, "B3/S23"},
+        {150, 4, 1, life::boundary::boundary_t::dead, "B36/S23"},
+        {256, 2, 2, life::boundary::boundary_t::dead, "B3/S23"},
+        {150, 1, 1, life::boundary::boundary_t::torus, "B3/S23"},
+        {150, 3, 2, life::boundary::boundary_t::torus, "B3/S23"},
+        {256, 1, 2, life::boundary::boundary_t::torus, "B36/S23"},
+    };
+    for (const setup& s : setups) {
+        const std::string name = std::to_string(s.col_count) + " " + std::to_string(s.band_rows) + "x" + std::to_string(s.band_cols) + " "
+                                 + life::boundary::name(s.boundary) + " " + s.p_rule;
+        life::rule rule;
+        EXPECTED(life::rule_from_string(s.p_rule, rule));
+        const life::bit_grid board = random_board(70, s.col_count, 7);
+
+        life::engine gl(70, s.col_count);
+        gl.set_boundary(s.boundary);
+        gl.set_rule(rule);
+        gl.start(board);
+
+        cluster::coordinator c(70, s.col_count, s.band_rows, s.band_cols);
+        EXPECTED(c.set_boundary(s.boundary));
+        c.set_rule(rule);
+        EXPECTED(c.start(board)) << name << " " << c.error_msg() << std::endl;
+
+        life::bit_grid snapshot;
+        for (const uint64_t generations : {0, 1, 1, 5, 30}) {
+            gl.step_n(generations);
+            EXPECTED(c.step_n(generations)) << name << " " << c.error_msg() << std::endl;
+            EXPECTED(c.snapshot(snapshot) && (snapshot == gl.storage()))
+                    << name << " generation " << gl.generation() << std::endl;
+            uint64_t population = 0;
+            EXPECTED(c.population(population) && (population == gl.population()));
+            EXPECTED(c.generation() == gl.generation());
+        }
+        c.stop();
+        EXPECTED(! c.step_n(1) && ! c.snapshot(snapshot));
+    }
+
+    cluster::coordinator c(10, 10, 11, 1);
+    EXPECTED(! c.start(life::bit_grid(10, 10)) && ! c.error_msg().empty());
+    EXPECTED(! c.set_boundary(life::boundary::boundary_t::mirror));
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
@@ -0,0 +1,172 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "display/frame_ring.h"
+#include "display/renderer.h"
+
+#include "testdefs.h"
+
+namespace {
+
+constexpr size_t frame_count = 2000;
+
+/// A board that tells its generation.
+life::bit_grid make_frame(const uint64_t generation)
+{
+    life::bit_grid grid(8, 70);
+    grid.set(generation % 8, generation % 70, true);
+    return grid;
+}
+
+struct ring_run final
+{
+    std::vector<uint64_t> generations;
+    size_t mismatches = 0;
+    size_t early_ends = 0;
+    size_t rejected = 0;
+    bool is_last_seen = false;
+};
+
+/// Streams frame_count frames through 'ring', the consumer taking 'delay'
+/// per frame.
+ring_run run_ring(display::frame_ring& ring, const std::chrono::microseconds delay)
+{
+    ring_run res;
+    std::atomic<bool> is_closed(false);
+    std::thread producer([&] () {
+        for (uint64_t g = 0; g < frame_count; ++g) {
+            if (! ring.push(make_frame(g), g, g + 1 == frame_count)) {
+                ++res.rejected;
+            }
+        }
+        is_closed = true;
+        ring.close();
+    });
+
+    for (const display::frame_ring::frame* p_frame = ring.front(); p_frame != nullptr; p_frame = ring.front()) {
+        res.generations.push_back(p_frame->generation);
+        res.mismatches += (p_frame->grid != make_frame(p_frame->generation)) ? 1 : 0;
+        res.is_last_seen = p_frame->is_last;
+        ring.pop();
+        if (delay.count() != 0) {
+            std::this_thread::sleep_for(delay);
+        }
+    }
+    // The ring ends only once closed and drained.
+    res.early_ends += is_closed ? 0 : 1;
+    producer.join();
+    EXPECTED(ring.front() == nullptr);
+    return res;
+}
+
+/// Takes everything written to the pipe so far.
+std::string read_pipe(const int fd)
+{
+    std::string data;
+    char buffer[4096];
+    for (ssize_t size = read(fd, buffer, sizeof(buffer)); size > 0; size = read(fd, buffer, sizeof(buffer))) {
+        data.append(buffer, (size_t)size);
+    }
+    return data;
+}
+
+} // <anonymous> namespace
+
+TEST(display, frame_ring_block)
+{
+    for (const size_t capacity : {1, 4}) {
+        for (const std::chrono::microseconds delay : {std::chrono::microseconds(0), std::chrono::microseconds(20)}) {
+            display::frame_ring ring(capacity, display::frame_ring::backpressure_t::block);
+            const ring_run res = run_ring(ring, delay);
+
+            EXPECTED(res.generations.size() == frame_count) << res.generations.size() << " frames" << std::endl;
+            for (size_t i = 0; i < res.generations.size(); ++i) {
+                EXPECTED(res.generations[i] == i);
+            }
+            EXPECTED((res.mismatches == 0) && (res.early_ends == 0) && res.is_last_seen);
+            EXPECTED((ring.dropped() == 0) && (res.rejected == 0));
+        }
+    }
+}
+
+TEST(display, frame_ring_drop)
+{
+    // A slow consumer makes the producer drop frames, but never the last.
+    display::frame_ring ring(2, display::frame_ring::backpressure_t::drop);
+    const ring_run res = run_ring(ring, std::chrono::microseconds(50));
+
+    EXPECTED(ring.dropped() > 0);
+    EXPECTED(ring.dropped() == res.rejected);
+    EXPECTED(res.generations.size() + ring.dropped() == frame_count);
+    for (size_t i = 1; i < res.generations.size(); ++i) {
+        EXPECTED(res.generations[i - 1] < res.generations[i]);
+    }
+    EXPECTED(! res.generations.empty() && (res.generations.back() == frame_count - 1) && res.is_last_seen);
+    EXPECTED((res.mismatches == 0) && (res.early_ends == 0));
+
+    display::frame_ring::backpressure_t backpressure = display::frame_ring::backpressure_t::block;
+    EXPECTED(display::backpressure_from_string("drop", backpressure)
+             && (backpressure == display::frame_ring::backpressure_t::drop));
+    EXPECTED(! display::backpressure_from_string("wait", backpressure));
+}
+
+TEST(display, renderer)
+{
+    int fds[2];
+    EXPECTED(pipe(fds) == 0);
+    EXPECTED(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+
+    // A pipe has no terminal size, the frames are clipped to 3 x 70 cells.
+    display::renderer ansi(fds[1], display::renderer::mode_t::ansi);
+    ansi.set_max_size(3, 70);
+    life::bit_grid frame(4, 100);
+    frame.set(0, 0, true);
+    EXPECTED(ansi.draw(frame));
+    const std::string dead_row(70, '-');
+    EXPECTED(read_pipe(fds[0]) == "\x1b[H\x1b[2J*" + dead_row.substr(1) + "\n" + dead_row + "\n" + dead_row + "\n");
+
+    // Neighbouring cells share a cursor move, cells past the clipped
+    // columns and rows are not drawn, the cursor ends below the board.
+    frame.set(0, 0, false);
+    frame.set(0, 5, true);
+    frame.set(0, 6, true);
+    frame.set(1, 69, true);
+    frame.set(1, 70, true);
+    frame.set(2, 64, true);
+    frame.set(3, 1, true);
+    EXPECTED(ansi.draw(frame));
+    EXPECTED(read_pipe(fds[0]) == "\x1b[1;1H-\x1b[1;6H**\x1b[2;70H*\x1b[3;65H*\x1b[4;1H");
+
+    // Nothing changed, only the cursor moves.
+    EXPECTED(ansi.draw(frame));
+    EXPECTED(read_pipe(fds[0]) == "\x1b[4;1H");
+
+    // Another board size or an invalidated frame are drawn in full.
+    const life::bit_grid small(2, 3);
+    EXPECTED(ansi.draw(small));
+    EXPECTED(read_pipe(fds[0]) == "\x1b[H\x1b[2J---\n---\n");
+    ansi.invalidate();
+    EXPECTED(ansi.draw(small));
+    EXPECTED(read_pipe(fds[0]) == "\x1b[H\x1b[2J---\n---\n");
+
+    // Plain frames are whole boards, never clipped.
+    display::renderer plain(fds[1], display::renderer::mode_t::plain);
+    plain.set_max_size(1, 1);
+    EXPECTED(plain.draw(small) && plain.draw(small));
+    EXPECTED(read_pipe(fds[0]) == "\n---\n---\n\n\n---\n---\n\n");
+    EXPECTED(display::renderer::auto_mode(fds[1]) == display::renderer::mode_t::plain);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main()
+{
+    return RUN_TESTS();
+}
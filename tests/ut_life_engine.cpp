@@ -1,12 +1,48 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
 #include <sstream>
 #include <vector>
 
+#include "engine/census.h"
+#include "engine/ensemble_engine.h"
+#include "engine/fixed_engine.h"
+#include "engine/hashlife.h"
 #include "engine/life_engine.h"
+#include "engine/sparse_engine.h"
 
 #include "testdefs.h"
 
 namespace {
 
+std::atomic<size_t> g_alloc_count(0);
+
+} // <anonymous> namespace
+
+void* operator new(size_t size)
+{
+    ++g_alloc_count;
+    void* p = std::malloc((size == 0) ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
 using test_row_t = std::vector<int>;
 using test_grid_t = std::vector<test_row_t>;
 
@@ -48,6 +84,59 @@ std::string print_grid(const life::engine::grid_t& grid)
     return ss.str();
 }
 
+test_grid_t random_grid(const size_t rows, const size_t cols, const uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution alive(0.35);
+
+    test_grid_t grid(rows, test_row_t(cols, 0));
+    for (test_row_t& row : grid) {
+        for (int& cell : row) {
+            cell = alive(gen) ? 1 : 0;
+        }
+    }
+    return grid;
+}
+
+test_grid_t reference_step(const test_grid_t& grid,
+                           const life::boundary::boundary_t boundary = life::boundary::boundary_t::dead,
+                           const life::rule& rule = life::rule())
+{
+    using life::boundary::boundary_t;
+
+    const int rows = (int)grid.size();
+    const int cols = (rows == 0) ? 0 : (int)grid[0].size();
+
+    test_grid_t next(rows, test_row_t(cols, 0));
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int n_count = 0;
+            for (int dr = -1; dr <= 1; ++dr) {
+                for (int dc = -1; dc <= 1; ++dc) {
+                    int nr = r + dr;
+                    int nc = c + dc;
+                    if ((boundary == boundary_t::klein) && ((nr < 0) || (nr >= rows))) {
+                        nc = cols - 1 - nc;
+                    }
+                    if ((boundary == boundary_t::torus) || (boundary == boundary_t::klein)) {
+                        nr = (nr + rows) % rows;
+                        nc = (nc + cols) % cols;
+                    } else if (boundary == boundary_t::mirror) {
+                        nr = std::min(std::max(nr, 0), rows - 1);
+                        nc = std::min(std::max(nc, 0), cols - 1);
+                    }
+                    if ((dr == 0 && dc == 0) || nr < 0 || nr >= rows || nc < 0 || nc >= cols) {
+                        continue;
+                    }
+                    n_count += grid[nr][nc];
+                }
+            }
+            next[r][c] = rule.next(grid[r][c] == 1, n_count) ? 1 : 0;
+        }
+    }
+    return next;
+}
+
 } // <anonymous> namespace
 
 TEST(life_engine, base)
@@ -103,6 +192,971 @@ TEST(life_engine, base)
             << print_grid(gl.grid()) << std::endl;
 }
 
+TEST(life_engine, packed_storage)
+{
+    const std::vector<std::pair<size_t, size_t>> sizes = {{1, 1}, {3, 63}, {5, 64}, {7, 65}, {9, 130}, {2, 513}};
+
+    for (const std::pair<size_t, size_t>& size : sizes) {
+        const test_grid_t begin = random_grid(size.first, size.second, (uint32_t)size.second);
+
+        life::engine gl(size.first, size.second);
+        gl.start(begin, 1);
+
+        size_t population = 0;
+        for (const test_row_t& row : begin) {
+            population += std::count(row.cbegin(), row.cend(), 1);
+        }
+
+        EXPECTED(compare_grids(begin, gl.grid())) << "size " << size.first << "x" << size.second << std::endl;
+        EXPECTED(gl.population() == population) << "size " << size.first << "x" << size.second << std::endl;
+        EXPECTED(gl.storage().row_ptr(0) == gl.storage().row_ptr(-1) + gl.storage().stride());
+        EXPECTED(((uintptr_t)gl.storage().row_ptr(0) % 64) == 0);
+    }
+}
+
+TEST(life_engine, random_soup)
+{
+    test_grid_t state = random_grid(37, 131, 42);
+
+    life::engine gl(37, 131);
+    gl.start(state, 1);
+
+    for (size_t step = 1; step <= 30; ++step) {
+        gl.next_step();
+        state = reference_step(state);
+        EXPECTED(compare_grids(state, gl.grid())) << "fail " << step << " step; grid state:" << std::endl
+                << print_grid(gl.grid()) << std::endl;
+    }
+}
+
+TEST(life_engine, kernels)
+{
+    const std::vector<life::kernel::isa_t> isas = {life::kernel::isa_t::scalar, life::kernel::isa_t::avx2,
+                                                   life::kernel::isa_t::avx512};
+    const std::vector<std::pair<size_t, size_t>> sizes = {{1, 1}, {2, 63}, {9, 64}, {11, 65}, {13, 257}, {17, 600}};
+
+    for (const life::kernel::isa_t isa : isas) {
+        if (life::kernel::step_fn(isa) == nullptr) {
+            std::cout << "skip unsupported kernel '" << life::kernel::isa_name(isa) << "'" << std::endl;
+            continue;
+        }
+
+        for (const std::pair<size_t, size_t>& size : sizes) {
+            test_grid_t state = random_grid(size.first, size.second, (uint32_t)(size.first * size.second));
+
+            life::engine gl(size.first, size.second);
+            EXPECTED(gl.set_isa(isa));
+            gl.start(state, 1);
+
+            for (size_t step = 1; step <= 10; ++step) {
+                gl.next_step();
+                state = reference_step(state);
+                EXPECTED(compare_grids(state, gl.grid())) << "kernel '" << life::kernel::isa_name(isa) << "' size "
+                        << size.first << "x" << size.second << " fail " << step << " step" << std::endl;
+            }
+        }
+    }
+}
+
+TEST(life_engine, table_kernel)
+{
+    using life::boundary::boundary_t;
+
+    life::kernel::kind_t kind = life::kernel::kind_t::adder;
+    EXPECTED(life::kernel::kind_from_string("table", kind) && (kind == life::kernel::kind_t::table));
+    EXPECTED(! life::kernel::kind_from_string("simd", kind));
+
+    // Odd row counts leave a row without a pair at the end of the board.
+    const std::vector<std::pair<size_t, size_t>> sizes = {{1, 1}, {2, 63}, {9, 64}, {11, 65}, {131, 130}};
+    for (const char* text : {"B3/S23", "B36/S23", "B2/S"}) {
+        life::rule rule;
+        EXPECTED(life::rule_from_string(text, rule));
+        for (const boundary_t boundary : {boundary_t::dead, boundary_t::klein}) {
+            for (const std::pair<size_t, size_t>& size : sizes) {
+                test_grid_t state = random_grid(size.first, size.second, (uint32_t)(size.first * size.second));
+
+                life::engine gl(size.first, size.second);
+                gl.set_kernel(life::kernel::kind_t::table);
+                gl.set_rule(rule);
+                gl.set_boundary(boundary);
+                gl.set_cell_counting(boundary == boundary_t::dead);
+                gl.set_thread_count(2);
+                gl.start(state, 1);
+
+                for (size_t step = 1; step <= 8; ++step) {
+                    gl.next_step();
+                    state = reference_step(state, boundary, rule);
+                    EXPECTED(compare_grids(state, gl.grid())) << text << " " << life::boundary::name(boundary)
+                            << " size " << size.first << "x" << size.second << " fail " << step << " step"
+                            << std::endl;
+                }
+                EXPECTED(gl.population() == gl.storage().population());
+            }
+        }
+    }
+}
+
+TEST(life_engine, boundaries)
+{
+    using life::boundary::boundary_t;
+
+    const std::vector<std::pair<size_t, size_t>> sizes = {{1, 1}, {3, 5}, {9, 64}, {11, 65}, {70, 600}};
+    for (const boundary_t boundary : {boundary_t::dead, boundary_t::torus, boundary_t::mirror, boundary_t::klein}) {
+        for (const life::kernel::isa_t isa : {life::kernel::isa_t::scalar, life::kernel::best_isa()}) {
+            for (const std::pair<size_t, size_t>& size : sizes) {
+                test_grid_t state = random_grid(size.first, size.second, (uint32_t)(size.first + size.second));
+
+                life::engine gl(size.first, size.second);
+                EXPECTED(gl.set_isa(isa));
+                gl.set_boundary(boundary);
+                gl.set_cell_counting(true);
+                gl.set_thread_count(2);
+                gl.start(state, 1);
+
+                for (size_t step = 1; step <= 12; ++step) {
+                    gl.next_step();
+                    state = reference_step(state, boundary);
+                    EXPECTED(compare_grids(state, gl.grid())) << life::boundary::name(boundary) << " kernel '"
+                            << life::kernel::isa_name(isa) << "' size " << size.first << "x" << size.second
+                            << " fail " << step << " step" << std::endl;
+                    EXPECTED(gl.population() == gl.storage().population());
+                }
+            }
+        }
+    }
+
+    // A glider crosses the edges of a torus and comes back after 4 steps
+    // per cell of the board width.
+    const test_grid_t glider = {{0, 1, 0}, {0, 0, 1}, {1, 1, 1}};
+    life::engine torus(8, 8);
+    torus.set_boundary(boundary_t::torus);
+    torus.start(glider, 1);
+    const life::bit_grid begin = torus.storage();
+    torus.step_n(16);
+    EXPECTED(torus.storage() != begin);
+    torus.step_n(16);
+    EXPECTED(torus.storage() == begin);
+
+    boundary_t parsed = boundary_t::dead;
+    EXPECTED(life::boundary::from_string("klein", parsed) && (parsed == boundary_t::klein));
+    EXPECTED(! life::boundary::from_string("sphere", parsed));
+}
+
+TEST(life_engine, rules)
+{
+    life::rule r;
+    EXPECTED(r.is_conway() && (r.to_string() == "B3/S23"));
+    EXPECTED(life::rule_from_string("b36/s23", r) && (r.to_string() == "B36/S23") && ! r.is_conway());
+    EXPECTED(life::rule_from_string("23/3", r) && r.is_conway());
+    EXPECTED(life::rule_from_string("S23/B36", r) && (r.to_string() == "B36/S23"));
+    EXPECTED(life::rule_from_string("B2/S", r) && (r.survival() == 0));
+    EXPECTED(! life::rule_from_string("B03/S23", r));
+    EXPECTED(! life::rule_from_string("B9/S23", r));
+    EXPECTED(! life::rule_from_string("B33/S23", r));
+    EXPECTED(! life::rule_from_string("B3S23", r));
+
+    const std::vector<std::string> rules = {"B36/S23", "B3678/S34678", "B2/S", "B1357/S1357", "B45678/S2345",
+                                            "B3/S012345678"};
+    const std::vector<std::pair<size_t, size_t>> sizes = {{3, 5}, {11, 65}, {70, 600}};
+    for (const std::string& text : rules) {
+        EXPECTED(life::rule_from_string(text, r)) << text << std::endl;
+        for (const life::kernel::isa_t isa : {life::kernel::isa_t::scalar, life::kernel::best_isa()}) {
+            for (const std::pair<size_t, size_t>& size : sizes) {
+                test_grid_t state = random_grid(size.first, size.second, (uint32_t)size.second);
+
+                life::engine gl(size.first, size.second);
+                EXPECTED(gl.set_isa(isa));
+                gl.set_rule(r);
+                gl.set_cell_counting(isa == life::kernel::isa_t::scalar);
+                gl.start(state, 1);
+
+                for (size_t step = 1; step <= 8; ++step) {
+                    gl.next_step();
+                    state = reference_step(state, life::boundary::boundary_t::dead, r);
+                    EXPECTED(compare_grids(state, gl.grid())) << text << " kernel '" << life::kernel::isa_name(isa)
+                            << "' size " << size.first << "x" << size.second << " fail " << step << " step"
+                            << std::endl;
+                }
+                EXPECTED(gl.population() == gl.storage().population());
+            }
+        }
+
+        // A pattern in the middle of the window does not reach its edges in
+        // 8 steps, so the unbounded engines must agree with the packed one.
+        test_grid_t state(100, test_row_t(100, 0));
+        const test_grid_t seed = random_grid(20, 20, 7);
+        for (size_t row = 0; row < 20; ++row) {
+            for (size_t col = 0; col < 20; ++col) {
+                state[40 + row][40 + col] = seed[row][col];
+            }
+        }
+        life::sparse_engine se(100, 100);
+        life::hashlife hl(100, 100);
+        se.set_rule(r);
+        hl.set_rule(r);
+        se.start(state, 1);
+        hl.start(state, 1);
+        for (size_t step = 1; step <= 8; ++step) {
+            state = reference_step(state, life::boundary::boundary_t::dead, r);
+        }
+        se.step_n(8);
+        hl.step_n(8);
+        EXPECTED(compare_grids(state, se.grid()) && compare_grids(state, hl.grid())) << text << std::endl;
+    }
+}
+
+TEST(life_engine, threads)
+{
+    const test_grid_t begin = random_grid(203, 517, 7);
+
+    life::engine single(203, 517);
+    single.start(begin, 1);
+    for (size_t step = 0; step < 20; ++step) {
+        single.next_step();
+    }
+
+    for (const size_t threads : {2, 3, 4, 7}) {
+        life::engine gl(203, 517);
+        gl.set_thread_count(threads);
+        EXPECTED(gl.thread_count() == threads);
+        gl.start(begin, 1);
+
+        for (size_t step = 0; step < 20; ++step) {
+            gl.next_step();
+        }
+        EXPECTED(gl.storage() == single.storage()) << "fail with " << threads << " threads" << std::endl;
+    }
+}
+
+TEST(life_engine, active_tiles)
+{
+    const size_t rows = 140;
+    const size_t cols = 1100;
+
+    // Small soups scattered over a large board settle down at different
+    // times, so tiles go idle one by one.
+    test_grid_t state(rows, test_row_t(cols, 0));
+    const std::vector<std::pair<size_t, size_t>> positions = {{10, 20}, {124, 1084}};
+    for (const std::pair<size_t, size_t>& pos : positions) {
+        const test_grid_t soup = random_grid(16, 16, (uint32_t)pos.second);
+        for (size_t r = 0; (r < soup.size()) && (pos.first + r < rows); ++r) {
+            for (size_t c = 0; (c < soup[r].size()) && (pos.second + c < cols); ++c) {
+                state[pos.first + r][pos.second + c] = soup[r][c];
+            }
+        }
+    }
+
+    life::engine gl(rows, cols);
+    gl.start(state, 1);
+    EXPECTED(gl.tile_count() == 3 * 3);
+
+    for (size_t step = 1; step <= 120; ++step) {
+        gl.next_step();
+        state = reference_step(state);
+        EXPECTED(compare_grids(state, gl.grid())) << "fail " << step << " step" << std::endl;
+        if (step == 1) {
+            EXPECTED(gl.active_tile_count() == gl.tile_count());
+        }
+    }
+    EXPECTED(gl.active_tile_count() < gl.tile_count());
+
+    const test_grid_t block = {{1, 1},
+                               {1, 1}};
+    life::engine still(rows, cols);
+    still.start(block, 1);
+    still.next_step();
+    still.next_step();
+    EXPECTED(still.active_tile_count() == 0);
+    EXPECTED(still.population() == 4);
+}
+
+TEST(life_engine, step_n)
+{
+    const test_grid_t begin = random_grid(300, 700, 3);
+
+    life::engine single(300, 700);
+    single.start(begin, 1);
+    for (size_t step = 0; step < 50; ++step) {
+        single.next_step();
+    }
+
+    for (const size_t threads : {1, 3}) {
+        life::engine gl(300, 700);
+        gl.set_thread_count(threads);
+        gl.start(begin, 1);
+        gl.next_step();
+
+        const size_t alloc_count = g_alloc_count;
+        const life::bit_grid::word_t* p_buffers[2] = {gl.storage().row_ptr(0), nullptr};
+        gl.step_n(1);
+        p_buffers[1] = gl.storage().row_ptr(0);
+        gl.step_n(48);
+
+        EXPECTED(g_alloc_count == alloc_count) << (g_alloc_count - alloc_count) << " allocations with "
+                                               << threads << " threads" << std::endl;
+        EXPECTED(p_buffers[0] != p_buffers[1]);
+        EXPECTED(gl.storage().row_ptr(0) == p_buffers[1]);
+        EXPECTED(gl.storage() == single.storage()) << "fail with " << threads << " threads" << std::endl;
+    }
+}
+
+TEST(life_engine, temporal_blocking)
+{
+    // Several block columns, a last block of a single word, a single block
+    // column and a board lower than the halo.
+    const std::vector<std::pair<size_t, size_t>> sizes = {{130, 4200}, {150, 4160}, {70, 300}, {5, 9000}};
+    for (const std::pair<size_t, size_t>& size : sizes) {
+        const test_grid_t begin = random_grid(size.first, size.second, (uint32_t)size.second);
+        for (const size_t depth : {2, 7, 64}) {
+            for (const size_t threads : {1, 3}) {
+                life::engine single(size.first, size.second);
+                single.start(begin, 1);
+                life::engine gl(size.first, size.second);
+                gl.set_thread_count(threads);
+                gl.set_temporal_blocking(depth);
+                EXPECTED(gl.temporal_blocking() == depth);
+                gl.start(begin, 1);
+
+                const size_t alloc_count = g_alloc_count;
+                for (const size_t generations : {1, 13, 40, 40}) {
+                    gl.step_n(generations);
+                    for (size_t i = 0; i < generations; ++i) {
+                        single.next_step();
+                    }
+                    EXPECTED(gl.generation() == single.generation());
+                    EXPECTED(gl.storage() == single.storage()) << "fail " << size.first << "x" << size.second
+                                                               << " depth " << depth << " threads " << threads
+                                                               << " generation " << gl.generation() << std::endl;
+                }
+                EXPECTED(g_alloc_count == alloc_count);
+                single.next_step();
+                gl.next_step();
+                EXPECTED(gl.storage() == single.storage());
+            }
+        }
+    }
+
+    // Still lifes and oscillators far from a glider leave their blocks alone
+    // in passes of the same depth, still lifes in any pass and single step,
+    // until the glider comes by.
+    test_grid_t state(200, test_row_t(4200, 0));
+    const test_grid_t glider = {{0, 1, 0},
+                                {0, 0, 1},
+                                {1, 1, 1}};
+    for (size_t r = 0; r < glider.size(); ++r) {
+        std::copy(glider[r].begin(), glider[r].end(), state[10 + r].begin() + 4000);
+    }
+    state[100][100] = state[100][101] = state[101][100] = state[101][101] = 1;
+    state[150][4150] = state[150][4151] = state[150][4152] = 1;
+    state[190][4080] = state[190][4081] = state[190][4082] = 1;
+    life::rule highlife;
+    EXPECTED(life::rule_from_string("B36/S23", highlife));
+    for (const life::rule& rule : {life::rule(), highlife}) {
+        for (const life::kernel::kind_t kind : {life::kernel::kind_t::adder, life::kernel::kind_t::table}) {
+            life::engine single(200, 4200);
+            single.set_rule(rule);
+            single.start(state, 1);
+            life::engine gl(200, 4200);
+            gl.set_rule(rule);
+            gl.set_kernel(kind);
+            gl.set_temporal_blocking(8);
+            gl.start(state, 1);
+            const size_t generations[] = {8, 8, 2, 3, 1, 3, 8};
+            for (size_t pass = 0; pass < 80; ++pass) {
+                gl.step_n(generations[pass % 7]);
+                single.step_n(generations[pass % 7]);
+                EXPECTED(gl.storage() == single.storage()) << "fail " << rule.to_string() << " "
+                                                           << life::kernel::kind_name(kind) << " pass " << pass
+                                                           << std::endl;
+            }
+        }
+    }
+
+    // A single step leaves a blinker changing in the first tile of a block
+    // only, the other tiles of the block are quiet.
+    for (const size_t depth : {3, 8}) {
+        test_grid_t blinker(64, test_row_t(4096, 0));
+        blinker[10][10] = blinker[10][11] = blinker[10][12] = 1;
+
+        life::engine single(64, 4096);
+        single.start(blinker, 1);
+        life::engine gl(64, 4096);
+        gl.set_temporal_blocking(depth);
+        gl.start(blinker, 1);
+        for (const size_t generations : {1, 8, 1, 1, 64}) {
+            if (generations == 1) {
+                gl.next_step();
+            } else {
+                gl.step_n(generations);
+            }
+            single.step_n(generations);
+            EXPECTED(gl.storage() == single.storage()) << "fail depth " << depth << " generation "
+                                                       << gl.generation() << std::endl;
+        }
+    }
+
+    // Boundaries, counting and cycle detection need every generation.
+    const test_grid_t soup = random_grid(100, 140, 9);
+    for (const life::boundary::boundary_t boundary : {life::boundary::boundary_t::dead,
+                                                      life::boundary::boundary_t::torus}) {
+        life::engine single(100, 140);
+        single.set_boundary(boundary);
+        single.set_cell_counting(true);
+        single.start(soup, 1);
+        single.step_n(30);
+
+        life::engine gl(100, 140);
+        gl.set_boundary(boundary);
+        gl.set_cell_counting(true);
+        gl.set_temporal_blocking(16);
+        gl.start(soup, 1);
+        gl.step_n(30);
+        EXPECTED(gl.storage() == single.storage());
+        EXPECTED(gl.population() == single.population());
+    }
+}
+
+TEST(life_engine, metrics)
+{
+    const std::vector<life::kernel::isa_t> isas = {life::kernel::isa_t::scalar, life::kernel::isa_t::avx2,
+                                                   life::kernel::isa_t::avx512};
+
+    for (const life::kernel::isa_t isa : isas) {
+        if (life::kernel::step_fn(isa) == nullptr) {
+            continue;
+        }
+
+        test_grid_t state = random_grid(150, 600, 11);
+        life::engine gl(150, 600);
+        EXPECTED(gl.set_isa(isa));
+        gl.set_thread_count(2);
+        gl.set_cell_counting(true);
+        gl.start(state, 1);
+        EXPECTED(gl.generation() == 0);
+
+        for (size_t step = 1; step <= 40; ++step) {
+            gl.next_step();
+            const test_grid_t next = reference_step(state);
+
+            size_t population = 0;
+            size_t births = 0;
+            size_t deaths = 0;
+            for (size_t r = 0; r < next.size(); ++r) {
+                for (size_t c = 0; c < next[r].size(); ++c) {
+                    population += next[r][c];
+                    births += (next[r][c] && ! state[r][c]);
+                    deaths += (state[r][c] && ! next[r][c]);
+                }
+            }
+            state = next;
+
+            const life::step_metrics& m = gl.metrics();
+            EXPECTED(m.generation == step);
+            EXPECTED(m.population == population && gl.population() == population)
+                << "kernel '" << life::kernel::isa_name(isa) << "' fail " << step << " step" << std::endl;
+            EXPECTED(m.births == births && m.deaths == deaths && m.changed() == births + deaths)
+                << "kernel '" << life::kernel::isa_name(isa) << "' fail " << step << " step" << std::endl;
+        }
+        life::engine plain(150, 600);
+        EXPECTED(plain.set_isa(isa));
+        plain.start(random_grid(150, 600, 11), 1);
+        plain.step_n(40);
+        EXPECTED(plain.storage() == gl.storage() && plain.generation() == 40);
+        EXPECTED(plain.metrics().births == 0 && plain.population() == gl.population());
+
+        EXPECTED(gl.latency().count() == 40);
+        EXPECTED(gl.latency().percentile(50) <= gl.latency().percentile(99));
+        EXPECTED(gl.latency().percentile(99) <= gl.latency().max());
+
+        gl.stop();
+        EXPECTED(gl.generation() == 0 && gl.population() == 0 && gl.latency().count() == 0);
+    }
+
+    life::latency_histogram hist;
+    for (uint64_t ns = 1; ns <= 1000; ++ns) {
+        hist.record(ns * 1000);
+    }
+    EXPECTED(hist.min() == 1000 && hist.max() == 1000000);
+    // Buckets are 1/8 of a power of two wide.
+    EXPECTED(hist.percentile(50) >= 500000 && hist.percentile(50) <= 500000 + 500000 / 8);
+    EXPECTED(hist.percentile(99) >= 990000 && hist.percentile(99) <= 1000000);
+}
+
+TEST(life_engine, cycles)
+{
+    using state_t = life::cycle_detector::state_t;
+
+    const test_grid_t blinker = {{0, 0, 0, 0, 0},
+                                 {0, 0, 1, 0, 0},
+                                 {0, 0, 1, 0, 0},
+                                 {0, 0, 1, 0, 0}};
+    life::engine gl(70, 600);
+    gl.set_cycle_detection(16);
+    gl.start(blinker, 1);
+    gl.next_step();
+    EXPECTED(! gl.cycles().detected());
+    gl.next_step();
+    EXPECTED(gl.cycles().state() == state_t::oscillator);
+    EXPECTED(gl.cycles().period() == 2 && gl.cycles().cycle_start() == 0);
+
+    const test_grid_t pre_block = {{1, 1},
+                                   {0, 1}};
+    gl.stop();
+    gl.start(pre_block, 1);
+    gl.step_n(2);
+    EXPECTED(gl.cycles().state() == state_t::still_life);
+    EXPECTED(gl.cycles().period() == 1 && gl.cycles().cycle_start() == 1);
+
+    const test_grid_t single = {{0, 1}};
+    gl.stop();
+    gl.start(single, 1);
+    gl.next_step();
+    EXPECTED(gl.cycles().state() == state_t::extinct && gl.cycles().cycle_start() == 1);
+
+    // The state a soup settles into must really repeat with the reported period.
+    for (const uint32_t seed : {1, 2, 3}) {
+        const test_grid_t soup = random_grid(100, 140, seed);
+        life::engine detector(100, 140);
+        detector.set_cycle_detection(64);
+        detector.start(soup, 1);
+        for (size_t step = 0; (step < 3000) && ! detector.cycles().detected(); ++step) {
+            detector.next_step();
+        }
+        EXPECTED(detector.cycles().detected()) << "seed " << seed << std::endl;
+
+        // The generation before the cycle start is not a part of the cycle.
+        const life::cycle_detector& cycles = detector.cycles();
+        EXPECTED(cycles.cycle_start() > 0);
+        life::engine first(100, 140);
+        first.start(soup, 1);
+        first.step_n(cycles.cycle_start() - 1);
+        life::engine second(100, 140);
+        second.start(soup, 1);
+        second.step_n(cycles.cycle_start() + cycles.period() - 1);
+        EXPECTED(first.storage() != second.storage()) << "seed " << seed << std::endl;
+        first.next_step();
+        second.next_step();
+        EXPECTED(first.storage() == second.storage()) << "seed " << seed << std::endl;
+    }
+
+    // Periods longer than the history are not detected.
+    life::cycle_detector short_history(4);
+    life::cycle_detector long_history(5);
+    for (uint64_t gen = 0; gen < 20; ++gen) {
+        short_history.push(gen, 100 + gen % 5, false);
+        long_history.push(gen, 100 + gen % 5, false);
+    }
+    EXPECTED(! short_history.detected());
+    EXPECTED(long_history.detected() && long_history.period() == 5 && long_history.cycle_start() == 0);
+}
+
+TEST(life_engine, packed_start)
+{
+    const test_grid_t state = random_grid(70, 150, 5);
+    life::bit_grid packed(80, 170);
+    for (size_t r = 0; r < state.size(); ++r) {
+        for (size_t c = 0; c < state[r].size(); ++c) {
+            packed.set(r, c, state[r][c] != 0);
+        }
+    }
+    packed.set_run(75, 0, 170);
+
+    life::engine expected(70, 150);
+    expected.start(state, 1);
+
+    // A board of another size is clipped, a board of the engine size is moved in.
+    life::engine clipped(70, 150);
+    EXPECTED(clipped.start(packed));
+    EXPECTED(clipped.storage() == expected.storage());
+
+    clipped.step_n(3);
+    expected.step_n(3);
+    EXPECTED(clipped.storage() == expected.storage());
+
+    life::engine moved(70, 150);
+    life::bit_grid exact = clipped.storage();
+    const life::bit_grid::word_t* p_data = exact.row_ptr(0);
+    EXPECTED(moved.start(std::move(exact)));
+    EXPECTED(moved.storage().row_ptr(0) == p_data);
+    EXPECTED(moved.storage() == expected.storage() && moved.population() == expected.population());
+
+    moved.set_generation(3);
+    moved.next_step();
+    EXPECTED((moved.generation() == 4) && (moved.metrics().generation == 4));
+
+    life::sparse_engine se(70, 150);
+    life::hashlife hl(70, 150);
+    EXPECTED(se.start(packed) && hl.start(packed));
+    EXPECTED(compare_grids(state, se.grid()) && compare_grids(state, hl.grid()));
+}
+
+namespace {
+
+/// A glider stepped four times at compile time, it moves one cell down and
+/// one cell right.
+constexpr life::fixed_engine<8, 8> compile_time_glider()
+{
+    life::fixed_engine<8, 8> gl;
+    gl.set(0, 1, true);
+    gl.set(1, 2, true);
+    gl.set(2, 0, true);
+    gl.set(2, 1, true);
+    gl.set(2, 2, true);
+    gl.step_n(4);
+    return gl;
+}
+
+static_assert(compile_time_glider().population() == 5, "glider must keep five cells");
+static_assert(compile_time_glider().alive(1, 2) && compile_time_glider().alive(3, 3), "glider must move");
+static_assert(compile_time_glider().generation() == 4, "generation must be counted");
+
+template<size_t TRows, size_t TCols>
+void check_fixed_engine(const life::rule& rule)
+{
+    test_grid_t state = random_grid(TRows, TCols, (uint32_t)(TRows * TCols));
+
+    life::fixed_engine<TRows, TCols> gl;
+    gl.set_rule(rule);
+    gl.start(state, 1);
+
+    life::engine packed(TRows, TCols);
+    packed.set_rule(rule);
+    packed.start(state, 1);
+
+    for (size_t step = 1; step <= 8; ++step) {
+        const size_t alloc_count = g_alloc_count;
+        gl.next_step();
+        EXPECTED(g_alloc_count == alloc_count);
+        state = reference_step(state, life::boundary::boundary_t::dead, rule);
+        EXPECTED(compare_grids(state, gl.grid())) << rule.to_string() << " size " << TRows << "x" << TCols
+                << " fail " << step << " step" << std::endl;
+    }
+    packed.step_n(8);
+    EXPECTED(gl.population() == packed.population());
+
+    life::fixed_engine<TRows, TCols> copy;
+    copy.start(packed.storage());
+    EXPECTED(copy.board() == gl.board());
+}
+
+} // <anonymous> namespace
+
+TEST(ensemble_engine, base)
+{
+    // Three groups, the last one partial. Board 5 dies out in the first
+    // step, board 6 holds a blinker and board 7 is empty from the start.
+    const size_t board_count = 150;
+    std::vector<test_grid_t> begin(board_count);
+    for (size_t board = 0; board < board_count; ++board) {
+        begin[board] = random_grid(13, 70, (uint32_t)board);
+    }
+    begin[5] = test_grid_t(13, test_row_t(70, 0));
+    begin[5][3][3] = 1;
+    begin[6] = test_grid_t(13, test_row_t(70, 0));
+    begin[6][4][3] = begin[6][4][4] = begin[6][4][5] = 1;
+    begin[7] = test_grid_t(13, test_row_t(70, 0));
+
+    for (const char* text : {"B3/S23", "B36/S23"}) {
+        life::rule rule;
+        EXPECTED(life::rule_from_string(text, rule));
+
+        life::ensemble_engine ens(board_count, 13, 70);
+        ens.set_rule(rule);
+        for (size_t board = 0; board < board_count; ++board) {
+            EXPECTED(ens.set_board(board, begin[board], 1));
+        }
+        EXPECTED(ens.is_extinct(7) && ! ens.is_extinct(5) && (ens.extinct_count() == 1));
+
+        std::vector<test_grid_t> states = begin;
+        for (size_t step = 1; step <= 8; ++step) {
+            ens.next_step();
+            for (size_t board = 0; board < board_count; ++board) {
+                states[board] = reference_step(states[board], life::boundary::boundary_t::dead, rule);
+                EXPECTED(compare_grids(states[board], ens.grid(board))) << text << " board " << board << " fail "
+                        << step << " step" << std::endl;
+            }
+        }
+
+        const std::vector<uint64_t> populations = ens.populations();
+        size_t extinct_count = 0;
+        for (size_t board = 0; board < board_count; ++board) {
+            life::engine gl(13, 70);
+            gl.start(states[board], 1);
+            EXPECTED(populations[board] == gl.population()) << text << " board " << board << std::endl;
+            EXPECTED(ens.is_extinct(board) == (gl.population() == 0)) << text << " board " << board << std::endl;
+            extinct_count += ens.is_extinct(board) ? 1 : 0;
+        }
+        EXPECTED(ens.extinct_count() == extinct_count);
+        EXPECTED((ens.extinction_generation(5) == 1) && (ens.extinction_generation(7) == 0));
+        EXPECTED((populations[6] == 3) && (ens.generation() == 8));
+    }
+
+    // A group whose boards all died out stays empty once it is skipped.
+    life::ensemble_engine ens(3, 4, 4);
+    ens.set(1, 1, 1, true);
+    ens.step_n(3);
+    EXPECTED((ens.extinct_count() == 3) && (ens.extinction_generation(1) == 1));
+    EXPECTED(ens.populations() == std::vector<uint64_t>(3, 0));
+    ens.set(2, 0, 0, true);
+    EXPECTED(! ens.is_extinct(2));
+    ens.set(2, 0, 0, false);
+    EXPECTED(ens.is_extinct(2) && (ens.extinction_generation(2) == 3));
+    ens.stop();
+    EXPECTED((ens.generation() == 0) && (ens.extinct_count() == 3));
+}
+
+TEST(fixed_engine, base)
+{
+    for (const char* text : {"B3/S23", "B36/S23", "B1357/S1357", "B3/S012345678"}) {
+        life::rule rule;
+        EXPECTED(life::rule_from_string(text, rule));
+        check_fixed_engine<1, 1>(rule);
+        check_fixed_engine<8, 8>(rule);
+        check_fixed_engine<13, 70>(rule);
+        check_fixed_engine<64, 64>(rule);
+    }
+
+    life::fixed_engine<4, 4> gl;
+    EXPECTED(gl.start(test_grid_t{{0, 1, 0, 0}, {0, 0, 1, 0}, {1, 1, 1, 0}}, 1));
+    gl.step_n(3);
+    EXPECTED(gl.generation() == 3);
+    gl.stop();
+    EXPECTED((gl.population() == 0) && (gl.generation() == 0));
+}
+
+TEST(hashlife, base)
+{
+    const test_grid_t begin = {{0, 1, 0, 0},
+                               {0, 0, 1, 0},
+                               {1, 1, 1, 0},
+                               {0, 0, 0, 0}};
+
+    life::hashlife hl(8, 8);
+    hl.start(begin, 1);
+    EXPECTED(hl.population() == 5);
+
+    test_grid_t state(8, test_row_t(8, 0));
+    for (size_t r = 0; r < begin.size(); ++r) {
+        std::copy(begin[r].cbegin(), begin[r].cend(), state[r].begin());
+    }
+    for (size_t step = 1; step <= 12; ++step) {
+        hl.next_step();
+        state = reference_step(state);
+        EXPECTED(compare_grids(state, hl.grid())) << "fail " << step << " step; grid state:" << std::endl
+                << print_grid(hl.grid()) << std::endl;
+    }
+    EXPECTED(hl.generation() == 12);
+}
+
+TEST(hashlife, jumps)
+{
+    // A soup in the middle of the board never reaches its border, so the
+    // bounded engine is an exact reference for the unbounded universe.
+    test_grid_t begin(160, test_row_t(160, 0));
+    const test_grid_t soup = random_grid(24, 24, 11);
+    for (size_t r = 0; r < soup.size(); ++r) {
+        std::copy(soup[r].cbegin(), soup[r].cend(), begin[68 + r].begin() + 68);
+    }
+
+    life::engine gl(160, 160);
+    gl.start(begin, 1);
+
+    life::hashlife hl(160, 160);
+    hl.start(begin, 1);
+
+    for (const uint64_t jump : {1, 2, 3, 8, 13, 32}) {
+        for (uint64_t i = 0; i < jump; ++i) {
+            gl.next_step();
+        }
+        hl.advance(jump);
+        EXPECTED(hl.grid() == gl.grid()) << "fail jump " << jump << std::endl;
+        EXPECTED(hl.population() == gl.population()) << "fail jump " << jump << std::endl;
+    }
+}
+
+TEST(hashlife, gc)
+{
+    const test_grid_t glider = {{0, 0, 1},
+                                {1, 0, 1},
+                                {0, 1, 1}};
+    const uint64_t distance = uint64_t(1) << 30;
+
+    life::hashlife hl(3, 3);
+    hl.set_memory_limit(size_t(1) << 20);
+    hl.start(glider, 1);
+    hl.advance(4 * distance);
+
+    EXPECTED(hl.generation() == 4 * distance);
+    EXPECTED(hl.population() == 5);
+    EXPECTED(hl.alive(distance + 2, distance + 2));
+    EXPECTED(hl.alive(distance + 1, distance));
+    EXPECTED(! hl.alive(0, 2));
+
+    const test_grid_t begin = random_grid(64, 64, 5);
+    life::hashlife big(64, 64);
+    big.start(begin, 1);
+    big.advance(1000);
+
+    life::hashlife small(64, 64);
+    small.set_memory_limit(size_t(1) << 20);
+    small.start(begin, 1);
+    for (size_t i = 0; i < 10; ++i) {
+        small.advance(100);
+    }
+
+    EXPECTED(small.population() == big.population());
+    EXPECTED(small.grid() == big.grid());
+    EXPECTED(small.memory_usage() < big.memory_usage());
+}
+
+TEST(sparse_engine, base)
+{
+    test_grid_t begin(160, test_row_t(160, 0));
+    const test_grid_t soup = random_grid(24, 24, 13);
+    for (size_t r = 0; r < soup.size(); ++r) {
+        std::copy(soup[r].cbegin(), soup[r].cend(), begin[68 + r].begin() + 68);
+    }
+
+    life::engine gl(160, 160);
+    gl.start(begin, 1);
+
+    life::sparse_engine se(160, 160);
+    se.start(begin, 1);
+
+    for (size_t step = 1; step <= 60; ++step) {
+        gl.next_step();
+        se.next_step();
+        EXPECTED(se.grid() == gl.grid()) << "fail " << step << " step" << std::endl;
+    }
+    EXPECTED(se.population() == gl.population());
+    EXPECTED(se.generation() == 60);
+}
+
+TEST(sparse_engine, unbounded)
+{
+    // Soups spill over the origin into negative coordinates, HashLife is
+    // the reference for the unbounded universe.
+    const test_grid_t begin = random_grid(40, 40, 17);
+
+    life::sparse_engine se(40, 40);
+    se.start(begin, 1);
+
+    life::hashlife hl(40, 40);
+    hl.start(begin, 1);
+
+    for (size_t step = 0; step < 300; ++step) {
+        se.next_step();
+    }
+    hl.advance(300);
+
+    EXPECTED(se.population() == hl.population());
+    bool is_equal = true;
+    for (int64_t r = -200; r < 240; ++r) {
+        for (int64_t c = -200; c < 240; ++c) {
+            is_equal = is_equal && (se.alive(r, c) == hl.alive(r, c));
+        }
+    }
+    EXPECTED(is_equal);
+
+    const test_grid_t glider = {{0, 0, 1},
+                                {1, 0, 1},
+                                {0, 1, 1}};
+    life::sparse_engine traveller(3, 3);
+    traveller.start(glider, 1);
+    for (size_t step = 0; step < 4000; ++step) {
+        traveller.next_step();
+    }
+    EXPECTED(traveller.population() == 5);
+    EXPECTED(traveller.alive(1002, 1002));
+    EXPECTED(traveller.tile_count() <= 4);
+}
+
+TEST(sparse_engine, step_n)
+{
+    // Blinkers across tile borders make tiles come and go every step, the
+    // tile nodes are reused.
+    test_grid_t begin(200, test_row_t(200, 0));
+    begin[63][10] = begin[64][10] = begin[65][10] = 1;
+    begin[10][63] = begin[10][64] = begin[10][65] = 1;
+    begin[128][127] = begin[128][128] = begin[128][129] = 1;
+    begin[150][20] = begin[150][21] = begin[151][20] = begin[151][21] = 1;
+
+    life::engine gl(200, 200);
+    gl.start(begin, 1);
+    life::sparse_engine se(200, 200);
+    se.start(begin, 1);
+    se.step_n(2);
+    gl.step_n(2);
+
+    const size_t alloc_count = g_alloc_count;
+    se.step_n(101);
+    EXPECTED(g_alloc_count == alloc_count) << (g_alloc_count - alloc_count) << " allocations" << std::endl;
+    gl.step_n(101);
+    EXPECTED(se.grid() == gl.grid());
+    EXPECTED(se.generation() == 103);
+}
+
+TEST(census, base)
+{
+    // Soups are in the middle of the board, at the density and the same
+    // for the same seed.
+    life::census c(40, 50, 16, 20);
+    life::bit_grid first;
+    life::bit_grid second;
+    c.soup(3, first);
+    c.soup(3, second);
+    EXPECTED((first == second) && (first.row_count() == 40) && (first.col_count() == 50));
+    EXPECTED((first.population() > 16 * 20 / 4) && (first.population() < 16 * 20 * 3 / 4));
+    c.soup(4, second);
+    EXPECTED(first != second);
+    c.set_density(1);
+    c.soup(3, first);
+    EXPECTED((first.population() == 16 * 20) && first.get(12, 15) && first.get(27, 34) && ! first.get(11, 15));
+    c.set_density(0);
+    c.soup(3, first);
+    EXPECTED(first.population() == 0);
+
+    c.run(10);
+    EXPECTED((c.report().soup_count == 10) && (c.report().extinct_count == 10) && (c.report().lifespan_sum == 0));
+    EXPECTED((c.report().lifespans[0] == 10) && (c.report().populations[0] == 10));
+
+    // The report does not depend on the threads or the batches.
+    life::census single(40, 50, 16, 16);
+    single.set_seed(9);
+    single.set_max_generations(300);
+    single.run(150);
+    life::census multi(40, 50, 16, 16);
+    multi.set_seed(9);
+    multi.set_max_generations(300);
+    multi.set_thread_count(3);
+    multi.run(70);
+    multi.run(80);
+    const life::census_report& a = single.report();
+    const life::census_report& b = multi.report();
+    EXPECTED((a.soup_count == 150) && (a.settled_count() + a.unsettled_count == 150));
+    EXPECTED(a.extinct_count + a.still_life_count + a.oscillator_count == a.settled_count());
+    EXPECTED((a.still_life_count > 0) && (a.oscillator_count > 0) && (a.unsettled_count > 0));
+    EXPECTED((a.extinct_count == b.extinct_count) && (a.still_life_count == b.still_life_count)
+             && (a.oscillator_count == b.oscillator_count) && (a.generations == b.generations));
+    EXPECTED((a.lifespan_sum == b.lifespan_sum) && (a.max_lifespan == b.max_lifespan)
+             && (a.max_lifespan_soup == b.max_lifespan_soup) && (a.population_sum == b.population_sum));
+    EXPECTED((a.lifespans == b.lifespans) && (a.populations == b.populations) && (a.periods == b.periods));
+    EXPECTED(a.periods.at(1) == a.still_life_count);
+
+    // The longest lived soup is rebuilt from its index.
+    single.soup(a.max_lifespan_soup, first);
+    life::engine gl(40, 50);
+    gl.set_cycle_detection(1024);
+    gl.start(first);
+    while (! gl.cycles().detected()) {
+        gl.next_step();
+    }
+    EXPECTED(gl.cycles().cycle_start() == a.max_lifespan);
+
+    EXPECTED((life::census_report::bucket(0) == 0) && (life::census_report::bucket(1) == 1));
+    EXPECTED((life::census_report::bucket(7) == 3) && (life::census_report::bucket(8) == 4));
+}
+
 int main()
 {
     return RUN_TESTS();
@@ -0,0 +1,431 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/bit_grid.h"
+#include "pattern_io/cells.h"
+#include "pattern_io/generation_log.h"
+#include "pattern_io/grid_sink.h"
+#include "pattern_io/life106.h"
+#include "pattern_io/mapped_file.h"
+#include "pattern_io/rle.h"
+#include "pattern_io/snapshot.h"
+#include "pattern_io/table.h"
+
+#include "testdefs.h"
+
+#include <unistd.h>
+
+namespace {
+
+using cells_t = std::set<std::pair<int64_t, int64_t>>;
+
+class cells_sink final : public pio::sink
+{
+public:
+    void on_cells(const int64_t row, const int64_t col, const uint64_t count) override
+    {
+        for (uint64_t i = 0; i < count; ++i) {
+            cells.emplace(row, col + (int64_t)i);
+        }
+    }
+
+    void on_header(const pio::header& h) override { hdr = h; }
+
+    cells_t cells;
+    pio::header hdr;
+};
+
+// Feeds the text in chunks of 'chunk' bytes, so every state crosses a chunk border.
+bool feed(pio::parser& p, const std::string& text, const size_t chunk)
+{
+    for (size_t pos = 0; pos < text.size(); pos += chunk) {
+        if (! p.feed(text.data() + pos, std::min(chunk, text.size() - pos))) {
+            return false;
+        }
+    }
+    return p.finish();
+}
+
+// Writes the text to a new temporary file and returns its path.
+std::string temp_file(const std::string& text)
+{
+    char path[] = "/tmp/ut_pattern_io_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+    }
+    std::ofstream(path, std::ios::binary) << text;
+    return path;
+}
+
+const cells_t glider = {{0, 1}, {1, 2}, {2, 0}, {2, 1}, {2, 2}};
+
+} // <anonymous> namespace
+
+TEST(pattern_io, rle)
+{
+    const std::string text = "#N Glider\r\n#C A comment\r\nx = 3, y = 3, rule = B3/S23\r\nbo$2bo$3o!\nignored";
+    for (size_t chunk = 1; chunk <= text.size(); ++chunk) {
+        cells_sink sink;
+        pio::rle_parser p(sink);
+        EXPECTED(feed(p, text, chunk)) << p.error_msg() << std::endl;
+        EXPECTED(sink.cells == glider) << "chunk " << chunk << std::endl;
+        EXPECTED(sink.hdr.width == 3 && sink.hdr.height == 3 && sink.hdr.rule == "B3/S23");
+    }
+
+    cells_sink sink;
+    pio::rle_parser p(sink);
+    EXPECTED(feed(p, "2o3b12o2$o!", 3));
+    EXPECTED(sink.cells.size() == 15 && sink.cells.count({0, 5}) == 1 && sink.cells.count({0, 16}) == 1);
+    EXPECTED(sink.cells.count({2, 0}) == 1 && sink.cells.count({0, 2}) == 0);
+
+    cells_sink bad_sink;
+    pio::rle_parser bad(bad_sink);
+    EXPECTED(! feed(bad, "x = 3, y = 1\nbo?o!", 4));
+    EXPECTED(bad.error_msg() == "line 2: unexpected character '?'") << bad.error_msg() << std::endl;
+
+    pio::rle_parser bad_header(bad_sink);
+    EXPECTED(! feed(bad_header, "x = 3, y = z\no!", 1));
+}
+
+TEST(pattern_io, rle_writer)
+{
+    life::bit_grid glider_grid(5, 4);
+    for (const auto& cell : glider) {
+        glider_grid.set(cell.first, cell.second, true);
+    }
+    std::ostringstream glider_out;
+    EXPECTED(pio::rle_writer(glider_out).write(glider_grid, "B3/S23"));
+    EXPECTED(glider_out.str() == "x = 4, y = 5, rule = B3/S23\nbo$2bo$3o!\n") << glider_out.str() << std::endl;
+
+    life::bit_grid grid(90, 200);
+    for (size_t r = 0; r < 80; r += 3) {
+        for (size_t c = r % 7; c < 200; c += (r % 5) + 1) {
+            grid.set_run(r, c, r % 4);
+        }
+    }
+    grid.set_run(40, 0, 200);
+
+    std::ostringstream out;
+    EXPECTED(pio::rle_writer(out).write(grid, ""));
+    std::istringstream lines(out.str());
+    for (std::string line; std::getline(lines, line);) {
+        EXPECTED(line.size() <= 70) << line << std::endl;
+    }
+
+    life::bit_grid parsed(90, 200);
+    pio::grid_sink sink(parsed);
+    pio::rle_parser p(sink);
+    std::istringstream in(out.str());
+    EXPECTED(p.parse(in)) << p.error_msg() << std::endl;
+    EXPECTED((parsed == grid) && (sink.pattern_header().width == 200) && sink.pattern_header().rule.empty());
+}
+
+TEST(pattern_io, life106)
+{
+    const std::string text = "#Life 1.06\n0 -1\n1 0\n-1 1\n0 1\n1 1";
+    for (size_t chunk = 1; chunk <= text.size(); ++chunk) {
+        cells_sink sink;
+        pio::life106_parser p(sink);
+        EXPECTED(feed(p, text, chunk)) << p.error_msg() << std::endl;
+        const cells_t expected = {{-1, 0}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+        EXPECTED(sink.cells == expected) << "chunk " << chunk << std::endl;
+    }
+
+    cells_sink sink;
+    pio::life106_parser bad(sink);
+    EXPECTED(! feed(bad, "#Life 1.06\n1 2 3\n", 5));
+    EXPECTED(bad.error_msg() == "line 2: expected 'x y' position") << bad.error_msg() << std::endl;
+}
+
+TEST(pattern_io, cells)
+{
+    const std::string text = "!Name: Glider\n!\n.O.\r\n..O\r\nOOO\r\n";
+    for (size_t chunk = 1; chunk <= text.size(); ++chunk) {
+        cells_sink sink;
+        pio::cells_parser p(sink);
+        EXPECTED(feed(p, text, chunk)) << p.error_msg() << std::endl;
+        EXPECTED(sink.cells == glider) << "chunk " << chunk << std::endl;
+    }
+
+    cells_sink sink;
+    pio::cells_parser bad(sink);
+    EXPECTED(! feed(bad, ".O.\n.x.\n", 2));
+}
+
+TEST(pattern_io, table)
+{
+    const std::string text = "0, 1, 0\n0, 0, 1\n1, 1, 1";
+    for (size_t chunk = 1; chunk <= text.size(); ++chunk) {
+        cells_sink sink;
+        pio::table_parser p(sink, "1", ", ");
+        EXPECTED(feed(p, text, chunk)) << p.error_msg() << std::endl;
+        EXPECTED(sink.cells == glider) << "chunk " << chunk << std::endl;
+    }
+
+    cells_sink sink;
+    pio::table_parser bad(sink, "*", " ");
+    EXPECTED(! feed(bad, "- * -\n- -\n", 4));
+    EXPECTED(bad.error_msg() == "line 2: expected 3 cells, got 2") << bad.error_msg() << std::endl;
+
+    std::istringstream in("- * -\n- - *\n* * *\n");
+    cells_sink stream_sink;
+    pio::table_parser from_stream(stream_sink, "*", " ");
+    EXPECTED(from_stream.parse(in)) << from_stream.error_msg() << std::endl;
+    EXPECTED(stream_sink.cells == glider);
+
+    pio::table_parser missing(sink, "*", " ");
+    EXPECTED(! missing.parse_file("/nonexistent/pattern"));
+}
+
+TEST(pattern_io, mapped_file)
+{
+    const std::string text = "#N Glider\nx = 3, y = 3\nbo$2bo$3o!\n";
+    const std::string path = temp_file(text);
+    const unsigned all_hints = pio::mapped_file::populate | pio::mapped_file::sequential
+                               | pio::mapped_file::huge_pages;
+    for (unsigned hints = 0; hints <= all_hints; ++hints) {
+        cells_sink sink;
+        pio::rle_parser p(sink);
+        EXPECTED(p.parse_file(path, hints)) << p.error_msg() << std::endl;
+        EXPECTED(sink.cells == glider) << "hints " << hints << std::endl;
+    }
+
+    pio::mapped_file file;
+    EXPECTED(file.open(path, all_hints)) << file.error_msg() << std::endl;
+    EXPECTED(file.size() == text.size() && std::string(file.data(), file.size()) == text);
+    file.release(0, file.size());
+    EXPECTED(std::string(file.data(), file.size()) == text);
+    file.close();
+    EXPECTED(! file.is_open() && (file.data() == nullptr));
+    std::remove(path.c_str());
+
+    const std::string empty_path = temp_file("");
+    EXPECTED(file.open(empty_path) && (file.size() == 0));
+    cells_sink sink;
+    pio::cells_parser empty(sink);
+    EXPECTED(empty.parse_file(empty_path) && sink.cells.empty());
+    std::remove(empty_path.c_str());
+
+    EXPECTED(! file.open("/nonexistent/pattern") && ! file.error_msg().empty());
+
+    unsigned hints = 0;
+    EXPECTED(pio::load_hints_from_string("populate,hugepages", hints));
+    EXPECTED(hints == (pio::mapped_file::populate | pio::mapped_file::huge_pages));
+    EXPECTED(pio::load_hints_from_string("none", hints) && (hints == pio::mapped_file::none));
+    EXPECTED(! pio::load_hints_from_string("sequential,fast", hints));
+}
+
+TEST(pattern_io, snapshot)
+{
+    life::bit_grid grid(70, 130);
+    for (size_t r = 0; r < grid.row_count(); ++r) {
+        grid.set_run(r, (r * 7) % 130, r);
+    }
+
+    const std::string path = temp_file("");
+    pio::snapshot out;
+    out.set_generation(123456789);
+    out.set_rule("B36/S23");
+    EXPECTED(out.save(path, grid)) << out.error_msg() << std::endl;
+    EXPECTED(access((path + ".tmp").c_str(), F_OK) != 0);
+
+    pio::snapshot in;
+    life::bit_grid restored;
+    EXPECTED(in.load(path, restored)) << in.error_msg() << std::endl;
+    EXPECTED((restored == grid) && (in.generation() == 123456789) && (in.rule() == "B36/S23"));
+
+    // A flipped bit and a lost tail are both caught.
+    std::string data;
+    {
+        std::ifstream file(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    std::string corrupted = data;
+    corrupted[corrupted.size() / 2] ^= 4;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << corrupted;
+    EXPECTED(! in.load(path, restored) && (in.error_msg().find("checksum") != std::string::npos));
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << data.substr(0, data.size() - 8);
+    EXPECTED(! in.load(path, restored)) << in.error_msg() << std::endl;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "x = 3, y = 3\nbo$2bo$3o!\n";
+    EXPECTED(! in.load(path, restored) && (in.error_msg().find("not a snapshot") != std::string::npos));
+
+    // An empty board has no data words to checksum, a header alone claiming
+    // a huge board is refused before anything is allocated.
+    EXPECTED(out.save(path, life::bit_grid()));
+    {
+        std::ifstream file(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    EXPECTED(in.load(path, restored) && (restored.row_count() == 0));
+    for (const std::pair<uint64_t, uint64_t>& size : {std::make_pair(uint64_t(0), uint64_t(1) << 62),
+                                                     std::make_pair(uint64_t(0), ~uint64_t(0)),
+                                                     std::make_pair(uint64_t(1) << 40, uint64_t(64))}) {
+        corrupted = data;
+        std::memcpy(&corrupted[16], &size.first, sizeof(size.first));
+        std::memcpy(&corrupted[24], &size.second, sizeof(size.second));
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << corrupted;
+        EXPECTED(! in.load(path, restored) && (in.error_msg().find("corrupted header") != std::string::npos))
+            << in.error_msg() << std::endl;
+    }
+    std::remove(path.c_str());
+
+    EXPECTED(! in.load("/nonexistent/snapshot", restored));
+    EXPECTED(! out.save("/nonexistent/snapshot", grid));
+}
+
+TEST(pattern_io, generation_log)
+{
+    // A board that changes a few cells per generation, with a gap in the
+    // written generations.
+    std::mt19937 gen(7);
+    std::vector<life::bit_grid> boards;
+    std::vector<uint64_t> generations;
+    life::bit_grid grid(37, 150);
+    for (uint64_t g = 5; g < 230; g += (g == 100) ? 10 : 1) {
+        for (int i = 0; i < 20; ++i) {
+            const size_t r = gen() % grid.row_count();
+            const size_t c = gen() % grid.col_count();
+            grid.set(r, c, ! grid.get(r, c));
+        }
+        boards.push_back(grid);
+        generations.push_back(g);
+    }
+
+    for (const char* name : {"none", "zlib"}) {
+        pio::compression_t compression;
+        EXPECTED(pio::compression_from_string(name, compression));
+        if (! pio::has_compression(compression)) {
+            continue;
+        }
+
+        const std::string path = temp_file("");
+        pio::log_writer out;
+        EXPECTED(out.open(path, 37, 150, "B3/S23", 16, compression)) << out.error_msg() << std::endl;
+        for (size_t i = 0; i < boards.size(); ++i) {
+            EXPECTED(out.write(boards[i], generations[i])) << out.error_msg() << std::endl;
+        }
+        EXPECTED(out.close()) << out.error_msg() << std::endl;
+
+        std::string data;
+        {
+            std::ifstream file(path, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        EXPECTED(data.size() < boards.size() * 37 * 3 * 8) << name << " " << data.size() << std::endl;
+
+        // A log without its index, or cut in the middle of a record, is read
+        // by walking the records.
+        for (const size_t cut : {size_t(0), size_t(16), size_t(1000)}) {
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << data.substr(0, data.size() - cut);
+            pio::log_reader in;
+            EXPECTED(in.open(path)) << in.error_msg() << std::endl;
+            EXPECTED((in.row_count() == 37) && (in.col_count() == 150) && (in.rule() == "B3/S23"));
+            EXPECTED((in.compression() == compression) && (in.first_generation() == 5));
+            if (cut < 1000) {
+                EXPECTED((in.frame_count() == boards.size()) && (in.last_generation() == generations.back()));
+            } else {
+                EXPECTED((in.frame_count() > 0) && (in.frame_count() < boards.size()));
+            }
+
+            life::bit_grid restored;
+            for (size_t i = 0; i < in.frame_count(); ++i) {
+                EXPECTED(in.next(restored) && (in.generation() == generations[i]) && (restored == boards[i]))
+                        << name << " frame " << i << " " << in.error_msg() << std::endl;
+            }
+            EXPECTED(! in.next(restored));
+
+            for (const size_t i : {size_t(150), size_t(0), size_t(17), size_t(18), size_t(95), size_t(96),
+                                   size_t(in.frame_count() - 1), size_t(3)}) {
+                EXPECTED(in.seek(generations[i], restored) && (restored == boards[i]))
+                        << name << " seek " << generations[i] << " " << in.error_msg() << std::endl;
+            }
+            EXPECTED(! in.seek(105, restored) && ! in.seek(4, restored) && ! in.seek(generations.back() + 1, restored));
+        }
+
+        // A flipped bit in the generation or the payload of the first record.
+        for (const size_t pos : {size_t(128 + 1), size_t(128 + 24 + 2)}) {
+            std::string corrupted = data;
+            corrupted[pos] ^= 4;
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << corrupted;
+            pio::log_reader in;
+            life::bit_grid restored;
+            EXPECTED(in.open(path) && ! in.next(restored)) << name << std::endl;
+            EXPECTED(in.error_msg().find("checksum") != std::string::npos) << in.error_msg() << std::endl;
+        }
+
+        // Dimensions of a board that can not be in the file are refused
+        // before anything is allocated.
+        for (const std::pair<uint64_t, uint64_t>& size : {std::make_pair(uint64_t(1) << 40, uint64_t(150)),
+                                                         std::make_pair(uint64_t(37), ~uint64_t(0)),
+                                                         std::make_pair(uint64_t(1) << 24, uint64_t(1) << 24)}) {
+            std::string corrupted = data;
+            std::memcpy(&corrupted[16], &size.first, sizeof(size.first));
+            std::memcpy(&corrupted[24], &size.second, sizeof(size.second));
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << corrupted;
+            pio::log_reader in;
+            EXPECTED(! in.open(path) && (in.error_msg().find("corrupted header") != std::string::npos))
+                << name << " " << in.error_msg() << std::endl;
+        }
+        std::remove(path.c_str());
+    }
+
+    const std::string path = temp_file("");
+    pio::log_writer out;
+    EXPECTED(! out.open(path, 37, 150, "B3/S23", 0));
+    EXPECTED(out.open(path, 37, 150, "B3/S23", 16));
+    EXPECTED(out.write(boards[1], 10) && ! out.write(boards[2], 10));
+    EXPECTED(! out.write(boards[2], 11) && ! out.close());
+    EXPECTED(out.open(path, 37, 150, "B3/S23", 16) && ! out.write(life::bit_grid(37, 151), 1));
+    std::remove(path.c_str());
+
+    pio::log_reader in;
+    EXPECTED(! in.open("/nonexistent/log"));
+    EXPECTED(! out.open("/nonexistent/log", 37, 150, "B3/S23", 16));
+}
+
+TEST(pattern_io, grid_sink)
+{
+    life::bit_grid grid(4, 130);
+    pio::grid_sink sink(grid, -1, 2);
+    sink.on_cells(-1, 0, 10);
+    sink.on_cells(0, 0, 3);
+    sink.on_cells(1, 60, 100);
+    sink.on_cells(2, 64, 1);
+    sink.on_cells(3, 200, 5);
+
+    EXPECTED(grid.get(1, 0) && ! grid.get(1, 1));
+    for (size_t c = 58; c < 130; ++c) {
+        EXPECTED(grid.get(2, c)) << "col " << c << std::endl;
+    }
+    EXPECTED(! grid.get(2, 57));
+    EXPECTED(grid.get(0, 7) && ! grid.get(0, 8));
+    EXPECTED(grid.get(3, 62) && (grid.population() == 8 + 1 + 72 + 1));
+    EXPECTED((grid.row_ptr(2)[2] & ~grid.last_word_mask()) == 0);
+
+    for (size_t col = 0; col < 130; ++col) {
+        for (const size_t count : {1, 5, 63, 64, 65, 200}) {
+            life::bit_grid run(1, 130);
+            run.set_run(0, col, count);
+            EXPECTED(run.population() == std::min(count, 130 - col)) << col << " " << count << std::endl;
+            EXPECTED(run.get(0, col) && ((col == 0) || ! run.get(0, col - 1)));
+        }
+    }
+
+    pio::rle_parser p(sink);
+    EXPECTED(feed(p, "x = 2, y = 1, rule = B36/S23\n2o!", 64));
+    EXPECTED(sink.pattern_header().rule == "B36/S23");
+}
+
+int main()
+{
+    return RUN_TESTS();
+}